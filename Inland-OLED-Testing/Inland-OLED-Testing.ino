@@ -36,10 +36,19 @@
  *   - Hardware SPI is faster but pins are fixed (except CS/DC/RES)
  *   - u8g2.begin() doesn't verify display is connected; it just sends init blindly
  * 
+ * BENCHMARK MODE:
+ *   Send 'b' over serial (or set BENCHMARK_ON_BOOT) to time every test on
+ *   four display backends in one run: SW SPI and HW SPI, each with a full
+ *   frame buffer (_F_) and a single page buffer (_1_). HW SPI is routed to
+ *   the SW SPI pins through the ESP32 GPIO matrix, so no rewiring is needed.
+ *   Per test and backend it reports clearBuffer/draw/sendBuffer time, FPS
+ *   and p50/p95/p99/max frame times.
+ * 
  * ============================================================================
  */
 
 #include <Arduino.h>
+#include <SPI.h>
 #include <U8g2lib.h>
 
 // =========================
@@ -61,6 +70,11 @@ U8G2_SH1106_128X64_NONAME_F_4W_SW_SPI u8g2(U8G2_R0, PIN_CLK, PIN_MOSI, PIN_CS, P
 // Hardware SPI alternative (uncomment to use, rewire accordingly):
 // U8G2_SH1106_128X64_NONAME_F_4W_HW_SPI u8g2(U8G2_R0, /*cs=*/ 22, /*dc=*/ 21, /*reset=*/ 4);
 
+// Benchmark-only backends on the same pins (HW SPI remapped via SPI.begin)
+U8G2_SH1106_128X64_NONAME_1_4W_SW_SPI u8g2SwPage(U8G2_R0, PIN_CLK, PIN_MOSI, PIN_CS, PIN_DC, PIN_RES);
+U8G2_SH1106_128X64_NONAME_F_4W_HW_SPI u8g2HwFull(U8G2_R0, PIN_CS, PIN_DC, PIN_RES);
+U8G2_SH1106_128X64_NONAME_1_4W_HW_SPI u8g2HwPage(U8G2_R0, PIN_CS, PIN_DC, PIN_RES);
+
 // If display doesn't work, try SSD1306 driver:
 // U8G2_SSD1306_128X64_NONAME_F_4W_SW_SPI u8g2(U8G2_R0, PIN_CLK, PIN_MOSI, PIN_CS, PIN_DC, PIN_RES);
 
@@ -70,10 +84,20 @@ U8G2_SH1106_128X64_NONAME_F_4W_SW_SPI u8g2(U8G2_R0, PIN_CLK, PIN_MOSI, PIN_CS, P
 #define TEST_DURATION_MS 2500
 #define NUM_TESTS 7
 
+// Benchmark: frames timed per test per backend
+#define BENCH_FRAMES 60
+#define BENCHMARK_ON_BOOT false
+
 int currentTest = 0;
 unsigned long lastSwitch = 0;
 int frameCount = 0;
 
+const char* testNames[NUM_TESTS] = {
+  "Splash", "Text Sizes", "Shapes", "Animation", "Pixel Pattern", "Info", "Contrast"
+};
+
+void runBenchmark();
+
 // =========================
 // SETUP
 // =========================
@@ -98,6 +122,12 @@ void setup() {
   Serial.println("Initializing display...");
   u8g2.begin();
   Serial.println("Display initialized (no ACK available)");
+  
+  if (BENCHMARK_ON_BOOT) {
+    runBenchmark();
+  }
+  
+  Serial.println("Send 'b' to run the display benchmark");
   Serial.println("Starting test cycle...\n");
   
   lastSwitch = millis();
@@ -107,143 +137,281 @@ void setup() {
 // TEST SCREENS
 // =========================
 
-void testSplash() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB10_tr);
-  u8g2.drawStr(20, 25, "INLAND");
-  u8g2.drawStr(28, 45, "1.3\" OLED");
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(25, 60, "Test Suite");
-  u8g2.sendBuffer();
+void drawSplash(U8G2 &d) {
+  d.setFont(u8g2_font_ncenB10_tr);
+  d.drawStr(20, 25, "INLAND");
+  d.drawStr(28, 45, "1.3\" OLED");
+  d.setFont(u8g2_font_ncenB08_tr);
+  d.drawStr(25, 60, "Test Suite");
 }
 
-void testTextSizes() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_5x7_tr);
-  u8g2.drawStr(0, 8, "5x7: The quick brown fox");
-  u8g2.setFont(u8g2_font_6x10_tr);
-  u8g2.drawStr(0, 20, "6x10: Hello World");
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(0, 33, "ncenB08: Testing");
-  u8g2.setFont(u8g2_font_ncenB12_tr);
-  u8g2.drawStr(0, 50, "ncenB12: Big");
-  u8g2.setFont(u8g2_font_ncenB14_tr);
-  u8g2.drawStr(0, 64, "ncenB14");
-  u8g2.sendBuffer();
+void drawTextSizes(U8G2 &d) {
+  d.setFont(u8g2_font_5x7_tr);
+  d.drawStr(0, 8, "5x7: The quick brown fox");
+  d.setFont(u8g2_font_6x10_tr);
+  d.drawStr(0, 20, "6x10: Hello World");
+  d.setFont(u8g2_font_ncenB08_tr);
+  d.drawStr(0, 33, "ncenB08: Testing");
+  d.setFont(u8g2_font_ncenB12_tr);
+  d.drawStr(0, 50, "ncenB12: Big");
+  d.setFont(u8g2_font_ncenB14_tr);
+  d.drawStr(0, 64, "ncenB14");
 }
 
-void testShapes() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_5x7_tr);
-  u8g2.drawStr(0, 7, "Shapes:");
+void drawShapes(U8G2 &d) {
+  d.setFont(u8g2_font_5x7_tr);
+  d.drawStr(0, 7, "Shapes:");
   
   // Rectangle
-  u8g2.drawFrame(5, 12, 30, 20);
-  u8g2.drawBox(10, 17, 10, 10);
+  d.drawFrame(5, 12, 30, 20);
+  d.drawBox(10, 17, 10, 10);
   
   // Circle
-  u8g2.drawCircle(55, 22, 10);
-  u8g2.drawDisc(55, 22, 5);
+  d.drawCircle(55, 22, 10);
+  d.drawDisc(55, 22, 5);
   
   // Triangle
-  u8g2.drawTriangle(85, 32, 95, 12, 105, 32);
+  d.drawTriangle(85, 32, 95, 12, 105, 32);
   
   // Lines
-  u8g2.drawLine(0, 40, 127, 40);
-  u8g2.drawLine(0, 45, 127, 55);
-  u8g2.drawLine(0, 55, 127, 45);
+  d.drawLine(0, 40, 127, 40);
+  d.drawLine(0, 45, 127, 55);
+  d.drawLine(0, 55, 127, 45);
   
   // Rounded rect
-  u8g2.drawRFrame(80, 45, 45, 18, 5);
-  
-  u8g2.sendBuffer();
+  d.drawRFrame(80, 45, 45, 18, 5);
 }
 
-void testAnimation() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(30, 12, "Animation");
+void drawAnimation(U8G2 &d) {
+  d.setFont(u8g2_font_ncenB08_tr);
+  d.drawStr(30, 12, "Animation");
   
   // Bouncing ball
   int x = 64 + sin(frameCount * 0.1) * 50;
   int y = 40 + cos(frameCount * 0.15) * 15;
-  u8g2.drawDisc(x, y, 8);
+  d.drawDisc(x, y, 8);
   
   // Spinning line
   int x2 = 64 + cos(frameCount * 0.2) * 20;
   int y2 = 40 + sin(frameCount * 0.2) * 20;
-  u8g2.drawLine(64, 40, x2, y2);
+  d.drawLine(64, 40, x2, y2);
   
   // Progress bar
   int progress = (frameCount * 3) % 128;
-  u8g2.drawFrame(0, 55, 128, 8);
-  u8g2.drawBox(1, 56, progress, 6);
-  
-  u8g2.sendBuffer();
+  d.drawFrame(0, 55, 128, 8);
+  d.drawBox(1, 56, progress, 6);
 }
 
-void testPixelPattern() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_5x7_tr);
-  u8g2.drawStr(35, 7, "Pixel Test");
+void drawPixelPattern(U8G2 &d) {
+  d.setFont(u8g2_font_5x7_tr);
+  d.drawStr(35, 7, "Pixel Test");
   
   // Checkerboard
   for (int x = 0; x < 64; x += 2) {
     for (int y = 12; y < 44; y += 2) {
       if ((x + y) % 4 == 0) {
-        u8g2.drawPixel(x, y);
+        d.drawPixel(x, y);
       }
     }
   }
   
-  // Gradient-ish dither
+  // Gradient-ish dither (seeded per frame so every page of a
+  // page-buffer render sees the same pattern)
+  randomSeed(frameCount);
   for (int x = 64; x < 128; x++) {
     for (int y = 12; y < 44; y++) {
       if (random(100) < (x - 64)) {
-        u8g2.drawPixel(x, y);
+        d.drawPixel(x, y);
       }
     }
   }
   
   // Resolution reminder
-  u8g2.drawStr(25, 55, "128 x 64 pixels");
-  u8g2.sendBuffer();
+  d.drawStr(25, 55, "128 x 64 pixels");
 }
 
-void testInfo() {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_5x7_tr);
-  
-  u8g2.drawStr(0, 8,  "Driver: SH1106");
-  u8g2.drawStr(0, 18, "Resolution: 128x64");
-  u8g2.drawStr(0, 28, "Interface: SPI (SW)");
-  u8g2.drawStr(0, 38, "VCC: 5V required");
-  u8g2.drawStr(0, 48, "Logic: 3.3V (ESP32)");
+void drawInfo(U8G2 &d) {
+  d.setFont(u8g2_font_5x7_tr);
   
-  u8g2.drawFrame(0, 52, 128, 12);
-  u8g2.drawStr(4, 62, "microcenter.com #643965");
+  d.drawStr(0, 8,  "Driver: SH1106");
+  d.drawStr(0, 18, "Resolution: 128x64");
+  d.drawStr(0, 28, "Interface: SPI (SW)");
+  d.drawStr(0, 38, "VCC: 5V required");
+  d.drawStr(0, 48, "Logic: 3.3V (ESP32)");
   
-  u8g2.sendBuffer();
+  d.drawFrame(0, 52, 128, 12);
+  d.drawStr(4, 62, "microcenter.com #643965");
+}
+
+// Cycles with the frame count to show contrast works
+int contrastLevel() {
+  return (frameCount * 5) % 256;
 }
 
-void testContrast() {
-  // Cycle contrast to show it works
-  static int contrast = 0;
-  contrast = (contrast + 5) % 256;
-  u8g2.setContrast(contrast);
+// Only draws - the contrast itself is set by applyTestSettings(), outside
+// the timed draw (and once per frame, not once per page)
+void drawContrast(U8G2 &d) {
+  int contrast = contrastLevel();
   
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.drawStr(15, 25, "Contrast Test");
+  d.setFont(u8g2_font_ncenB08_tr);
+  d.drawStr(15, 25, "Contrast Test");
   
   char buf[20];
   sprintf(buf, "Level: %d/255", contrast);
-  u8g2.drawStr(25, 45, buf);
+  d.drawStr(25, 45, buf);
   
-  u8g2.drawFrame(14, 50, 100, 10);
-  u8g2.drawBox(14, 50, (contrast * 100) / 255, 10);
+  d.drawFrame(14, 50, 100, 10);
+  d.drawBox(14, 50, (contrast * 100) / 255, 10);
+}
+
+// Display commands a test needs before its frame is drawn
+void applyTestSettings(U8G2 &d, int test) {
+  if (test == 6) {
+    d.setContrast(contrastLevel());
+  }
+}
+
+void drawTest(U8G2 &d, int test) {
+  switch (test) {
+    case 0: drawSplash(d); break;
+    case 1: drawTextSizes(d); break;
+    case 2: drawShapes(d); break;
+    case 3: drawAnimation(d); break;
+    case 4: drawPixelPattern(d); break;
+    case 5: drawInfo(d); break;
+    case 6: drawContrast(d); break;
+  }
+}
+
+// =========================
+// BENCHMARK
+// =========================
+
+struct FrameTiming {
+  uint32_t clearUs;
+  uint32_t drawUs;
+  uint32_t sendUs;
+};
+
+uint32_t frameTotals[BENCH_FRAMES];
+
+// Full buffer: clearBuffer, draw, sendBuffer are separate steps
+FrameTiming timeFullBufferFrame(U8G2 &d, int test) {
+  FrameTiming t;
+  applyTestSettings(d, test);
+  uint32_t t0 = micros();
+  d.clearBuffer();
+  uint32_t t1 = micros();
+  drawTest(d, test);
+  uint32_t t2 = micros();
+  d.sendBuffer();
+  uint32_t t3 = micros();
+  t.clearUs = t1 - t0;
+  t.drawUs = t2 - t1;
+  t.sendUs = t3 - t2;
+  return t;
+}
+
+// Page buffer: the draw callback runs once per page, and nextPage() clears
+// and transfers each page, so clear time is folded into send time
+FrameTiming timePageBufferFrame(U8G2 &d, int test) {
+  FrameTiming t = {0, 0, 0};
+  applyTestSettings(d, test);
+  uint32_t start = micros();
+  d.firstPage();
+  do {
+    uint32_t drawStart = micros();
+    drawTest(d, test);
+    t.drawUs += micros() - drawStart;
+  } while (d.nextPage());
+  t.sendUs = (micros() - start) - t.drawUs;
+  return t;
+}
+
+int compareU32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+uint32_t percentile(const uint32_t* sorted, int n, int pct) {
+  int idx = (pct * (n - 1) + 50) / 100;
+  return sorted[idx];
+}
+
+void benchmarkBackend(const char* name, U8G2 &d, bool pageMode) {
+  Serial.printf("\n--- %s ---\n", name);
+  Serial.println("Test           clear   draw    send  |  FPS    p50    p95    p99    max (us)");
   
-  u8g2.sendBuffer();
+  for (int test = 0; test < NUM_TESTS; test++) {
+    uint64_t clearSum = 0, drawSum = 0, sendSum = 0;
+    
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+      FrameTiming t = pageMode ? timePageBufferFrame(d, test) : timeFullBufferFrame(d, test);
+      frameTotals[i] = t.clearUs + t.drawUs + t.sendUs;
+      clearSum += t.clearUs;
+      drawSum += t.drawUs;
+      sendSum += t.sendUs;
+      frameCount++;
+      yield();
+    }
+    
+    qsort(frameTotals, BENCH_FRAMES, sizeof(uint32_t), compareU32);
+    uint32_t avgFrame = (clearSum + drawSum + sendSum) / BENCH_FRAMES;
+    float fps = avgFrame > 0 ? 1000000.0f / avgFrame : 0;
+    
+    Serial.printf("%-13s %6lu %6lu %7lu  | %5.1f %6lu %6lu %6lu %6lu\n",
+                  testNames[test],
+                  (unsigned long)(clearSum / BENCH_FRAMES),
+                  (unsigned long)(drawSum / BENCH_FRAMES),
+                  (unsigned long)(sendSum / BENCH_FRAMES),
+                  fps,
+                  (unsigned long)percentile(frameTotals, BENCH_FRAMES, 50),
+                  (unsigned long)percentile(frameTotals, BENCH_FRAMES, 95),
+                  (unsigned long)percentile(frameTotals, BENCH_FRAMES, 99),
+                  (unsigned long)frameTotals[BENCH_FRAMES - 1]);
+  }
+  
+  // Leave the panel at full contrast for the next backend
+  d.setContrast(255);
+}
+
+void runBenchmark() {
+  Serial.println();
+  Serial.println("================================");
+  Serial.println("OLED Benchmark");
+  Serial.println("================================");
+  Serial.printf("%d frames per test, times in microseconds\n", BENCH_FRAMES);
+  
+  digitalWrite(PIN_LED, HIGH);
+  
+  // SW SPI first - once the SPI peripheral owns the pins, bit-banging
+  // would need them detached again
+  benchmarkBackend("SW SPI, full buffer (_F_)", u8g2, false);
+  
+  u8g2SwPage.begin();
+  benchmarkBackend("SW SPI, page buffer (_1_)", u8g2SwPage, true);
+  
+  // Route the VSPI peripheral to the SW SPI wiring before U8g2 calls
+  // SPI.begin() with default pins (it's a no-op once initialized)
+  SPI.begin(PIN_CLK, -1, PIN_MOSI, PIN_CS);
+  
+  u8g2HwFull.begin();
+  benchmarkBackend("HW SPI, full buffer (_F_)", u8g2HwFull, false);
+  
+  u8g2HwPage.begin();
+  benchmarkBackend("HW SPI, page buffer (_1_)", u8g2HwPage, true);
+  
+  // Hand the pins back to the SW SPI display used by the test cycle
+  SPI.end();
+  u8g2.begin();
+  
+  digitalWrite(PIN_LED, LOW);
+  Serial.println();
+  Serial.println("Benchmark complete");
+  Serial.println("================================\n");
+  
+  lastSwitch = millis();
 }
 
 // =========================
@@ -255,17 +423,18 @@ void loop() {
   // Heartbeat LED
   digitalWrite(PIN_LED, (now / 250) % 2);
   
-  // Run current test
-  switch (currentTest) {
-    case 0: testSplash(); break;
-    case 1: testTextSizes(); break;
-    case 2: testShapes(); break;
-    case 3: testAnimation(); break;
-    case 4: testPixelPattern(); break;
-    case 5: testInfo(); break;
-    case 6: testContrast(); break;
+  // Benchmark on request
+  if (Serial.available() && Serial.read() == 'b') {
+    runBenchmark();
+    return;
   }
   
+  // Run current test
+  applyTestSettings(u8g2, currentTest);
+  u8g2.clearBuffer();
+  drawTest(u8g2, currentTest);
+  u8g2.sendBuffer();
+  
   frameCount++;
   
   // Switch tests periodically
@@ -278,16 +447,7 @@ void loop() {
       u8g2.setContrast(255);
     }
     
-    Serial.printf("Test %d/%d: ", currentTest + 1, NUM_TESTS);
-    switch (currentTest) {
-      case 0: Serial.println("Splash"); break;
-      case 1: Serial.println("Text Sizes"); break;
-      case 2: Serial.println("Shapes"); break;
-      case 3: Serial.println("Animation"); break;
-      case 4: Serial.println("Pixel Pattern"); break;
-      case 5: Serial.println("Info"); break;
-      case 6: Serial.println("Contrast"); break;
-    }
+    Serial.printf("Test %d/%d: %s\n", currentTest + 1, NUM_TESTS, testNames[currentTest]);
   }
   
   // Small delay - animation test needs fast updates
@@ -0,0 +1,267 @@
+/*
+ * Sensor-inferred AC Confirmation
+ *
+ * For installs without a fan node (see fan_link.h): after an on/off
+ * command, watch the SCD41's own readings for the room responding and
+ * end retransmission once that's convincing enough.
+ *
+ * Turning the AC on should make, within a few minutes:
+ *   - temperature fall (cool / dry)
+ *   - humidity fall (cool / dry)
+ *   - CO2 fall (fan / any mode that moves air)
+ * Turning it off reverses each of these. Fan mode moves air without
+ * cooling, so a fan-mode window (ventilation) only has CO2 to go on and
+ * weighs it alone.
+ *
+ * The sketch samples at the sensor's native 5 s cadence while a window is
+ * open. The first AC_CONFIRM_BASELINE_SAMPLES readings form the baseline;
+ * after that each reading compares the median of the last three against
+ * it. Each signal contributes its share of the confidence once it has
+ * moved the full expected amount in the expected direction. Passing
+ * AC_CONFIRM_THRESHOLD ends the window as confirmed; reaching
+ * AC_CONFIRM_TIMEOUT_MS ends it as escalated.
+ *
+ * Usage:
+ *   1. acConfirmInit(onEnd) in setup() - onEnd(on, confirmed) is called
+ *      when a window ends
+ *   2. acConfirmStart(on, fanMode) right after the command is queued -
+ *      fanMode when the target is fan mode or off from it
+ *   3. While acConfirmActive(), read the sensor every AC_CONFIRM_SAMPLE_MS
+ *      and pass each reading to acConfirmSample()
+ *   4. acConfirmPoll() every loop pass (timeout)
+ *   5. acConfirmCancel() if something else confirmed it first
+ */
+
+#ifndef AC_CONFIRM_H
+#define AC_CONFIRM_H
+
+#include <Arduino.h>
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define AC_CONFIRM_SAMPLE_MS      5000      // SCD41 periodic mode update rate
+#define AC_CONFIRM_TIMEOUT_MS     300000UL  // 5 minutes
+#define AC_CONFIRM_BASELINE_SAMPLES 2
+#define AC_CONFIRM_MIN_SAMPLES    6         // Don't decide in the first 30s
+
+// Change from baseline that counts as full evidence
+#define AC_CONFIRM_TEMP_DROP_C    0.5
+#define AC_CONFIRM_RH_DROP_PCT    2.0
+#define AC_CONFIRM_CO2_DROP_PPM   40.0
+
+// Weights (sum to 1.0) and the confidence needed to confirm
+#define AC_CONFIRM_WEIGHT_TEMP    0.4
+#define AC_CONFIRM_WEIGHT_RH      0.3
+#define AC_CONFIRM_WEIGHT_CO2     0.3
+#define AC_CONFIRM_THRESHOLD      0.6
+
+// Fan mode - temperature and humidity don't move, CO2 carries it all
+#define AC_CONFIRM_FAN_WEIGHT_CO2 1.0
+
+// ===========================================
+// Types
+// ===========================================
+
+// Called when a window ends - confirmed is false on timeout (escalate)
+typedef void (*AcConfirmEndFn)(bool on, bool confirmed);
+
+// ===========================================
+// State
+// ===========================================
+
+static AcConfirmEndFn _accOnEnd = nullptr;
+
+static bool _accActive = false;
+static bool _accTarget = false;
+static bool _accFanMode = false;
+static unsigned long _accStartMs = 0;
+static uint16_t _accSamples = 0;
+
+// Baseline accumulated from the first samples
+static float _accBaseTemp = 0, _accBaseRh = 0, _accBaseCO2 = 0;
+
+// Last three samples for the median
+static float _accTemp[3], _accRh[3], _accCO2[3];
+
+static float _accConfidence = 0;
+
+// Stats
+static uint32_t _accWindows = 0;
+static uint32_t _accConfirmed = 0;
+static uint32_t _accEscalated = 0;
+static uint32_t _accCancelled = 0;
+static uint32_t _accSampleCount = 0;
+static uint32_t _accConfirmTotalMs = 0;
+static uint32_t _accConfirmMaxMs = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static float _accMedian3(const float* v) {
+    float a = v[0], b = v[1], c = v[2];
+    if (a > b) { float t = a; a = b; b = t; }
+    if (b > c) { float t = b; b = c; c = t; }
+    if (a > b) { float t = a; a = b; b = t; }
+    return b;
+}
+
+// 0..1 - how far `drop` has gone towards `full`
+static float _accEvidence(float drop, float full) {
+    float e = drop / full;
+    if (e < 0) return 0;
+    if (e > 1) return 1;
+    return e;
+}
+
+static void _accEnd(bool confirmed) {
+    _accActive = false;
+    uint32_t elapsed = millis() - _accStartMs;
+
+    Serial.print("[Confirm] ");
+    Serial.print(_accTarget ? "ON" : "OFF");
+    if (confirmed) {
+        _accConfirmed++;
+        _accConfirmTotalMs += elapsed;
+        if (elapsed > _accConfirmMaxMs) _accConfirmMaxMs = elapsed;
+        Serial.print(" inferred from readings after ");
+    } else {
+        _accEscalated++;
+        Serial.print(" not seen in readings after ");
+    }
+    Serial.print(elapsed / 1000);
+    Serial.print("s, confidence ");
+    Serial.println(_accConfidence, 2);
+
+    if (_accOnEnd) _accOnEnd(_accTarget, confirmed);
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void acConfirmInit(AcConfirmEndFn onEnd) {
+    _accOnEnd = onEnd;
+}
+
+// ===========================================
+// Windows
+// ===========================================
+
+void acConfirmStart(bool on, bool fanMode = false) {
+    if (_accActive && _accTarget == on && _accFanMode == fanMode) return;
+    _accActive = true;
+    _accTarget = on;
+    _accFanMode = fanMode;
+    _accStartMs = millis();
+    _accSamples = 0;
+    _accConfidence = 0;
+    _accBaseTemp = _accBaseRh = _accBaseCO2 = 0;
+    _accWindows++;
+
+    Serial.print("[Confirm] Watching readings for AC ");
+    Serial.print(on ? "ON" : "OFF");
+    Serial.println(fanMode ? " (fan mode, CO2 only)" : "");
+}
+
+// Confirmed some other way (fan node) or the command was withdrawn
+void acConfirmCancel() {
+    if (!_accActive) return;
+    _accActive = false;
+    _accCancelled++;
+}
+
+bool acConfirmActive() {
+    return _accActive;
+}
+
+// ===========================================
+// Sample - call with each 5 s reading while active
+// ===========================================
+
+void acConfirmSample(uint16_t co2, float temp, float humidity) {
+    if (!_accActive) return;
+    _accSampleCount++;
+
+    if (_accSamples < AC_CONFIRM_BASELINE_SAMPLES) {
+        _accBaseTemp += temp / AC_CONFIRM_BASELINE_SAMPLES;
+        _accBaseRh += humidity / AC_CONFIRM_BASELINE_SAMPLES;
+        _accBaseCO2 += (float)co2 / AC_CONFIRM_BASELINE_SAMPLES;
+    }
+
+    int slot = _accSamples % 3;
+    _accTemp[slot] = temp;
+    _accRh[slot] = humidity;
+    _accCO2[slot] = co2;
+    _accSamples++;
+
+    if (_accSamples < AC_CONFIRM_MIN_SAMPLES) return;
+
+    // Positive = moved the way the target state should move it
+    float sign = _accTarget ? 1.0 : -1.0;
+    float tempDrop = sign * (_accBaseTemp - _accMedian3(_accTemp));
+    float rhDrop = sign * (_accBaseRh - _accMedian3(_accRh));
+    float co2Drop = sign * (_accBaseCO2 - _accMedian3(_accCO2));
+
+    if (_accFanMode) {
+        _accConfidence = AC_CONFIRM_FAN_WEIGHT_CO2 * _accEvidence(co2Drop, AC_CONFIRM_CO2_DROP_PPM);
+    } else {
+        _accConfidence = AC_CONFIRM_WEIGHT_TEMP * _accEvidence(tempDrop, AC_CONFIRM_TEMP_DROP_C) +
+                         AC_CONFIRM_WEIGHT_RH * _accEvidence(rhDrop, AC_CONFIRM_RH_DROP_PCT) +
+                         AC_CONFIRM_WEIGHT_CO2 * _accEvidence(co2Drop, AC_CONFIRM_CO2_DROP_PPM);
+    }
+
+    if (_accConfidence >= AC_CONFIRM_THRESHOLD) {
+        _accEnd(true);
+    }
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void acConfirmPoll() {
+    if (_accActive && millis() - _accStartMs >= AC_CONFIRM_TIMEOUT_MS) {
+        _accEnd(false);
+    }
+}
+
+// ===========================================
+// Status / stats
+// ===========================================
+
+float acConfirmConfidence() {
+    return _accConfidence;
+}
+
+void acConfirmPrintStats() {
+    Serial.print("Sensor confirmation: ");
+    if (_accActive) {
+        Serial.print("watching for ");
+        Serial.print(_accTarget ? "ON" : "OFF");
+        if (_accFanMode) Serial.print(" (fan mode)");
+        Serial.print(", confidence ");
+        Serial.print(_accConfidence, 2);
+        Serial.print(", ");
+    }
+    Serial.print(_accWindows);
+    Serial.print(" windows, ");
+    Serial.print(_accConfirmed);
+    Serial.print(" confirmed, ");
+    Serial.print(_accEscalated);
+    Serial.print(" escalated, ");
+    Serial.print(_accCancelled);
+    Serial.println(" confirmed elsewhere");
+
+    Serial.print("  Time to confirm: avg ");
+    Serial.print(_accConfirmed > 0 ? _accConfirmTotalMs / _accConfirmed / 1000 : 0);
+    Serial.print("s, max ");
+    Serial.print(_accConfirmMaxMs / 1000);
+    Serial.print("s, ");
+    Serial.print(_accSampleCount);
+    Serial.println(" fast samples");
+}
+
+#endif // AC_CONFIRM_H
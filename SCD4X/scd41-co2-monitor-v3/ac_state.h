@@ -0,0 +1,366 @@
+/*
+ * Whynter AC State Model
+ *
+ * The IR link is one-way, so the sketch keeps the state it last told the
+ * AC to be in (power, mode, fan speed, swing) and turns a high-level
+ * target like "cool, fan high" into the fewest commands from Whynter.ir:
+ *
+ *   - Nothing is sent if the target matches the assumed state
+ *   - Power off is the single Ac_Off command
+ *   - Mode and fan speed are one command - every mode/fan signal carries
+ *     the full mode + fan state and also powers the unit on
+ *   - Swing is its own command, sent only when it changes, and only with
+ *     the unit on - a swing change while off is rejected
+ *
+ * Every redundant command avoided is one less beep from the unit.
+ *
+ * Only the mode/fan combinations that were captured can be sent (see
+ * _acCombos). Asking for one that wasn't captured fails with a message
+ * instead of sending something else.
+ *
+ * Signals sent outside the model (serial on/off, spam, "send X") are fed
+ * back through acStateObserve() so the assumed state stays in sync - the
+ * model's own commands too, so the state only changes once a frame has
+ * actually been sent. The assumed state is saved to NVS and restored at
+ * boot.
+ *
+ * Usage:
+ *   1. acStateInit() in setup(), after the IR scheduler
+ *   2. acStateApply("cool, fan high", priority) to change state (force
+ *      re-sends the power/mode command even if the state already matches)
+ *   3. acStateObserve(signal) whenever a signal is transmitted
+ */
+
+#ifndef AC_STATE_H
+#define AC_STATE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "whynter_codes.h"
+#include "ir_scheduler.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define AC_PREFS_NAMESPACE "acstate"
+#define AC_PREFS_VERSION 1
+
+// ===========================================
+// Types
+// ===========================================
+
+enum AcMode {
+    AC_MODE_AUTO = 0,
+    AC_MODE_COOL = 1,
+    AC_MODE_DRY = 2,
+    AC_MODE_HEAT = 3,
+    AC_MODE_FAN = 4
+};
+
+enum AcFan {
+    AC_FAN_AUTO = 0,
+    AC_FAN_LOW = 1,
+    AC_FAN_MED = 2,
+    AC_FAN_HIGH = 3
+};
+
+struct AcState {
+    uint8_t version;
+    bool power;
+    uint8_t mode;    // AcMode
+    uint8_t fan;     // AcFan
+    bool swing;
+};
+
+// Captured mode + fan combinations and the signal that selects each
+struct AcCombo {
+    AcMode mode;
+    AcFan fan;
+    const char* signalName;
+};
+
+static const AcCombo _acCombos[] = {
+    {AC_MODE_AUTO, AC_FAN_AUTO, "Mode_Auto"},
+    {AC_MODE_COOL, AC_FAN_AUTO, "Cool_Auto"},
+    {AC_MODE_COOL, AC_FAN_HIGH, "Cool_High"},
+    {AC_MODE_DRY,  AC_FAN_AUTO, "Mode_Dry"},
+    {AC_MODE_HEAT, AC_FAN_AUTO, "Mode_Heat"},
+    {AC_MODE_FAN,  AC_FAN_AUTO, "Fan_Auto"},
+    {AC_MODE_FAN,  AC_FAN_LOW,  "Fan_Low"},
+    {AC_MODE_FAN,  AC_FAN_MED,  "Fan_Med"},
+    {AC_MODE_FAN,  AC_FAN_HIGH, "Fan_High"},
+};
+#define AC_COMBO_COUNT (sizeof(_acCombos) / sizeof(_acCombos[0]))
+
+// ===========================================
+// State
+// ===========================================
+
+static Preferences _acPrefs;
+static AcState _acState = {AC_PREFS_VERSION, false, AC_MODE_COOL, AC_FAN_AUTO, false};
+static const IrSignal* _acComboSignals[AC_COMBO_COUNT];
+static const IrSignal* _acOffSignal = nullptr;
+static const IrSignal* _acSwingOnSignal = nullptr;
+static const IrSignal* _acSwingOffSignal = nullptr;
+
+// Stats
+static uint32_t _acCommandsSent = 0;
+static uint32_t _acCommandsSkipped = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static const char* _acModeName(uint8_t mode) {
+    switch (mode) {
+        case AC_MODE_AUTO: return "auto";
+        case AC_MODE_COOL: return "cool";
+        case AC_MODE_DRY:  return "dry";
+        case AC_MODE_HEAT: return "heat";
+        default:           return "fan";
+    }
+}
+
+static const char* _acFanName(uint8_t fan) {
+    switch (fan) {
+        case AC_FAN_LOW:  return "low";
+        case AC_FAN_MED:  return "med";
+        case AC_FAN_HIGH: return "high";
+        default:          return "auto";
+    }
+}
+
+static int _acFindCombo(uint8_t mode, uint8_t fan) {
+    for (size_t i = 0; i < AC_COMBO_COUNT; i++) {
+        if (_acCombos[i].mode == mode && _acCombos[i].fan == fan) return i;
+    }
+    return -1;
+}
+
+static void _acSave() {
+    _acPrefs.putBytes("state", &_acState, sizeof(_acState));
+}
+
+static bool _acEnqueue(const IrSignal* signal, IRPriority priority) {
+    if (!signal) return false;
+    if (irSchedEnqueue(signal, priority) == IR_REJECTED) {
+        Serial.print("[AC] Queue full, ");
+        Serial.print(signal->name);
+        Serial.println(" not sent");
+        return false;
+    }
+    Serial.print("[AC] -> ");
+    Serial.println(signal->name);
+    _acCommandsSent++;
+    return true;
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void acStateInit() {
+    for (size_t i = 0; i < AC_COMBO_COUNT; i++) {
+        _acComboSignals[i] = whynterFindSignal(_acCombos[i].signalName);
+        if (!_acComboSignals[i]) {
+            Serial.print("[AC] Missing signal ");
+            Serial.println(_acCombos[i].signalName);
+        }
+    }
+    _acOffSignal = whynterFindSignal("Ac_Off");
+    _acSwingOnSignal = whynterFindSignal("Swing_on");
+    _acSwingOffSignal = whynterFindSignal("Swing_off");
+
+    _acPrefs.begin(AC_PREFS_NAMESPACE, false);
+    AcState saved;
+    if (_acPrefs.getBytes("state", &saved, sizeof(saved)) == sizeof(saved) &&
+        saved.version == AC_PREFS_VERSION && _acFindCombo(saved.mode, saved.fan) >= 0) {
+        _acState = saved;
+        Serial.print("[AC] Restored assumed state: ");
+    } else {
+        Serial.print("[AC] No saved state, assuming: ");
+    }
+    Serial.print(_acState.power ? "on " : "off ");
+    Serial.print(_acModeName(_acState.mode));
+    Serial.print("/");
+    Serial.print(_acFanName(_acState.fan));
+    Serial.println(_acState.swing ? ", swing" : "");
+}
+
+// ===========================================
+// Apply a target
+// Accepts comma/space separated words in any order, e.g.
+//   "off"  "on"  "cool, fan high"  "fan low"  "heat"  "swing on"
+// Mode words imply power on. "fan" alone selects fan mode. Settings that
+// aren't mentioned keep their current value.
+// Returns false if the target couldn't be parsed or wasn't captured.
+// ===========================================
+
+bool acStateApply(const char* target, IRPriority priority, bool force = false) {
+    bool power = _acState.power;
+    int mode = -1, fan = -1, swing = -1;
+
+    char buf[64];
+    strncpy(buf, target, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    const char* prev = "";
+    for (char* word = strtok(buf, " ,"); word; word = strtok(nullptr, " ,")) {
+        bool afterFan = strcasecmp(prev, "fan") == 0;
+        bool afterSwing = strcasecmp(prev, "swing") == 0;
+
+        if (strcasecmp(word, "low") == 0) {
+            fan = AC_FAN_LOW;
+        } else if (strcasecmp(word, "med") == 0 || strcasecmp(word, "medium") == 0) {
+            fan = AC_FAN_MED;
+        } else if (strcasecmp(word, "high") == 0) {
+            fan = AC_FAN_HIGH;
+        } else if (afterFan && strcasecmp(word, "auto") == 0) {
+            fan = AC_FAN_AUTO;
+        } else if (afterSwing && strcasecmp(word, "on") == 0) {
+            swing = 1;
+        } else if (afterSwing && strcasecmp(word, "off") == 0) {
+            swing = 0;
+        } else if (strcasecmp(word, "on") == 0) {
+            power = true;
+        } else if (strcasecmp(word, "off") == 0) {
+            power = false;
+        } else if (strcasecmp(word, "auto") == 0) {
+            mode = AC_MODE_AUTO;
+        } else if (strcasecmp(word, "cool") == 0) {
+            mode = AC_MODE_COOL;
+        } else if (strcasecmp(word, "dry") == 0) {
+            mode = AC_MODE_DRY;
+        } else if (strcasecmp(word, "heat") == 0) {
+            mode = AC_MODE_HEAT;
+        } else if (strcasecmp(word, "fan") == 0 || strcasecmp(word, "swing") == 0) {
+            // Resolved by the next word (or below, if it's the last one)
+        } else {
+            Serial.print("[AC] Unknown word: ");
+            Serial.println(word);
+            return false;
+        }
+        prev = word;
+    }
+
+    // Trailing "fan" with no speed means fan mode; "swing" alone turns it on
+    if (strcasecmp(prev, "fan") == 0) mode = AC_MODE_FAN;
+    if (strcasecmp(prev, "swing") == 0) swing = 1;
+
+    if (mode >= 0) power = true;
+
+    // Swing is only sent with the unit on. Saving it while off would leave
+    // the model out of step with the unit, which never heard the command.
+    if (swing >= 0 && !power) {
+        Serial.println("[AC] Swing needs the AC on - e.g. \"ac on, swing on\"");
+        return false;
+    }
+
+    // Fill in the rest from the current state
+    AcState next = _acState;
+    next.power = power;
+    if (mode >= 0) next.mode = mode;
+    if (fan >= 0) next.fan = fan;
+    if (swing >= 0) next.swing = swing;
+
+    int combo = _acFindCombo(next.mode, next.fan);
+    if (combo < 0) {
+        if (fan >= 0) {
+            Serial.print("[AC] No captured command for ");
+            Serial.print(_acModeName(next.mode));
+            Serial.print(" + fan ");
+            Serial.println(_acFanName(next.fan));
+            return false;
+        }
+        // Fan speed wasn't asked for - use whatever this mode supports
+        next.fan = AC_FAN_AUTO;
+        combo = _acFindCombo(next.mode, next.fan);
+        if (combo < 0) return false;
+    }
+
+    // Minimal delta
+    int sent = 0;
+    if (!next.power) {
+        if (_acState.power || force) {
+            sent += _acEnqueue(_acOffSignal, priority);
+        }
+    } else {
+        if (force || !_acState.power || next.mode != _acState.mode || next.fan != _acState.fan) {
+            sent += _acEnqueue(_acComboSignals[combo], priority);
+        }
+        if (next.swing != _acState.swing) {
+            sent += _acEnqueue(next.swing ? _acSwingOnSignal : _acSwingOffSignal, priority);
+        }
+    }
+
+    if (sent == 0) {
+        _acCommandsSkipped++;
+        Serial.println("[AC] Already in that state, nothing sent");
+    }
+
+    // The assumed state changes when the frames go out (acStateObserve),
+    // not here - a queued command can still be dropped or cancelled
+    return true;
+}
+
+// ===========================================
+// Observe - call with every transmitted signal so sends from outside the
+// model (spam, "send X", on/off) update the assumed state
+// ===========================================
+
+void acStateObserve(const IrSignal* signal) {
+    if (!signal || signal->kind != IR_SIGNAL_WHYNTER) return;
+
+    AcState next = _acState;
+    if (_acOffSignal && signal->whynter == _acOffSignal->whynter) {
+        next.power = false;
+    } else if (_acSwingOnSignal && signal->whynter == _acSwingOnSignal->whynter) {
+        next.swing = true;
+    } else if (_acSwingOffSignal && signal->whynter == _acSwingOffSignal->whynter) {
+        next.swing = false;
+    } else {
+        // Aliases (Ac_On = Mode_Dry, Mode_Cool = Cool_Auto) share frames
+        for (size_t i = 0; i < AC_COMBO_COUNT; i++) {
+            if (_acComboSignals[i] && signal->whynter == _acComboSignals[i]->whynter) {
+                next.power = true;
+                next.mode = _acCombos[i].mode;
+                next.fan = _acCombos[i].fan;
+                break;
+            }
+        }
+    }
+
+    if (memcmp(&next, &_acState, sizeof(next)) != 0) {
+        _acState = next;
+        _acSave();
+    }
+}
+
+// ===========================================
+// Status
+// ===========================================
+
+const AcState& acStateCurrent() {
+    return _acState;
+}
+
+// Short description, e.g. "on cool/high swing"
+void acStateDescribe(char* buf, size_t len) {
+    if (!_acState.power) {
+        snprintf(buf, len, "off");
+        return;
+    }
+    snprintf(buf, len, "on %s/%s%s", _acModeName(_acState.mode),
+             _acFanName(_acState.fan), _acState.swing ? " swing" : "");
+}
+
+uint32_t acStateCommandsSent() {
+    return _acCommandsSent;
+}
+
+uint32_t acStateCommandsSkipped() {
+    return _acCommandsSkipped;
+}
+
+#endif // AC_STATE_H
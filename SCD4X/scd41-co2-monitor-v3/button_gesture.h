@@ -0,0 +1,140 @@
+/*
+ * Button Gesture Decoder
+ *
+ * Turns a debounced button level into short, double and long presses. No
+ * hardware: the caller passes the level and the time, and asks
+ * buttonGestureDeadline() when to step again without an edge. button_input.h
+ * drives it from its debounce timer; the host test in
+ * scd41-co2-monitor-v3/host/ drives it with synthetic timings.
+ *
+ * Gestures:
+ *   BUTTON_SHORT  - released before longMs, no second press within doubleMs
+ *                   (with doubleMs = 0, reported right at release)
+ *   BUTTON_DOUBLE - second press within doubleMs of the first release
+ *   BUTTON_LONG   - held for longMs, reported while still held
+ *
+ * An edge at the same millisecond as a deadline is handled first: a
+ * release exactly at longMs is a short press, and a second press exactly
+ * at doubleMs is a double press.
+ *
+ * Shared by scd41-co2-monitor-v3, whynter-ir-blaster and button_test -
+ * keep the copies identical.
+ *
+ * Usage:
+ *   1. buttonGestureInit(g, longMs, doubleMs)
+ *   2. event = buttonGestureStep(g, pressed, nowMs) on every edge
+ *   3. buttonGestureDeadline(g, deadlineMs) - step again then
+ */
+
+#ifndef BUTTON_GESTURE_H
+#define BUTTON_GESTURE_H
+
+#include <Arduino.h>
+
+// ===========================================
+// Types
+// ===========================================
+
+enum ButtonEvent {
+    BUTTON_NONE = 0,
+    BUTTON_SHORT,
+    BUTTON_DOUBLE,
+    BUTTON_LONG
+};
+
+enum ButtonGestureState {
+    BUTTON_G_IDLE = 0,
+    BUTTON_G_DOWN,          // First press, waiting for release or longMs
+    BUTTON_G_UP,            // Released, waiting for a second press
+    BUTTON_G_HELD           // Reported already, waiting for release
+};
+
+struct ButtonGesture {
+    uint8_t state;          // ButtonGestureState
+    bool pressed;           // Debounced level
+    uint32_t since;         // Time of the last debounced edge
+    uint32_t longMs;
+    uint32_t doubleMs;      // 0 = no double press
+};
+
+// ===========================================
+// Decoder
+// ===========================================
+
+void buttonGestureInit(ButtonGesture &g, uint32_t longMs, uint32_t doubleMs) {
+    g.state = BUTTON_G_IDLE;
+    g.pressed = false;
+    g.since = 0;
+    g.longMs = longMs;
+    g.doubleMs = doubleMs;
+}
+
+ButtonEvent buttonGestureStep(ButtonGesture &g, bool pressed, uint32_t nowMs) {
+    bool edge = pressed != g.pressed;
+    g.pressed = pressed;
+    if (edge) g.since = nowMs;
+    uint32_t elapsed = nowMs - g.since;
+
+    switch (g.state) {
+    case BUTTON_G_IDLE:
+        if (edge && pressed) g.state = BUTTON_G_DOWN;
+        return BUTTON_NONE;
+
+    case BUTTON_G_DOWN:
+        if (edge) {
+            if (g.doubleMs == 0) {
+                g.state = BUTTON_G_IDLE;
+                return BUTTON_SHORT;
+            }
+            g.state = BUTTON_G_UP;
+            return BUTTON_NONE;
+        }
+        if (elapsed >= g.longMs) {
+            g.state = BUTTON_G_HELD;
+            return BUTTON_LONG;
+        }
+        return BUTTON_NONE;
+
+    case BUTTON_G_UP:
+        if (edge) {
+            g.state = BUTTON_G_HELD;
+            return BUTTON_DOUBLE;
+        }
+        if (elapsed >= g.doubleMs) {
+            g.state = BUTTON_G_IDLE;
+            return BUTTON_SHORT;
+        }
+        return BUTTON_NONE;
+
+    case BUTTON_G_HELD:
+        if (edge && !pressed) g.state = BUTTON_G_IDLE;
+        return BUTTON_NONE;
+    }
+    return BUTTON_NONE;
+}
+
+// When the decoder next needs a step without an edge. False = not until
+// the next edge.
+bool buttonGestureDeadline(const ButtonGesture &g, uint32_t &deadlineMs) {
+    switch (g.state) {
+    case BUTTON_G_DOWN:
+        deadlineMs = g.since + g.longMs;
+        return true;
+    case BUTTON_G_UP:
+        deadlineMs = g.since + g.doubleMs;
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char* buttonEventName(ButtonEvent event) {
+    switch (event) {
+        case BUTTON_SHORT:  return "short";
+        case BUTTON_DOUBLE: return "double";
+        case BUTTON_LONG:   return "long";
+        default:            return "none";
+    }
+}
+
+#endif // BUTTON_GESTURE_H
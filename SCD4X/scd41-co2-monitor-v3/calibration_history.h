@@ -0,0 +1,457 @@
+/*
+ * Calibration History and Drift Tracking
+ *
+ * Every finished forced recalibration (see forced_calibration.h) is kept
+ * in an NVS ring of the last CAL_HISTORY_SIZE results - time, reference,
+ * correction and the warmup stats - and uploaded as a structured event
+ * (category "calibration") so the server can chart corrections over the
+ * sensor's life. The correction divided by the days since the previous
+ * successful calibration is the drift rate the sensor had.
+ *
+ * Between calibrations the drift estimator watches the daily minimum CO2.
+ * A ventilated room bottoms out near outdoor air every day or two, so the
+ * minima form a baseline that shouldn't move. A "recalibration
+ * recommended" event (category "calibration_drift") is raised when:
+ *
+ *   - the lowest minimum of the last 7 days is more than
+ *     CAL_DRIFT_LOW_MARGIN_PPM below the reference of the last successful
+ *     calibration (FRC_REFERENCE_PPM before the first) - indoor air can't
+ *     be cleaner than outdoor air, so the sensor reads low
+ *   - the daily minima trend by CAL_DRIFT_SLOPE_PPM_DAY or more over at
+ *     least CAL_DRIFT_MIN_DAYS days
+ *
+ * at most once per CAL_DRIFT_EVENT_INTERVAL_DAYS. Days are calendar days
+ * from NTP; until the clock is set, readings aren't tracked. Only days
+ * with CAL_DRIFT_MIN_READINGS readings count. The minima are cleared
+ * after a successful calibration since they were measured with the old
+ * offset.
+ *
+ * Usage:
+ *   1. calHistoryInit(logEvent) in setup()
+ *   2. calHistoryRecord(frcLastResult()) when a calibration finishes
+ *   3. calHistoryUpdate(co2) with each regular measurement
+ */
+
+#ifndef CALIBRATION_HISTORY_H
+#define CALIBRATION_HISTORY_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <time.h>
+#include "forced_calibration.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define CAL_HISTORY_PREFS_NAMESPACE "calhist"
+#define CAL_HISTORY_VERSION 1
+
+#define CAL_HISTORY_SIZE 16
+
+// Daily minima kept for the drift estimate
+#define CAL_DRIFT_DAYS             14
+#define CAL_DRIFT_MIN_DAYS         7
+#define CAL_DRIFT_LOW_WINDOW_DAYS  7
+#define CAL_DRIFT_MIN_READINGS     720     // 12 hours of 60 s readings
+
+// Thresholds for recommending a recalibration
+#define CAL_DRIFT_LOW_MARGIN_PPM   30
+#define CAL_DRIFT_SLOPE_PPM_DAY    3.0
+#define CAL_DRIFT_EVENT_INTERVAL_DAYS 7
+
+// The day in progress is saved this often so a reboot doesn't lose it
+#define CAL_DRIFT_SAVE_MS 3600000UL
+
+// An epoch below this means the clock isn't set
+#define CAL_TIME_VALID 1600000000
+
+// ===========================================
+// Types
+// ===========================================
+
+enum CalEventType {
+    CAL_EVENT_INFO = 0,
+    CAL_EVENT_WARNING = 1
+};
+
+// Event with a category and a JSON object of fields
+typedef bool (*CalHistoryEventCallback)(int type, const char* msg,
+                                         const char* category, const char* data);
+
+struct CalHistoryRecord {
+    uint8_t version;
+    uint8_t result;             // FRCResultCode
+    uint16_t reference;
+    int16_t correction;
+    uint16_t readings;
+    uint16_t outliers;
+    uint32_t epoch;             // 0 = clock not set
+    uint32_t uptimeS;
+    uint32_t convergedMs;
+    float avgCO2;
+    float noise;
+    float stdError;
+};
+
+struct CalDayMin {
+    int32_t day;                // Days since 1970 (local), 0 = empty
+    uint16_t minCO2;
+    uint16_t readings;
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static Preferences _chPrefs;
+static CalHistoryEventCallback _chLogEvent = nullptr;
+
+// Ring of results, _chHead is the next slot to write
+static CalHistoryRecord _chRecords[CAL_HISTORY_SIZE];
+static uint8_t _chHead = 0;
+static uint8_t _chCount = 0;
+
+// Daily minima, oldest first - the last used entry is the day in progress
+static CalDayMin _chDays[CAL_DRIFT_DAYS];
+static uint8_t _chDayCount = 0;
+static unsigned long _chLastSaveMs = 0;
+static uint32_t _chLastWarnEpoch = 0;
+
+// Last drift estimate
+static float _chSlope = 0;
+static uint16_t _chLowMin = 0;
+static uint8_t _chValidDays = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static void _chRecordKey(int slot, char* key) {
+    snprintf(key, 8, "r%d", slot);
+}
+
+static uint32_t _chEpoch() {
+    time_t now = time(nullptr);
+    return now > CAL_TIME_VALID ? (uint32_t)now : 0;
+}
+
+// Local calendar day, or -1 if the clock isn't set
+static int32_t _chToday() {
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo, 0)) return -1;
+    // Noon of the same local date, so DST shifts can't change the day
+    timeinfo.tm_hour = 12;
+    timeinfo.tm_min = 0;
+    timeinfo.tm_sec = 0;
+    time_t noon = mktime(&timeinfo);
+    if (noon < CAL_TIME_VALID) return -1;
+    return (int32_t)(noon / 86400);
+}
+
+// i = 0 is the newest record
+static const CalHistoryRecord& _chRecordAt(int i) {
+    return _chRecords[(_chHead + CAL_HISTORY_SIZE - 1 - i) % CAL_HISTORY_SIZE];
+}
+
+static void _chSaveDays() {
+    _chPrefs.putBytes("days", _chDays, sizeof(CalDayMin) * _chDayCount);
+    _chLastSaveMs = millis();
+}
+
+static void _chClearDays() {
+    _chDayCount = 0;
+    _chSlope = 0;
+    _chLowMin = 0;
+    _chValidDays = 0;
+    _chPrefs.remove("days");
+}
+
+// Least-squares slope of the complete days' minima, and the lowest
+// minimum of the last CAL_DRIFT_LOW_WINDOW_DAYS. The day in progress is
+// left out.
+static void _chEstimateDrift() {
+    _chValidDays = 0;
+    _chLowMin = 0;
+    _chSlope = 0;
+    if (_chDayCount < 2) return;
+
+    int32_t lastDay = _chDays[_chDayCount - 1].day;
+    float sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < _chDayCount - 1; i++) {
+        const CalDayMin &d = _chDays[i];
+        if (d.readings < CAL_DRIFT_MIN_READINGS) continue;
+        float x = d.day - lastDay;
+        sx += x;
+        sy += d.minCO2;
+        sxx += x * x;
+        sxy += x * d.minCO2;
+        _chValidDays++;
+        if (lastDay - d.day <= CAL_DRIFT_LOW_WINDOW_DAYS &&
+            (_chLowMin == 0 || d.minCO2 < _chLowMin)) {
+            _chLowMin = d.minCO2;
+        }
+    }
+
+    float denom = _chValidDays * sxx - sx * sx;
+    if (_chValidDays >= 2 && denom > 0) {
+        _chSlope = (_chValidDays * sxy - sx * sy) / denom;
+    }
+}
+
+// Reference of the last successful calibration - the level the sensor was
+// set to read - or FRC_REFERENCE_PPM if there hasn't been one
+static uint16_t _chLastReference() {
+    for (int i = 0; i < _chCount; i++) {
+        const CalHistoryRecord &rec = _chRecordAt(i);
+        if (rec.result == FRC_RESULT_OK) return rec.reference;
+    }
+    return FRC_REFERENCE_PPM;
+}
+
+static void _chCheckDrift() {
+    _chEstimateDrift();
+    if (_chValidDays < CAL_DRIFT_MIN_DAYS) return;
+
+    uint16_t reference = _chLastReference();
+    bool low = _chLowMin > 0 && _chLowMin < reference - CAL_DRIFT_LOW_MARGIN_PPM;
+    bool drifting = fabs(_chSlope) >= CAL_DRIFT_SLOPE_PPM_DAY;
+    if (!low && !drifting) return;
+
+    uint32_t now = _chEpoch();
+    if (_chLastWarnEpoch && now - _chLastWarnEpoch < CAL_DRIFT_EVENT_INTERVAL_DAYS * 86400UL) {
+        return;
+    }
+    _chLastWarnEpoch = now;
+    _chPrefs.putUInt("lastwarn", _chLastWarnEpoch);
+
+    char msg[112];
+    if (low) {
+        snprintf(msg, sizeof(msg),
+                 "Recalibration recommended - sensor reads low (7-day min %u ppm, reference %u ppm)",
+                 _chLowMin, reference);
+    } else {
+        snprintf(msg, sizeof(msg),
+                 "Recalibration recommended - baseline drifting %.1f ppm/day over %d days",
+                 _chSlope, _chValidDays);
+    }
+    Serial.print("[Cal] ");
+    Serial.println(msg);
+
+    if (_chLogEvent) {
+        char data[128];
+        snprintf(data, sizeof(data),
+                 "{\"reason\":\"%s\",\"min_7d\":%u,\"reference\":%u,\"slope_ppm_day\":%.2f,\"days\":%d}",
+                 low ? "low" : "drifting", _chLowMin, reference, _chSlope, _chValidDays);
+        _chLogEvent(CAL_EVENT_WARNING, msg, "calibration_drift", data);
+    }
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void calHistoryInit(CalHistoryEventCallback logEvent) {
+    _chLogEvent = logEvent;
+    _chPrefs.begin(CAL_HISTORY_PREFS_NAMESPACE, false);
+
+    _chHead = _chPrefs.getUChar("head", 0) % CAL_HISTORY_SIZE;
+    _chCount = 0;
+    char key[8];
+    for (int i = 0; i < CAL_HISTORY_SIZE; i++) {
+        _chRecordKey(i, key);
+        if (_chPrefs.getBytes(key, &_chRecords[i], sizeof(CalHistoryRecord)) != sizeof(CalHistoryRecord) ||
+            _chRecords[i].version != CAL_HISTORY_VERSION) {
+            memset(&_chRecords[i], 0, sizeof(CalHistoryRecord));
+        } else {
+            _chCount++;
+        }
+    }
+
+    size_t len = _chPrefs.getBytes("days", _chDays, sizeof(_chDays));
+    _chDayCount = len / sizeof(CalDayMin);
+    _chLastWarnEpoch = _chPrefs.getUInt("lastwarn", 0);
+    _chEstimateDrift();
+
+    Serial.print("[Cal] ");
+    Serial.print(_chCount);
+    Serial.print(" calibrations in history, ");
+    Serial.print(_chDayCount);
+    Serial.println(" days of baseline");
+}
+
+// ===========================================
+// Record a finished calibration
+// ===========================================
+
+void calHistoryRecord(const FRCResult& res) {
+    CalHistoryRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.version = CAL_HISTORY_VERSION;
+    rec.result = res.result;
+    rec.reference = res.reference;
+    rec.correction = res.correction;
+    rec.readings = res.readings;
+    rec.outliers = res.outliers;
+    rec.epoch = _chEpoch();
+    rec.uptimeS = millis() / 1000;
+    rec.convergedMs = res.convergedMs;
+    rec.avgCO2 = res.avgCO2;
+    rec.noise = res.noise;
+    rec.stdError = res.stdError;
+
+    // Days since the previous successful calibration, if both have a date
+    float daysSince = -1;
+    for (int i = 0; i < _chCount; i++) {
+        const CalHistoryRecord &prev = _chRecordAt(i);
+        if (prev.result != FRC_RESULT_OK) continue;
+        if (prev.epoch && rec.epoch > prev.epoch) {
+            daysSince = (rec.epoch - prev.epoch) / 86400.0;
+        }
+        break;
+    }
+
+    char key[8];
+    _chRecordKey(_chHead, key);
+    _chRecords[_chHead] = rec;
+    _chPrefs.putBytes(key, &rec, sizeof(rec));
+    _chHead = (_chHead + 1) % CAL_HISTORY_SIZE;
+    _chPrefs.putUChar("head", _chHead);
+    if (_chCount < CAL_HISTORY_SIZE) _chCount++;
+
+    // The baseline was measured with the old offset
+    if (res.result == FRC_RESULT_OK) _chClearDays();
+
+    Serial.print("[Cal] Recorded ");
+    Serial.print(frcResultName(rec.result));
+    Serial.print(" calibration, correction ");
+    Serial.print(rec.correction);
+    Serial.println(" ppm");
+
+    if (_chLogEvent) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "Calibration %s, correction %d ppm",
+                 frcResultName(rec.result), rec.correction);
+
+        // Correction per day since the last calibration = drift rate
+        char rate[16] = "null";
+        char since[16] = "null";
+        if (daysSince > 0) {
+            snprintf(since, sizeof(since), "%.1f", daysSince);
+            if (rec.result == FRC_RESULT_OK) {
+                snprintf(rate, sizeof(rate), "%.2f", rec.correction / daysSince);
+            }
+        }
+
+        char data[320];
+        snprintf(data, sizeof(data),
+                 "{\"result\":\"%s\",\"reference\":%u,\"correction\":%d,\"avg\":%.1f,"
+                 "\"noise\":%.1f,\"stderr\":%.2f,\"readings\":%u,\"outliers\":%u,"
+                 "\"converged_s\":%lu,\"epoch\":%lu,\"days_since_last\":%s,\"drift_ppm_day\":%s}",
+                 frcResultName(rec.result), rec.reference, rec.correction, rec.avgCO2,
+                 rec.noise, rec.stdError, rec.readings, rec.outliers,
+                 (unsigned long)(rec.convergedMs / 1000), (unsigned long)rec.epoch, since, rate);
+        _chLogEvent(rec.result == FRC_RESULT_OK ? CAL_EVENT_INFO : CAL_EVENT_WARNING,
+                    msg, "calibration", data);
+    }
+}
+
+// ===========================================
+// Update - call with each regular measurement
+// ===========================================
+
+void calHistoryUpdate(uint16_t co2) {
+    if (co2 == 0) return;
+    int32_t today = _chToday();
+    if (today < 0) return;
+
+    CalDayMin *cur = _chDayCount > 0 ? &_chDays[_chDayCount - 1] : nullptr;
+    if (!cur || cur->day != today) {
+        // New day - drop the oldest if full, then judge the finished days
+        if (_chDayCount == CAL_DRIFT_DAYS) {
+            memmove(_chDays, _chDays + 1, sizeof(CalDayMin) * (CAL_DRIFT_DAYS - 1));
+            _chDayCount--;
+        }
+        cur = &_chDays[_chDayCount++];
+        cur->day = today;
+        cur->minCO2 = co2;
+        cur->readings = 0;
+        _chSaveDays();
+        _chCheckDrift();
+    }
+
+    if (co2 < cur->minCO2) cur->minCO2 = co2;
+    if (cur->readings < 0xFFFF) cur->readings++;
+
+    if (millis() - _chLastSaveMs >= CAL_DRIFT_SAVE_MS) {
+        _chSaveDays();
+    }
+}
+
+// ===========================================
+// Status
+// ===========================================
+
+void calHistoryPrint() {
+    Serial.println();
+    Serial.println("=== Calibration History ===");
+    if (_chCount == 0) Serial.println("  (none)");
+    for (int i = 0; i < _chCount; i++) {
+        const CalHistoryRecord &rec = _chRecordAt(i);
+        char when[24];
+        if (rec.epoch) {
+            time_t t = rec.epoch;
+            struct tm tmv;
+            localtime_r(&t, &tmv);
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M", &tmv);
+        } else {
+            snprintf(when, sizeof(when), "uptime %lus", (unsigned long)rec.uptimeS);
+        }
+        char line[112];
+        snprintf(line, sizeof(line),
+                 "  %s  %-9s ref %u corr %+d avg %.0f noise %.1f +/-%.2f (%u rdg, %u out, %lus)",
+                 when, frcResultName(rec.result), rec.reference, rec.correction, rec.avgCO2,
+                 rec.noise, rec.stdError, rec.readings, rec.outliers,
+                 (unsigned long)(rec.convergedMs / 1000));
+        Serial.println(line);
+    }
+
+    Serial.println("--- Daily minimum CO2 ---");
+    if (_chDayCount == 0) Serial.println("  (none yet - needs the clock from NTP)");
+    for (int i = 0; i < _chDayCount; i++) {
+        // Day numbers come from local noon, so the UTC date is the local date
+        time_t t = (time_t)_chDays[i].day * 86400;
+        struct tm tmv;
+        gmtime_r(&t, &tmv);
+        char line[48];
+        char date[12];
+        strftime(date, sizeof(date), "%Y-%m-%d", &tmv);
+        snprintf(line, sizeof(line), "  %s  %u ppm (%u readings%s)", date, _chDays[i].minCO2,
+                 _chDays[i].readings, i == _chDayCount - 1 ? ", today" : "");
+        Serial.println(line);
+    }
+    Serial.println("===========================");
+}
+
+void calHistoryPrintStats() {
+    Serial.print("Calibration: ");
+    Serial.print(_chCount);
+    Serial.print(" in history");
+    if (_chCount > 0) {
+        const CalHistoryRecord &last = _chRecordAt(0);
+        Serial.print(", last ");
+        Serial.print(frcResultName(last.result));
+        Serial.print(" (");
+        Serial.print(last.correction);
+        Serial.print(" ppm)");
+    }
+    Serial.print(", baseline ");
+    Serial.print(_chValidDays);
+    Serial.print(" days, 7-day min ");
+    Serial.print(_chLowMin);
+    Serial.print(" ppm, slope ");
+    Serial.print(_chSlope, 1);
+    Serial.println(" ppm/day");
+}
+
+#endif // CALIBRATION_HISTORY_H
@@ -0,0 +1,282 @@
+/*
+ * Display Power Policy for the SH1106 OLED
+ *
+ * The monitor runs 24/7, so the panel shouldn't sit at full brightness
+ * redrawing the same layout every second forever. This module decides
+ * when the panel is active, dimmed, or blanked:
+ *
+ *   ACTIVE  - full contrast, periodic refresh (clock, WiFi status)
+ *   DIMMED  - low contrast, redrawn only when a new reading arrives
+ *   BLANK   - panel powered down (U8g2 power save), nothing is drawn
+ *
+ * The panel dims after DP_DIM_AFTER_MS without activity and blanks after
+ * DP_BLANK_AFTER_MS, or as soon as it dims during quiet hours. Button
+ * presses and CO2 alarms count as activity and wake it to ACTIVE.
+ *
+ * To limit burn-in, content is shifted by one pixel every
+ * DP_SHIFT_INTERVAL_MS, cycling through four positions. The shift is right
+ * and/or down on screen, whichever way the panel is rotated, so the left
+ * column and top row (status text, page titles) are never pushed off.
+ *
+ * Usage:
+ *   1. displayPowerInit(u8g2) in setup()
+ *   2. displayPowerUpdate(u8g2) every loop pass
+ *   3. displayPowerWake(u8g2, reason) on button press / CO2 alarm
+ *   4. displayPowerBeforeSend(u8g2) right before sendBuffer()
+ *   5. Skip periodic redraws unless displayPowerPeriodicRefresh()
+ */
+
+#ifndef DISPLAY_POWER_H
+#define DISPLAY_POWER_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <time.h>
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// Inactivity before dimming / blanking
+#define DP_DIM_AFTER_MS    300000UL    // 5 minutes
+#define DP_BLANK_AFTER_MS  1800000UL   // 30 minutes
+
+// Contrast levels (0-255)
+#define DP_ACTIVE_CONTRAST 255
+#define DP_DIM_CONTRAST    16
+
+// Quiet hours (local time) - panel blanks instead of dimming.
+// Set start == end to disable. Window may wrap past midnight.
+#define DP_QUIET_START_HOUR 22
+#define DP_QUIET_END_HOUR   7
+
+// CO2 level that wakes the display
+#define DP_ALARM_PPM 1500
+
+// Burn-in protection: move content one pixel this often
+#define DP_SHIFT_INTERVAL_MS 120000UL
+
+// ===========================================
+// State
+// ===========================================
+
+enum DisplayPowerState {
+    DP_ACTIVE = 0,
+    DP_DIMMED = 1,
+    DP_BLANK = 2
+};
+
+static DisplayPowerState _dpState = DP_ACTIVE;
+static unsigned long _dpLastActivity = 0;
+static unsigned long _dpLastUpdate = 0;
+static unsigned long _dpPanelOnMs = 0;
+static bool _dpShiftEnabled = true;
+
+// Frames pushed to the panel, counted per clock hour of uptime
+static uint32_t _dpFramesThisHour = 0;
+static uint32_t _dpFramesLastHour = 0;
+static unsigned long _dpHourIndex = 0;
+
+// Pixel shift pattern: (0,0) -> (1,0) -> (1,1) -> (0,1), right/down on
+// screen. Layouts keep DP_SHIFT_MAX_PX clear at the right and bottom.
+#define DP_SHIFT_MAX_PX 1
+static const uint8_t _dpShiftX[] = {0, 1, 1, 0};
+static const uint8_t _dpShiftY[] = {0, 0, 1, 1};
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static const char* _dpStateName(DisplayPowerState state) {
+    switch (state) {
+        case DP_DIMMED: return "dimmed";
+        case DP_BLANK:  return "blank";
+        default:        return "active";
+    }
+}
+
+// True if local time is known and inside the quiet window
+static bool _dpQuietHours() {
+    if (DP_QUIET_START_HOUR == DP_QUIET_END_HOUR) return false;
+
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo, 0)) return false;
+
+    int hour = timeinfo.tm_hour;
+    if (DP_QUIET_START_HOUR < DP_QUIET_END_HOUR) {
+        return hour >= DP_QUIET_START_HOUR && hour < DP_QUIET_END_HOUR;
+    }
+    return hour >= DP_QUIET_START_HOUR || hour < DP_QUIET_END_HOUR;
+}
+
+static void _dpApplyState(U8G2 &display, DisplayPowerState state) {
+    if (state == _dpState) return;
+
+    Serial.print("[Display] ");
+    Serial.print(_dpStateName(_dpState));
+    Serial.print(" -> ");
+    Serial.println(_dpStateName(state));
+
+    if (state == DP_BLANK) {
+        display.setPowerSave(1);
+    } else {
+        if (_dpState == DP_BLANK) {
+            display.setPowerSave(0);
+        }
+        display.setContrast(state == DP_ACTIVE ? DP_ACTIVE_CONTRAST : DP_DIM_CONTRAST);
+    }
+    _dpState = state;
+}
+
+// ===========================================
+// Initialize - call in setup() after u8g2.begin()
+// ===========================================
+
+void displayPowerInit(U8G2 &display) {
+    _dpLastActivity = millis();
+    _dpLastUpdate = millis();
+    _dpState = DP_ACTIVE;
+    display.setContrast(DP_ACTIVE_CONTRAST);
+}
+
+// ===========================================
+// Update - call every loop pass
+// ===========================================
+
+void displayPowerUpdate(U8G2 &display) {
+    unsigned long now = millis();
+
+    if (_dpState != DP_BLANK) {
+        _dpPanelOnMs += now - _dpLastUpdate;
+    }
+    _dpLastUpdate = now;
+
+    unsigned long hourIndex = now / 3600000UL;
+    if (hourIndex != _dpHourIndex) {
+        _dpFramesLastHour = _dpFramesThisHour;
+        _dpFramesThisHour = 0;
+        _dpHourIndex = hourIndex;
+    }
+
+    unsigned long idle = now - _dpLastActivity;
+    DisplayPowerState target = DP_ACTIVE;
+    if (idle >= DP_BLANK_AFTER_MS) {
+        target = DP_BLANK;
+    } else if (idle >= DP_DIM_AFTER_MS) {
+        target = _dpQuietHours() ? DP_BLANK : DP_DIMMED;
+    }
+    _dpApplyState(display, target);
+}
+
+// ===========================================
+// Wake - button press or CO2 alarm
+// Returns true if the panel was dimmed or blank (the wake consumed the event)
+// ===========================================
+
+bool displayPowerWake(U8G2 &display, const char* reason) {
+    _dpLastActivity = millis();
+    if (_dpState == DP_ACTIVE) return false;
+
+    Serial.print("[Display] Wake: ");
+    Serial.println(reason);
+    _dpApplyState(display, DP_ACTIVE);
+    return true;
+}
+
+// Call with each new CO2 reading; wakes the panel while above the alarm level
+void displayPowerCheckAlarm(U8G2 &display, uint16_t co2) {
+    if (co2 >= DP_ALARM_PPM) {
+        displayPowerWake(display, "CO2 alarm");
+    }
+}
+
+// ===========================================
+// Refresh policy
+// ===========================================
+
+// Periodic (clock/WiFi) redraws only while active; dimmed panels are
+// redrawn once per reading, blank panels not at all
+bool displayPowerPeriodicRefresh() {
+    return _dpState == DP_ACTIVE;
+}
+
+bool displayPowerPanelOn() {
+    return _dpState != DP_BLANK;
+}
+
+DisplayPowerState displayPowerState() {
+    return _dpState;
+}
+
+const char* displayPowerStateName() {
+    return _dpStateName(_dpState);
+}
+
+unsigned long displayPowerPanelOnMs() {
+    return _dpPanelOnMs;
+}
+
+// Frames in the last complete hour of uptime (current hour during the first)
+uint32_t displayPowerFramesPerHour() {
+    return _dpHourIndex > 0 ? _dpFramesLastHour : _dpFramesThisHour;
+}
+
+// Disable the pixel shift, e.g. for reproducible framebuffer snapshots
+void displayPowerSetShift(bool enabled) {
+    _dpShiftEnabled = enabled;
+}
+
+// ===========================================
+// Before send - applies the burn-in shift and counts the frame
+// Works on full-buffer (_F_) constructors, rotated U8G2_R0 or U8G2_R2
+// ===========================================
+
+void displayPowerBeforeSend(U8G2 &display) {
+    _dpFramesThisHour++;
+    if (!_dpShiftEnabled) return;
+
+    int step = (millis() / DP_SHIFT_INTERVAL_MS) % 4;
+    uint8_t dx = _dpShiftX[step];
+    uint8_t dy = _dpShiftY[step];
+    if (dx == 0 && dy == 0) return;
+
+    uint8_t *buf = display.getBufferPtr();
+    int rowBytes = display.getBufferTileWidth() * 8;
+    int pages = display.getBufferTileHeight();
+
+    // The buffer is in panel orientation. Under U8G2_R2 the screen's right
+    // and down are the buffer's left and up, so the shift is reversed -
+    // otherwise it would push the screen's left column and top row off.
+    bool rotated = (display.getU8g2()->cb == &u8g2_cb_r2);
+
+    if (dx) {
+        for (int p = 0; p < pages; p++) {
+            uint8_t *row = &buf[p * rowBytes];
+            if (rotated) {
+                memmove(row, row + 1, rowBytes - 1);
+                row[rowBytes - 1] = 0;
+            } else {
+                memmove(row + 1, row, rowBytes - 1);
+                row[0] = 0;
+            }
+        }
+    }
+
+    if (dy) {
+        for (int col = 0; col < rowBytes; col++) {
+            if (rotated) {
+                for (int p = 0; p < pages; p++) {
+                    uint8_t carry = (p < pages - 1) ? (buf[(p + 1) * rowBytes + col] << 7) : 0;
+                    buf[p * rowBytes + col] = (buf[p * rowBytes + col] >> 1) | carry;
+                }
+            } else {
+                for (int p = pages - 1; p >= 0; p--) {
+                    uint8_t carry = (p > 0) ? (buf[(p - 1) * rowBytes + col] >> 7) : 0;
+                    buf[p * rowBytes + col] = (buf[p * rowBytes + col] << 1) | carry;
+                }
+            }
+        }
+    }
+}
+
+#endif // DISPLAY_POWER_H
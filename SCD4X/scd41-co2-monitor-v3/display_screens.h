@@ -0,0 +1,458 @@
+/*
+ * OLED Screens
+ *
+ * The full-screen layouts - the main reading, waiting for the first
+ * reading, WiFi connecting, calibrating, two-line messages and the
+ * secondary pages (trend, network, IR, diagnostics) - drawn from plain
+ * values instead of the sketch's globals, so the same code renders on the
+ * ESP32 and in the host snapshot build (host/).
+ *
+ * Each screenDraw*() only draws into the framebuffer; the caller clears
+ * it before and sends it after. screenDumpPbm() prints the framebuffer as
+ * an ASCII PBM between markers that snapshot_capture.py picks out of a
+ * serial log or the host build's output.
+ *
+ * Usage:
+ *   u8g2.clearBuffer();
+ *   screenDrawConnecting(u8g2, attempt, maxAttempts);
+ *   u8g2.sendBuffer();
+ */
+
+#ifndef DISPLAY_SCREENS_H
+#define DISPLAY_SCREENS_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include "glyph_cache.h"
+
+// ===========================================
+// Layout
+// ===========================================
+
+// Baseline of the large CO2 number (shared with the glyph cache)
+#define SCREEN_CO2_BASELINE_Y 32
+
+// "ppm" label position - the CO2 number is kept left of it
+#define SCREEN_PPM_LABEL_X 90
+
+// Secondary page rows (5x7 font) - six of them below the title bar
+#define PAGE_ROW_FIRST_Y 20
+#define PAGE_ROW_HEIGHT  8
+#define PAGE_ROWS        6
+
+// ===========================================
+// Types
+// ===========================================
+
+struct ScreenReading {
+    uint16_t co2;           // 0 = no reading yet
+    float temp;
+    float humidity;
+    bool error;             // Shows "ERR"
+    bool waiting;           // Shows "---"
+    bool useGlyphCache;     // Digits from glyph_cache.h when it's ready
+    bool wifiConnected;
+    int rssi;
+    const char* irStatus;   // Status bar IR text, nullptr when idle
+    unsigned long uptimeMs;
+};
+
+// Trend page: CO2 ring buffer, oldest reading at (head - count)
+struct ScreenTrend {
+    const uint16_t* history;
+    int capacity;
+    int head;
+    int count;
+};
+
+struct ScreenNetwork {
+    bool connected;
+    const char* ip;
+    int rssi;
+    unsigned long uploads;
+    unsigned long measurements;
+    unsigned long consecutiveFailures;
+    unsigned long reconnects;
+};
+
+struct ScreenIr {
+    bool spamming;
+    bool spamOn;
+    unsigned long framesSent;
+    long lastSendAgoS;      // -1 = never
+    const char* acState;
+    unsigned int queueDepth;
+    unsigned long sendsPerMinute;
+    unsigned long avgWaitMs;
+    unsigned long maxWaitMs;
+};
+
+struct ScreenDiagnostics {
+    unsigned long measurements;
+    unsigned long i2cErrors;
+    unsigned long freeHeap;
+    unsigned long uptimeMs;
+    unsigned long drawUs;
+    unsigned long sendUs;
+    unsigned long panelOnMs;
+    unsigned long framesPerHour;
+};
+
+// ===========================================
+// Screens
+// ===========================================
+
+void screenDrawReading(U8G2 &display, const ScreenReading &r) {
+    // CO2 reading - big and centered
+    display.setFont(u8g2_font_logisoso28_tn);  // Large numeric font
+    char co2Str[8];
+
+    if (r.error) {
+        strcpy(co2Str, "ERR");
+        display.setFont(u8g2_font_ncenB14_tr);
+    } else if (r.waiting || r.co2 == 0) {
+        strcpy(co2Str, "---");
+    } else {
+        snprintf(co2Str, sizeof(co2Str), "%d", r.co2);
+    }
+
+    // Center the CO2 value - digits come from the glyph cache when available
+    bool cached = r.useGlyphCache && !r.error;
+    int width = cached ? glyphCacheStrWidth(co2Str) : -1;
+    if (width < 0) {
+        cached = false;
+        width = display.getStrWidth(co2Str);
+    }
+
+    // Wide values (5 digits) slide left so they don't run into "ppm"
+    int x = (128 - width) / 2 - 15;
+    if (x + width > SCREEN_PPM_LABEL_X - 2) {
+        x = SCREEN_PPM_LABEL_X - 2 - width;
+    }
+    if (x < 0) {
+        x = 0;
+    }
+
+    if (cached) {
+        glyphCacheDrawStr(display, x, co2Str);
+    } else {
+        display.drawStr(x, SCREEN_CO2_BASELINE_Y, co2Str);
+    }
+
+    // "ppm" label
+    display.setFont(u8g2_font_ncenB08_tr);
+    display.drawStr(SCREEN_PPM_LABEL_X, SCREEN_CO2_BASELINE_Y, "ppm");
+
+    // Temp and humidity on same line
+    display.setFont(u8g2_font_6x10_tr);
+    char envStr[32];
+    if (!r.waiting && r.co2 > 0) {
+        snprintf(envStr, sizeof(envStr), "%.1fC  %.0f%%", r.temp, r.humidity);
+    } else {
+        strcpy(envStr, "--.-C  --%");
+    }
+    width = display.getStrWidth(envStr);
+    display.drawStr((128 - width) / 2, 45, envStr);
+
+    // Divider line
+    display.drawHLine(0, 50, 128);
+
+    // Status bar at bottom
+    display.setFont(u8g2_font_5x7_tr);
+
+    // WiFi indicator
+    if (r.wifiConnected) {
+        char wifiStr[12];
+        snprintf(wifiStr, sizeof(wifiStr), "WiFi %d", r.rssi);
+        display.drawStr(0, 62, wifiStr);
+    } else {
+        display.drawStr(0, 62, "No WiFi");
+    }
+
+    // IR status (if spamming)
+    if (r.irStatus) {
+        display.drawStr(50, 62, r.irStatus);
+    }
+
+    // Uptime
+    char uptimeStr[20];
+    unsigned long mins = r.uptimeMs / 60000;
+    if (mins < 60) {
+        snprintf(uptimeStr, sizeof(uptimeStr), "%lum", mins);
+    } else {
+        snprintf(uptimeStr, sizeof(uptimeStr), "%luh%lum", mins / 60, mins % 60);
+    }
+    display.drawStr(100, 62, uptimeStr);
+}
+
+void screenDrawMessage(U8G2 &display, const char* line1, const char* line2) {
+    display.setFont(u8g2_font_ncenB08_tr);
+
+    int y = line2 ? 25 : 35;
+    int w = display.getStrWidth(line1);
+    display.drawStr((128 - w) / 2, y, line1);
+
+    if (line2) {
+        w = display.getStrWidth(line2);
+        display.drawStr((128 - w) / 2, 45, line2);
+    }
+}
+
+void screenDrawConnecting(U8G2 &display, int attempt, int maxAttempts) {
+    display.setFont(u8g2_font_ncenB08_tr);
+    display.drawStr(20, 25, "Connecting...");
+
+    // Progress bar
+    display.drawFrame(14, 35, 100, 12);
+    int progress = (attempt * 100) / maxAttempts;
+    display.drawBox(15, 36, progress, 10);
+
+    display.setFont(u8g2_font_5x7_tr);
+    char buf[20];
+    snprintf(buf, sizeof(buf), "Attempt %d/%d", attempt, maxAttempts);
+    int w = display.getStrWidth(buf);
+    display.drawStr((128 - w) / 2, 58, buf);
+}
+
+void screenDrawWaiting(U8G2 &display, unsigned long remainingMs, unsigned long intervalMs) {
+    // Title
+    display.setFont(u8g2_font_ncenB08_tr);
+    display.drawStr(22, 18, "Waiting for");
+    display.drawStr(18, 32, "first reading");
+
+    // Progress bar
+    unsigned long elapsed = intervalMs - remainingMs;
+    int progress = (elapsed * 100) / intervalMs;
+    display.drawFrame(14, 42, 100, 8);
+    display.drawBox(15, 43, (progress * 98) / 100, 6);
+
+    // Time remaining (M:SS format)
+    display.setFont(u8g2_font_6x10_tr);
+    char buf[24];
+    unsigned long secs = remainingMs / 1000;
+    snprintf(buf, sizeof(buf), "%lu:%02lu left", secs / 60, secs % 60);
+    int w = display.getStrWidth(buf);
+    display.drawStr((128 - w) / 2, 58, buf);
+}
+
+void screenDrawCalibrating(U8G2 &display, unsigned long remainingMs, unsigned long totalMs,
+                           int readingCount, uint16_t currentCO2, float avgCO2) {
+    // Title
+    display.setFont(u8g2_font_ncenB10_tr);
+    display.drawStr(8, 14, "CALIBRATING...");
+
+    // Current CO2 reading
+    display.setFont(u8g2_font_6x10_tr);
+    char buf[24];
+    if (currentCO2 > 0) {
+        snprintf(buf, sizeof(buf), "CO2: %d ppm", currentCO2);
+    } else {
+        strcpy(buf, "CO2: ---");
+    }
+    display.drawStr(20, 28, buf);
+
+    // Average
+    if (readingCount > 0) {
+        snprintf(buf, sizeof(buf), "Avg: %d ppm", (int)avgCO2);
+    } else {
+        strcpy(buf, "Avg: ---");
+    }
+    display.drawStr(20, 40, buf);
+
+    // Progress bar
+    int progress = ((totalMs - remainingMs) * 100) / totalMs;
+    display.drawFrame(14, 46, 100, 8);
+    display.drawBox(15, 47, (progress * 98) / 100, 6);
+
+    // Time remaining (MM:SS format)
+    unsigned long secs = remainingMs / 1000;
+    snprintf(buf, sizeof(buf), "%lu:%02lu left", secs / 60, secs % 60);
+    int w = display.getStrWidth(buf);
+    display.drawStr((128 - w) / 2, 62, buf);
+}
+
+// ===========================================
+// Secondary pages
+// ===========================================
+
+// Title bar shared by the secondary pages, with "n/N" page indicator
+void screenDrawPageHeader(U8G2 &display, const char* title, int page, int pageCount) {
+    display.setFont(u8g2_font_6x10_tr);
+    display.drawStr(0, 9, title);
+
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%d/%d", page + 1, pageCount);
+    display.setFont(u8g2_font_5x7_tr);
+    display.drawStr(128 - display.getStrWidth(buf), 8, buf);
+
+    display.drawHLine(0, 11, 128);
+}
+
+// Draw one "label: value" row of a secondary page (rows 0 to PAGE_ROWS - 1)
+void screenDrawPageRow(U8G2 &display, int row, const char* text) {
+    display.drawStr(0, PAGE_ROW_FIRST_Y + row * PAGE_ROW_HEIGHT, text);
+}
+
+void screenDrawTrendPage(U8G2 &display, int page, int pageCount, const ScreenTrend &t) {
+    screenDrawPageHeader(display, "CO2 Trend", page, pageCount);
+    display.setFont(u8g2_font_5x7_tr);
+
+    if (t.count < 2) {
+        screenDrawPageRow(display, 2, "Collecting readings...");
+        return;
+    }
+
+    // Scale to the min/max of the stored readings
+    uint16_t minCO2 = 0xFFFF, maxCO2 = 0;
+    for (int i = 0; i < t.count; i++) {
+        uint16_t v = t.history[i];
+        if (v < minCO2) minCO2 = v;
+        if (v > maxCO2) maxCO2 = v;
+    }
+    uint16_t range = maxCO2 - minCO2;
+    if (range < 50) range = 50;
+
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%u", maxCO2);
+    display.drawStr(0, 20, buf);
+    snprintf(buf, sizeof(buf), "%u", minCO2);
+    display.drawStr(0, 63, buf);
+
+    // Plot area to the right of the labels, oldest reading on the left
+    const int plotX = 24, plotY = 14, plotW = 104, plotH = 49;
+    int oldest = (t.head - t.count + t.capacity) % t.capacity;
+    int prevX = 0, prevY = 0;
+    for (int i = 0; i < t.count; i++) {
+        uint16_t v = t.history[(oldest + i) % t.capacity];
+        int x = plotX + (i * (plotW - 1)) / (t.capacity - 1);
+        int y = plotY + plotH - 1 - ((long)(v - minCO2) * (plotH - 1)) / range;
+        if (i > 0) {
+            display.drawLine(prevX, prevY, x, y);
+        }
+        prevX = x;
+        prevY = y;
+    }
+}
+
+void screenDrawNetworkPage(U8G2 &display, int page, int pageCount, const ScreenNetwork &n) {
+    screenDrawPageHeader(display, "Network", page, pageCount);
+    display.setFont(u8g2_font_5x7_tr);
+    char buf[48];
+
+    if (n.connected) {
+        snprintf(buf, sizeof(buf), "IP: %s", n.ip);
+        screenDrawPageRow(display, 0, buf);
+        snprintf(buf, sizeof(buf), "RSSI: %d dBm", n.rssi);
+        screenDrawPageRow(display, 1, buf);
+    } else {
+        screenDrawPageRow(display, 0, "WiFi: disconnected");
+    }
+
+    snprintf(buf, sizeof(buf), "Uploads: %lu/%lu", n.uploads, n.measurements);
+    screenDrawPageRow(display, 2, buf);
+    snprintf(buf, sizeof(buf), "Success: %.1f%%",
+             n.measurements > 0 ? (100.0 * n.uploads / n.measurements) : 0.0);
+    screenDrawPageRow(display, 3, buf);
+    snprintf(buf, sizeof(buf), "Consec. fails: %lu", n.consecutiveFailures);
+    screenDrawPageRow(display, 4, buf);
+    snprintf(buf, sizeof(buf), "Reconnects: %lu", n.reconnects);
+    screenDrawPageRow(display, 5, buf);
+}
+
+void screenDrawIrPage(U8G2 &display, int page, int pageCount, const ScreenIr &ir) {
+    screenDrawPageHeader(display, "IR Blaster", page, pageCount);
+    display.setFont(u8g2_font_5x7_tr);
+    char buf[48];
+
+    if (ir.spamming) {
+        snprintf(buf, sizeof(buf), "Spam: ACTIVE (%s)", ir.spamOn ? "ON" : "OFF");
+    } else {
+        strcpy(buf, "Spam: off");
+    }
+    screenDrawPageRow(display, 0, buf);
+
+    snprintf(buf, sizeof(buf), "Frames sent: %lu", ir.framesSent);
+    screenDrawPageRow(display, 1, buf);
+
+    if (ir.lastSendAgoS >= 0) {
+        snprintf(buf, sizeof(buf), "Last send: %lds ago", ir.lastSendAgoS);
+    } else {
+        strcpy(buf, "Last send: never");
+    }
+    screenDrawPageRow(display, 2, buf);
+
+    snprintf(buf, sizeof(buf), "AC: %s", ir.acState);
+    screenDrawPageRow(display, 3, buf);
+
+    snprintf(buf, sizeof(buf), "Queue: %u, %lu/min", ir.queueDepth, ir.sendsPerMinute);
+    screenDrawPageRow(display, 4, buf);
+
+    snprintf(buf, sizeof(buf), "Wait avg/max: %lu/%lu ms", ir.avgWaitMs, ir.maxWaitMs);
+    screenDrawPageRow(display, 5, buf);
+}
+
+void screenDrawDiagnosticsPage(U8G2 &display, int page, int pageCount, const ScreenDiagnostics &d) {
+    screenDrawPageHeader(display, "Diagnostics", page, pageCount);
+    display.setFont(u8g2_font_5x7_tr);
+    char buf[48];
+
+    snprintf(buf, sizeof(buf), "Measurements: %lu", d.measurements);
+    screenDrawPageRow(display, 0, buf);
+    snprintf(buf, sizeof(buf), "I2C errors: %lu", d.i2cErrors);
+    screenDrawPageRow(display, 1, buf);
+    snprintf(buf, sizeof(buf), "Free heap: %lu", d.freeHeap);
+    screenDrawPageRow(display, 2, buf);
+
+    unsigned long secs = d.uptimeMs / 1000;
+    snprintf(buf, sizeof(buf), "Uptime: %lud %02lu:%02lu:%02lu",
+             secs / 86400, (secs / 3600) % 24, (secs / 60) % 60, secs % 60);
+    screenDrawPageRow(display, 3, buf);
+
+    snprintf(buf, sizeof(buf), "Draw/send: %lu/%lu us", d.drawUs, d.sendUs);
+    screenDrawPageRow(display, 4, buf);
+
+    unsigned long onMins = d.panelOnMs / 60000;
+    snprintf(buf, sizeof(buf), "Panel %luh%02lum, %lu frm/h",
+             onMins / 60, onMins % 60, d.framesPerHour);
+    screenDrawPageRow(display, 5, buf);
+}
+
+// ===========================================
+// Snapshots
+// ===========================================
+
+// Dump the framebuffer as an ASCII PBM (P1) in screen orientation,
+// between markers so snapshot_capture.py can pull it out of a serial log
+void screenDumpPbm(U8G2 &display, const char* name, unsigned long renderUs) {
+    uint8_t* buf = display.getBufferPtr();
+    int width = display.getBufferTileWidth() * 8;
+    int height = display.getBufferTileHeight() * 8;
+    bool rotated = (display.getU8g2()->cb == &u8g2_cb_r2);
+
+    Serial.print("-----BEGIN SNAPSHOT ");
+    Serial.print(name);
+    Serial.print(" ");
+    Serial.print(renderUs);
+    Serial.println("us-----");
+    Serial.println("P1");
+    Serial.print(width);
+    Serial.print(" ");
+    Serial.println(height);
+
+    char row[129];
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int px = rotated ? width - 1 - x : x;
+            int py = rotated ? height - 1 - y : y;
+            row[x] = (buf[(py / 8) * width + px] & (1 << (py % 8))) ? '1' : '0';
+        }
+        row[width] = '\0';
+        Serial.println(row);
+    }
+
+    Serial.print("-----END SNAPSHOT ");
+    Serial.print(name);
+    Serial.println("-----");
+}
+
+#endif // DISPLAY_SCREENS_H
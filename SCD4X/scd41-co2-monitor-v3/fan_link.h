@@ -0,0 +1,352 @@
+/*
+ * MQTT Fan-State Confirmation
+ *
+ * Implements the protocol from MQTT-Example/README.md. While the IR
+ * blaster is trying to switch the fan, "fan/blasting" is 1; a second
+ * ESP32 next to the fan watches it and publishes "fan/status" on/off.
+ * As soon as the status matches what we're sending, the activation ends
+ * and the sketch stops spamming (every extra frame is a beep). The node
+ * only publishes on a change, so an activation toward the state it last
+ * reported is confirmed on the next poll without waiting for a message.
+ * A status is only trusted while connected - it is forgotten on
+ * disconnect, since changes may have been missed.
+ *
+ *   - Polled from loop(), reconnects rate-limited to one try per
+ *     FAN_MQTT_RECONNECT_MS. PubSubClient's connect() blocks, so it is
+ *     kept short: the broker is given as an IP address (no DNS lookup),
+ *     the TCP connect gives up after FAN_MQTT_CONNECT_TIMEOUT_MS, and the
+ *     wait for the broker's reply after FAN_MQTT_SOCKET_TIMEOUT_S
+ *   - Timeout fallback: with no confirmation after FAN_CONFIRM_TIMEOUT_MS
+ *     the activation ends anyway, so a missing fan node can't leave the
+ *     blaster spamming forever
+ *   - The broker's last-will sets "fan/blasting" to 0 if we drop off
+ *
+ * Metrics per activation: time to confirmation and IR frames sent.
+ *
+ * Other modules can share the connection: fanLinkSubscribe() adds a topic
+ * (re-subscribed after every reconnect) and fanLinkPublish() sends one.
+ *
+ * Usage:
+ *   1. fanLinkInit(server, onEnd) in setup() - server is the broker
+ *      (mqttServer from secrets.h), onEnd(on, confirmed) is called when an
+ *      activation ends
+ *   2. fanLinkPoll() every loop pass
+ *   3. fanLinkStart(on) when the blaster starts trying to switch the fan,
+ *      fanLinkEnd() if it's stopped by hand
+ */
+
+#ifndef FAN_LINK_H
+#define FAN_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "ir_scheduler.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define FAN_MQTT_PORT      1883
+#define FAN_MQTT_CLIENT_ID "SCD41-ESP32"
+
+#define FAN_TOPIC_BLASTING "fan/blasting"
+#define FAN_TOPIC_STATUS   "fan/status"
+
+#define FAN_MQTT_RECONNECT_MS       5000
+#define FAN_MQTT_CONNECT_TIMEOUT_MS 300     // TCP connect - a down broker costs this
+#define FAN_MQTT_SOCKET_TIMEOUT_S   1       // Broker reply (CONNACK), PubSubClient's minimum
+
+#define FAN_CONFIRM_TIMEOUT_MS 30000
+
+// Extra topics other modules can subscribe to, and their payload size
+#define FAN_LINK_MAX_SUBS    4
+#define FAN_LINK_PAYLOAD_LEN 64     // Including terminator
+
+// ===========================================
+// Types
+// ===========================================
+
+// Called when an activation ends - confirmed is false on timeout
+typedef void (*FanLinkEndFn)(bool on, bool confirmed);
+
+// Called with a message on a topic added by fanLinkSubscribe()
+typedef void (*FanLinkMessageFn)(const char* topic, const char* payload);
+
+// ===========================================
+// State
+// ===========================================
+
+static WiFiClient _flWifiClient;
+static PubSubClient _flClient(_flWifiClient);
+static FanLinkEndFn _flOnEnd = nullptr;
+static unsigned long _flLastConnectAttempt = 0;
+static bool _flEverConnected = false;
+
+// Extra subscriptions (topic strings must outlive the link)
+static const char* _flSubTopics[FAN_LINK_MAX_SUBS];
+static FanLinkMessageFn _flSubHandlers[FAN_LINK_MAX_SUBS];
+static uint8_t _flSubCount = 0;
+
+// Last status reported by the fan node: -1 unknown, 0 off, 1 on
+static int8_t _flFanStatus = -1;
+
+// Current activation
+static bool _flActive = false;
+static bool _flTarget = false;
+static unsigned long _flStartMs = 0;
+static uint32_t _flStartFrames = 0;
+
+// Stats
+static uint32_t _flActivations = 0;
+static uint32_t _flConfirmed = 0;
+static uint32_t _flTimeouts = 0;
+static uint32_t _flReconnects = 0;
+static uint32_t _flConfirmTotalMs = 0;
+static uint32_t _flConfirmMaxMs = 0;
+static uint32_t _flLastConfirmMs = 0;
+static uint32_t _flFramesTotal = 0;
+static uint32_t _flFramesMax = 0;
+static uint32_t _flLastFrames = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static void _flPublishBlasting(bool blasting) {
+    if (_flClient.connected()) {
+        _flClient.publish(FAN_TOPIC_BLASTING, blasting ? "1" : "0");
+    }
+}
+
+static void _flFinish(bool confirmed) {
+    if (!_flActive) return;
+    _flActive = false;
+
+    uint32_t elapsed = millis() - _flStartMs;
+    uint32_t frames = irSchedSent() - _flStartFrames;
+    _flLastFrames = frames;
+    _flFramesTotal += frames;
+    if (frames > _flFramesMax) _flFramesMax = frames;
+
+    Serial.print("[Fan] ");
+    Serial.print(_flTarget ? "ON" : "OFF");
+    if (confirmed) {
+        _flConfirmed++;
+        _flLastConfirmMs = elapsed;
+        _flConfirmTotalMs += elapsed;
+        if (elapsed > _flConfirmMaxMs) _flConfirmMaxMs = elapsed;
+        Serial.print(" confirmed in ");
+    } else {
+        _flTimeouts++;
+        Serial.print(" not confirmed, gave up after ");
+    }
+    Serial.print(elapsed);
+    Serial.print(" ms, ");
+    Serial.print(frames);
+    Serial.println(" frames");
+
+    _flPublishBlasting(false);
+    if (_flOnEnd) _flOnEnd(_flTarget, confirmed);
+}
+
+static void _flCallback(char* topic, uint8_t* payload, unsigned int length) {
+    if (strcmp(topic, FAN_TOPIC_STATUS) != 0) {
+        for (int i = 0; i < _flSubCount; i++) {
+            if (strcmp(topic, _flSubTopics[i]) != 0) continue;
+            char text[FAN_LINK_PAYLOAD_LEN];
+            if (length >= sizeof(text)) length = sizeof(text) - 1;
+            memcpy(text, payload, length);
+            text[length] = '\0';
+            _flSubHandlers[i](topic, text);
+        }
+        return;
+    }
+
+    bool on;
+    if (length == 2 && memcmp(payload, "on", 2) == 0) {
+        on = true;
+    } else if (length == 3 && memcmp(payload, "off", 3) == 0) {
+        on = false;
+    } else {
+        return;
+    }
+
+    _flFanStatus = on ? 1 : 0;
+    Serial.print("[Fan] Status: ");
+    Serial.println(on ? "on" : "off");
+
+    if (_flActive && on == _flTarget) {
+        _flFinish(true);
+    }
+}
+
+static void _flConnect() {
+    unsigned long start = millis();
+    _flLastConnectAttempt = start;
+    // Last will: tell the fan node we stopped blasting if we vanish
+    if (_flClient.connect(FAN_MQTT_CLIENT_ID, FAN_TOPIC_BLASTING, 0, false, "0")) {
+        if (_flEverConnected) _flReconnects++;
+        _flEverConnected = true;
+        _flClient.subscribe(FAN_TOPIC_STATUS);
+        for (int i = 0; i < _flSubCount; i++) {
+            _flClient.subscribe(_flSubTopics[i]);
+        }
+        Serial.println("[Fan] MQTT connected");
+        // Catch the fan node up on an activation already in progress
+        if (_flActive) _flPublishBlasting(true);
+    } else {
+        Serial.print("[Fan] MQTT connect failed, rc=");
+        Serial.print(_flClient.state());
+        Serial.print(" (");
+        Serial.print(millis() - start);
+        Serial.println(" ms)");
+    }
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+// server must outlive the link - PubSubClient keeps the pointer
+void fanLinkInit(const char* server, FanLinkEndFn onEnd) {
+    _flOnEnd = onEnd;
+
+    // A host name would be looked up on every connect, blocking loop()
+    // for as long as DNS takes
+    IPAddress ip;
+    if (ip.fromString(server)) {
+        _flClient.setServer(ip, FAN_MQTT_PORT);
+    } else {
+        Serial.println("[Fan] Broker is a host name - each connect waits on DNS");
+        _flClient.setServer(server, FAN_MQTT_PORT);
+    }
+    _flWifiClient.setConnectionTimeout(FAN_MQTT_CONNECT_TIMEOUT_MS);
+    _flClient.setCallback(_flCallback);
+    _flClient.setSocketTimeout(FAN_MQTT_SOCKET_TIMEOUT_S);
+    // First connect on the next poll
+    _flLastConnectAttempt = millis() - FAN_MQTT_RECONNECT_MS;
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void fanLinkPoll() {
+    unsigned long now = millis();
+
+    if (_flClient.connected()) {
+        _flClient.loop();
+    } else {
+        _flFanStatus = -1;
+        if (WiFi.status() == WL_CONNECTED &&
+            now - _flLastConnectAttempt >= FAN_MQTT_RECONNECT_MS) {
+            _flConnect();
+        }
+    }
+
+    // Already in the target state - no status message will come
+    if (_flActive && _flFanStatus == (_flTarget ? 1 : 0)) {
+        Serial.println("[Fan] Already in that state");
+        _flFinish(true);
+        return;
+    }
+
+    if (_flActive && now - _flStartMs >= FAN_CONFIRM_TIMEOUT_MS) {
+        _flFinish(false);
+    }
+}
+
+// ===========================================
+// Activations
+// ===========================================
+
+// The blaster starts trying to turn the fan on (or off)
+void fanLinkStart(bool on) {
+    if (_flActive && _flTarget == on) return;
+    _flActive = true;
+    _flTarget = on;
+    _flStartMs = millis();
+    _flStartFrames = irSchedSent();
+    _flActivations++;
+    _flPublishBlasting(true);
+}
+
+// The blaster was stopped by hand - not counted as confirmed or timed out
+void fanLinkEnd() {
+    if (!_flActive) return;
+    _flActive = false;
+    _flPublishBlasting(false);
+}
+
+// ===========================================
+// Shared connection
+// ===========================================
+
+// Adds a topic for another module. Returns false if the table is full.
+bool fanLinkSubscribe(const char* topic, FanLinkMessageFn handler) {
+    if (_flSubCount >= FAN_LINK_MAX_SUBS) return false;
+    _flSubTopics[_flSubCount] = topic;
+    _flSubHandlers[_flSubCount] = handler;
+    _flSubCount++;
+    if (_flClient.connected()) _flClient.subscribe(topic);
+    return true;
+}
+
+// Returns false if not connected
+bool fanLinkPublish(const char* topic, const char* payload, bool retained = false) {
+    if (!_flClient.connected()) return false;
+    return _flClient.publish(topic, payload, retained);
+}
+
+// ===========================================
+// Status / stats
+// ===========================================
+
+bool fanLinkConnected() {
+    return _flClient.connected();
+}
+
+bool fanLinkActive() {
+    return _flActive;
+}
+
+// -1 unknown, 0 off, 1 on
+int fanLinkFanStatus() {
+    return _flFanStatus;
+}
+
+void fanLinkPrintStats() {
+    Serial.print("Fan link: MQTT ");
+    Serial.print(_flClient.connected() ? "connected" : "disconnected");
+    Serial.print(" (");
+    Serial.print(_flReconnects);
+    Serial.print(" reconnects), fan ");
+    Serial.println(_flFanStatus < 0 ? "unknown" : (_flFanStatus ? "on" : "off"));
+
+    uint32_t ended = _flConfirmed + _flTimeouts;
+    Serial.print("  Activations: ");
+    Serial.print(_flActivations);
+    Serial.print(", ");
+    Serial.print(_flConfirmed);
+    Serial.print(" confirmed, ");
+    Serial.print(_flTimeouts);
+    Serial.println(" timed out");
+
+    Serial.print("  Time to confirm: avg ");
+    Serial.print(_flConfirmed > 0 ? _flConfirmTotalMs / _flConfirmed : 0);
+    Serial.print(" ms, max ");
+    Serial.print(_flConfirmMaxMs);
+    Serial.print(" ms, last ");
+    Serial.print(_flLastConfirmMs);
+    Serial.println(" ms");
+
+    Serial.print("  Frames per activation: avg ");
+    Serial.print(ended > 0 ? (float)_flFramesTotal / ended : 0.0, 1);
+    Serial.print(", max ");
+    Serial.print(_flFramesMax);
+    Serial.print(", last ");
+    Serial.println(_flLastFrames);
+}
+
+#endif // FAN_LINK_H
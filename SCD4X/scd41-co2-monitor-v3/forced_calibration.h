@@ -1,26 +1,59 @@
 /*
  * Forced Recalibration Module for SCD41
- * 
+ *
  * Provides manual calibration via BOOT button when automatic self-calibration
  * isn't sufficient or you need a quick correction.
- * 
+ *
  * Usage:
  *   1. Take sensor outside to fresh air
  *   2. Hold BOOT button for 3 seconds
- *   3. Wait 5 minutes for warmup (LED blinks for each reading)
+ *   3. Wait 3-5 minutes for warmup (LED blinks for each reading)
  *   4. Calibration completes automatically
- * 
+ *
+ * The button itself is read by button_input.h - the sketch calls
+ * frcStartButton() on a FRC_HOLD_TIME_MS long press. Or start it remotely
+ * with frcStart(reference, warmupMs) - e.g. next to a reference instrument
+ * indoors - and stop it with frcCancel(). The button always uses
+ * FRC_REFERENCE_PPM and FRC_WARMUP_DURATION_MS.
+ *
  * This module is designed for sensors running in periodic measurement mode.
- * It stops periodic measurement, runs warmup in single-shot mode, performs
- * FRC, then the caller should restart periodic measurement.
+ * With FRC_USE_PERIODIC (default) the sensor keeps measuring every 5 s
+ * through the warmup and is stopped only for the FRC command itself - 36
+ * readings per 3 minute window instead of 6. With FRC_USE_PERIODIC 0 it
+ * stops periodic measurement and warms up with a single-shot reading every
+ * 30 s. Either way it restarts periodic measurement when done.
+ *
+ * Calibration is a state machine advanced by frcCheckButton() from the
+ * main loop, one short step per call:
+ *
+ *   periodic:    IDLE -> WARMUP -> STOP_PERIODIC -> CALIBRATE -> RESTART
+ *   single-shot: IDLE -> STOP_PERIODIC -> WARMUP -> CALIBRATE -> RESTART
+ *
+ * Warmup ends as soon as the readings have converged - the readings in
+ * the last FRC_CONV_WINDOW_MS vary by less than FRC_CONV_STD_PPM and drift by
+ * less than FRC_CONV_SLOPE_PPM_MIN - but never before FRC_MIN_WARMUP_MS
+ * (datasheet minimum) and never after the warmup length. Readings
+ * that a Hampel filter flags against the window's median are rejected.
+ * The reference average is the mean of that final window, not of every
+ * reading since power-up. If it's clearly not outdoor air, calibration is
+ * refused.
+ *
+ * Nothing waits out the warmup, so uploads, IR and serial commands keep
+ * running. The slow sensor commands - stop (500 ms), FRC (400 ms),
+ * single-shot (5 s) - go through scd4x_async.h and are polled for, not
+ * slept on. While frcActive() the sensor belongs to this module - the
+ * caller must not read it. Warmup readings are handed to the caller
+ * through frcTakeWarmupReading() so they can be uploaded, tagged.
  */
 
 #ifndef FORCED_CALIBRATION_H
 #define FORCED_CALIBRATION_H
 
 #include <Arduino.h>
+#include <Wire.h>
 #include <SensirionI2cScd4x.h>
-#include <esp_task_wdt.h>
+#include "scd4x_async.h"
+#include "i2c_telemetry.h"
 
 // ===========================================
 // Configuration
@@ -40,30 +73,184 @@
 // Hold button this long to trigger FRC
 #define FRC_HOLD_TIME_MS 3000
 
-// Warmup duration - datasheet requires minimum 3 minutes
-// Using 5 minutes for better stabilization
+// Warmup duration - datasheet requires minimum 3 minutes. Ends between
+// the two once the readings converge.
+#define FRC_MIN_WARMUP_MS      180000
 #define FRC_WARMUP_DURATION_MS 300000
 
-// Take a reading every 30 seconds during warmup
+// Limits for a remotely supplied reference and warmup length
+#define FRC_MIN_REFERENCE_PPM  400
+#define FRC_MAX_REFERENCE_PPM  2000
+#define FRC_MAX_WARMUP_MS      1800000
+
+// 1 = warm up in periodic mode (5 s readings), 0 = single-shot every 30 s
+#define FRC_USE_PERIODIC 1
+
+// Take a single-shot reading every 30 seconds during warmup
 #define FRC_WARMUP_INTERVAL_MS 30000
 
+// Periodic mode: the sensor updates every 5 s, data-ready is polled this often
+#define FRC_PERIODIC_INTERVAL_MS 5000
+#define FRC_READY_POLL_MS        250
+
+#if FRC_USE_PERIODIC
+#define FRC_SAMPLE_INTERVAL_MS FRC_PERIODIC_INTERVAL_MS
+// Every 6th periodic reading is what a single-shot warmup would have seen
+#define FRC_SUBSAMPLE_STRIDE   (FRC_WARMUP_INTERVAL_MS / FRC_PERIODIC_INTERVAL_MS)
+#else
+#define FRC_SAMPLE_INTERVAL_MS FRC_WARMUP_INTERVAL_MS
+#endif
+
+// Convergence: window of recent readings, max std dev and drift
+#define FRC_CONV_WINDOW_MS     180000
+#define FRC_CONV_WINDOW        (FRC_CONV_WINDOW_MS / FRC_SAMPLE_INTERVAL_MS)
+#define FRC_CONV_STD_PPM       8.0
+#define FRC_CONV_SLOPE_PPM_MIN 3.0
+
+// Hampel filter: reject readings more than K scaled MADs from the window
+// median (the MAD floor keeps a very quiet window from rejecting everything)
+#define FRC_HAMPEL_K           3.0
+#define FRC_HAMPEL_MIN_MAD_PPM 5.0
+#define FRC_HAMPEL_MIN_SAMPLES 3
+
+// This many rejections in a row is a level shift, not noise - start the
+// window over from the new level
+#define FRC_HAMPEL_MAX_REJECTS 3
+
+// Refuse to calibrate unless the window mean looks like outdoor air. With
+// another reference the range moves by the same amount.
+#define FRC_OUTDOOR_MIN_PPM 350
+#define FRC_OUTDOOR_MAX_PPM 600
+
+// ===========================================
+// Types
+// ===========================================
+
+enum FRCState {
+    FRC_IDLE = 0,
+    FRC_STOP_PERIODIC,    // Waiting out stop_periodic_measurement
+    FRC_WARMUP,           // Readings towards the reference average
+    FRC_CALIBRATE,        // Waiting out perform_forced_recalibration
+    FRC_RESTART           // Restart periodic measurement
+};
+
+enum FRCResultCode {
+    FRC_RESULT_OK = 0,
+    FRC_RESULT_FAILED,    // Sensor rejected or didn't answer the FRC command
+    FRC_RESULT_REFUSED,   // Warmup average wasn't outdoor air
+    FRC_RESULT_CANCELLED  // frcCancel() during warmup
+};
+
+// Outcome of the last calibration, for history / upload
+struct FRCResult {
+    FRCResultCode result;
+    uint16_t reference;       // ppm
+    int16_t correction;       // ppm applied by the sensor (0 unless OK)
+    float avgCO2;             // Reference average (window mean)
+    float noise;              // Window std dev
+    float stdError;           // Std error of the average
+    uint16_t readings;        // Readings in the final window
+    uint16_t outliers;        // Rejected by the Hampel filter
+    uint32_t convergedMs;     // Warmup time until convergence
+};
+
 // ===========================================
 // State
 // ===========================================
 
 static bool _frcInitialized = false;
 
+static FRCState _frcState = FRC_IDLE;
+static unsigned long _frcStateStart = 0;
+static bool _frcStopped = false;       // Periodic measurement stopped by us
+static FRCState _frcAfterStop = FRC_WARMUP;
+static Scd4xFuture _frcCmd = {};       // Stop, FRC or single-shot in flight
+
+// This calibration's parameters - set by the button or frcStart()
+static uint16_t _frcReference = FRC_REFERENCE_PPM;
+static unsigned long _frcWarmupMs = FRC_WARMUP_DURATION_MS;
+static bool _frcRemote = false;
+static bool _frcStartRequested = false;
+static bool _frcCancelRequested = false;
+
+// Warmup
+static unsigned long _frcWarmupStart = 0;
+static unsigned long _frcNextShotMs = 0;
+static bool _frcShotPending = false;
+static unsigned long _frcLastPollMs = 0;
+static unsigned long _frcLastDisplayMs = 0;
+static int _frcReadingCount = 0;
+static float _frcAvgCO2 = 0;
+static uint16_t _frcLastCO2 = 0;
+static bool _frcSucceeded = false;
+static FRCResult _frcResult = {};
+
+// Convergence window (ring of accepted readings)
+static uint16_t _frcWindowCO2[FRC_CONV_WINDOW];
+static unsigned long _frcWindowMs[FRC_CONV_WINDOW];
+static uint8_t _frcWindowHead = 0;
+static uint8_t _frcWindowCount = 0;
+static int _frcOutliers = 0;
+static int _frcRejectRun = 0;
+static bool _frcConverged = false;
+static unsigned long _frcConvergedMs = 0;    // Warmup time until convergence
+static float _frcNoise = 0;                  // Window std dev at the end of warmup
+static float _frcStdError = 0;               // Std error of the reference average
+
+// Latest warmup reading, until the caller takes it
+static bool _frcReadingPending = false;
+static uint16_t _frcPendingCO2 = 0;
+static float _frcPendingTemp = 0;
+static float _frcPendingHumidity = 0;
+
+// LED flash pattern in progress
+static int _frcLedFlashes = 0;
+static int _frcLedOnMs = 0;
+static int _frcLedOffMs = 0;
+static bool _frcLedLit = false;
+static unsigned long _frcLedNextMs = 0;
+
+// ===========================================
+// Result
+// ===========================================
+
+const char* frcResultName(uint8_t result) {
+    switch (result) {
+        case FRC_RESULT_OK:        return "ok";
+        case FRC_RESULT_FAILED:    return "failed";
+        case FRC_RESULT_REFUSED:   return "refused";
+        case FRC_RESULT_CANCELLED: return "cancelled";
+        default:                   return "unknown";
+    }
+}
+
+// Fills in _frcResult from the warmup stats
+static void _frcSetResult(FRCResultCode result, int16_t correction) {
+    _frcResult.result = result;
+    _frcResult.reference = _frcReference;
+    _frcResult.correction = correction;
+    _frcResult.avgCO2 = _frcAvgCO2;
+    _frcResult.noise = _frcNoise;
+    _frcResult.stdError = _frcStdError;
+    _frcResult.readings = _frcWindowCount;
+    _frcResult.outliers = _frcOutliers;
+    _frcResult.convergedMs = _frcConvergedMs;
+}
+
 // ===========================================
 // LED helpers
 // ===========================================
 
+// A flash pattern is started here and played by _frcLedPoll() from
+// frcCheckButton(), so the state machine never waits on the LED. A new
+// pattern replaces one still playing.
 static void _frcFlashLED(int times, int onMs = 100, int offMs = 100) {
-    for (int i = 0; i < times; i++) {
-        digitalWrite(FRC_LED_PIN, HIGH);
-        delay(onMs);
-        digitalWrite(FRC_LED_PIN, LOW);
-        if (i < times - 1) delay(offMs);
-    }
+    _frcLedFlashes = times;
+    _frcLedOnMs = onMs;
+    _frcLedOffMs = offMs;
+    _frcLedLit = false;
+    _frcLedNextMs = millis();
+    digitalWrite(FRC_LED_PIN, LOW);
 }
 
 static void _frcSlowFlash(int times) {
@@ -74,6 +261,20 @@ static void _frcRapidFlash(int times) {
     _frcFlashLED(times, 80, 80);
 }
 
+static void _frcLedPoll(unsigned long now) {
+    if (_frcLedFlashes == 0 || (long)(now - _frcLedNextMs) < 0) return;
+    if (!_frcLedLit) {
+        digitalWrite(FRC_LED_PIN, HIGH);
+        _frcLedLit = true;
+        _frcLedNextMs = now + _frcLedOnMs;
+    } else {
+        digitalWrite(FRC_LED_PIN, LOW);
+        _frcLedLit = false;
+        _frcLedFlashes--;
+        _frcLedNextMs = now + _frcLedOffMs;
+    }
+}
+
 // ===========================================
 // Callback type for event logging
 // ===========================================
@@ -91,296 +292,699 @@ typedef bool (*FRCEventCallback)(int eventType, const char* message);
 // Called at start, after each reading, and every second during wait intervals
 typedef void (*FRCDisplayCallback)(
     unsigned long remainingMs,    // Time remaining in warmup
-    unsigned long totalMs,        // Total warmup duration (FRC_WARMUP_DURATION_MS)
+    unsigned long totalMs,        // Total warmup duration
     int readingCount,             // Number of readings taken so far
     uint16_t currentCO2,          // Latest CO2 reading (0 if no reading yet)
     float avgCO2                  // Running average CO2
 );
 
 // ===========================================
-// Initialize - call in setup()
+// Helpers
 // ===========================================
 
-void frcInit() {
-    pinMode(FRC_BUTTON_PIN, INPUT_PULLUP);
-    _frcInitialized = true;
-    Serial.println("[FRC] Module initialized");
-    Serial.print("[FRC] Hold BOOT button ");
-    Serial.print(FRC_HOLD_TIME_MS / 1000);
-    Serial.println(" seconds to calibrate");
+static float _frcMedian(float* values, int n) {
+    // Insertion sort - n is at most FRC_CONV_WINDOW
+    for (int i = 1; i < n; i++) {
+        float v = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > v) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = v;
+    }
+    return (n & 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
 }
 
-// ===========================================
-// Main check - call at start of loop()
-// Returns true if FRC was performed
-// 
-// IMPORTANT: After this returns true, caller must restart
-// periodic measurement with sensor.startPeriodicMeasurement()
-// ===========================================
+// Hampel test against the current window
+static bool _frcIsOutlier(uint16_t co2) {
+    int n = _frcWindowCount;
+    if (n < FRC_HAMPEL_MIN_SAMPLES) return false;
 
-bool frcCheckButton(SensirionI2cScd4x &sensor, FRCEventCallback logEvent = nullptr,
-                    FRCDisplayCallback displayUpdate = nullptr) {
-    if (!_frcInitialized) return false;
-    
-    // Check if button is pressed (active low)
-    if (digitalRead(FRC_BUTTON_PIN) != LOW) {
-        return false;
+    float values[FRC_CONV_WINDOW];
+    for (int i = 0; i < n; i++) values[i] = _frcWindowCO2[i];
+    float median = _frcMedian(values, n);
+    for (int i = 0; i < n; i++) values[i] = fabs((float)_frcWindowCO2[i] - median);
+    float mad = 1.4826 * _frcMedian(values, n);
+    if (mad < FRC_HAMPEL_MIN_MAD_PPM) mad = FRC_HAMPEL_MIN_MAD_PPM;
+
+    return fabs((float)co2 - median) > FRC_HAMPEL_K * mad;
+}
+
+static void _frcWindowAdd(uint16_t co2, unsigned long ms) {
+    _frcWindowCO2[_frcWindowHead] = co2;
+    _frcWindowMs[_frcWindowHead] = ms;
+    _frcWindowHead = (_frcWindowHead + 1) % FRC_CONV_WINDOW;
+    if (_frcWindowCount < FRC_CONV_WINDOW) _frcWindowCount++;
+}
+
+// Mean, std dev and least-squares slope (ppm/min) of the window
+static void _frcWindowStats(float &mean, float &stdDev, float &slope) {
+    int n = _frcWindowCount;
+    mean = stdDev = slope = 0;
+    if (n == 0) return;
+
+    unsigned long t0 = _frcWindowMs[0];
+    for (int i = 1; i < n; i++) {
+        if ((long)(_frcWindowMs[i] - t0) < 0) t0 = _frcWindowMs[i];
     }
-    
-    // Button pressed - wait for hold duration
-    Serial.println("[FRC] Button pressed, hold 3 seconds to calibrate...");
-    
-    unsigned long pressStart = millis();
-    int dots = 0;
-    
-    while (digitalRead(FRC_BUTTON_PIN) == LOW) {
-        unsigned long held = millis() - pressStart;
-
-        // Keep watchdog happy during button hold
-        esp_task_wdt_reset();
-
-        // Progress dots
-        if (held / 500 > dots) {
-            Serial.print(".");
-            dots++;
-        }
 
-        if (held >= FRC_HOLD_TIME_MS) {
-            Serial.println(" GO!");
-            break;
+    float sumT = 0, sumP = 0, sumTT = 0, sumTP = 0;
+    for (int i = 0; i < n; i++) {
+        float t = (_frcWindowMs[i] - t0) / 60000.0;
+        float p = _frcWindowCO2[i];
+        sumT += t;
+        sumP += p;
+        sumTT += t * t;
+        sumTP += t * p;
+    }
+    mean = sumP / n;
+
+    float var = 0;
+    for (int i = 0; i < n; i++) {
+        float d = _frcWindowCO2[i] - mean;
+        var += d * d;
+    }
+    stdDev = n > 1 ? sqrt(var / (n - 1)) : 0;
+
+    float denom = n * sumTT - sumT * sumT;
+    if (denom > 0) slope = (n * sumTP - sumT * sumP) / denom;
+}
+
+#if FRC_USE_PERIODIC
+// Mean and std error of every stride-th window reading, oldest first from
+// `phase`. Returns how many readings that took.
+static int _frcSubsampleStats(int phase, int stride, float &mean, float &stdErr) {
+    int n = _frcWindowCount;
+    int oldest = n < FRC_CONV_WINDOW ? 0 : _frcWindowHead;
+    mean = stdErr = 0;
+
+    int count = 0;
+    float sum = 0;
+    for (int i = phase; i < n; i += stride) {
+        sum += _frcWindowCO2[(oldest + i) % FRC_CONV_WINDOW];
+        count++;
+    }
+    if (count == 0) return 0;
+    mean = sum / count;
+
+    float var = 0;
+    for (int i = phase; i < n; i += stride) {
+        float d = _frcWindowCO2[(oldest + i) % FRC_CONV_WINDOW] - mean;
+        var += d * d;
+    }
+    if (count > 1) stdErr = sqrt(var / (count - 1)) / sqrt((float)count);
+    return count;
+}
+#endif
+
+static void _frcEnter(FRCState state) {
+    _frcState = state;
+    _frcStateStart = millis();
+}
+
+// Sends stop_periodic_measurement; STOP_PERIODIC moves on to next once
+// the sensor is idle
+static void _frcStopPeriodic(FRCState next) {
+    if (!scd4xIssue(SCD4X_STOP_PERIODIC, _frcCmd)) {
+        Serial.print("[FRC] stopPeriodicMeasurement error: ");
+        Serial.println(_frcCmd.error);
+        // Continue anyway - might not have been running
+    }
+    _frcStopped = true;
+    _frcAfterStop = next;
+    _frcEnter(FRC_STOP_PERIODIC);
+}
+
+// Sends perform_forced_recalibration; CALIBRATE collects the correction
+static void _frcStartCalibration() {
+    Serial.println("[FRC] Performing forced recalibration...");
+    _frcSlowFlash(3);
+    scd4xIssueWithArg(SCD4X_PERFORM_FRC, _frcReference, _frcCmd);
+    _frcEnter(FRC_CALIBRATE);
+}
+
+static void _frcBeginWarmup(unsigned long now) {
+    Serial.println("[FRC] Starting warmup...");
+    _frcWarmupStart = now;
+    _frcNextShotMs = now;
+    _frcShotPending = false;
+    _frcLastPollMs = now;
+    _frcLastDisplayMs = now;
+    _frcReadingCount = 0;
+    _frcAvgCO2 = 0;
+    _frcLastCO2 = 0;
+    _frcWindowHead = 0;
+    _frcWindowCount = 0;
+    _frcOutliers = 0;
+    _frcRejectRun = 0;
+    _frcConverged = false;
+    _frcNoise = 0;
+    _frcStdError = 0;
+    _frcEnter(FRC_WARMUP);
+}
+
+// One warmup reading: hand it over for upload, filter it, update the window
+static void _frcAcceptReading(uint16_t co2, float temp, float humidity, unsigned long now,
+                              FRCDisplayCallback displayUpdate) {
+    unsigned long elapsed = now - _frcWarmupStart;
+    unsigned long remaining = elapsed < _frcWarmupMs ? _frcWarmupMs - elapsed : 0;
+
+    // Uploaded either way - only the average ignores outliers
+    _frcPendingCO2 = co2;
+    _frcPendingTemp = temp;
+    _frcPendingHumidity = humidity;
+    _frcReadingPending = true;
+    _frcLastCO2 = co2;
+
+    if (_frcIsOutlier(co2)) {
+        if (++_frcRejectRun < FRC_HAMPEL_MAX_REJECTS) {
+            _frcOutliers++;
+            Serial.print("[FRC] Outlier rejected: CO2=");
+            Serial.println(co2);
+            return;
         }
+        Serial.println("[FRC] Level shift, restarting window");
+        _frcWindowCount = 0;
+        _frcWindowHead = 0;
+    }
+    _frcRejectRun = 0;
+
+    _frcReadingCount++;
+    _frcWindowAdd(co2, now);
 
-        delay(50);
+    float stdDev, slope;
+    _frcWindowStats(_frcAvgCO2, stdDev, slope);
+
+    if (!_frcConverged && _frcWindowCount >= FRC_CONV_WINDOW &&
+        elapsed >= FRC_MIN_WARMUP_MS && stdDev < FRC_CONV_STD_PPM &&
+        fabs(slope) < FRC_CONV_SLOPE_PPM_MIN) {
+        _frcConverged = true;
+        _frcConvergedMs = elapsed;
     }
-    
-    // Released too early?
-    if (digitalRead(FRC_BUTTON_PIN) != LOW && (millis() - pressStart) < FRC_HOLD_TIME_MS) {
-        Serial.println("\n[FRC] Released too early, cancelled");
-        return false;
+
+    Serial.print("[FRC] Reading ");
+    Serial.print(_frcReadingCount);
+    Serial.print(": CO2=");
+    Serial.print(co2);
+    Serial.print(" ppm (avg=");
+    Serial.print((int)_frcAvgCO2);
+    Serial.print(", sd=");
+    Serial.print(stdDev, 1);
+    Serial.print(", slope=");
+    Serial.print(slope, 1);
+    Serial.print(") | ");
+    Serial.print(remaining / 1000);
+    Serial.println("s remaining");
+
+    // Update display after reading
+    if (displayUpdate) {
+        displayUpdate(remaining, _frcWarmupMs, _frcReadingCount, co2, _frcAvgCO2);
+        _frcLastDisplayMs = now;
     }
-    
-    // ========================================
-    // FRC TRIGGERED
-    // ========================================
-    
+
+    _frcFlashLED(1, 100, 0);
+}
+
+static void _frcAnnounce(FRCEventCallback logEvent, FRCDisplayCallback displayUpdate) {
     Serial.println();
     Serial.println("[FRC] ========================================");
-    Serial.println("[FRC] FORCED RECALIBRATION STARTING");
+    Serial.println(_frcRemote ? "[FRC] FORCED RECALIBRATION STARTING (remote)" :
+                                "[FRC] FORCED RECALIBRATION STARTING");
     Serial.print("[FRC] Reference: ");
-    Serial.print(FRC_REFERENCE_PPM);
+    Serial.print(_frcReference);
     Serial.println(" ppm");
-    Serial.print("[FRC] Warmup: ");
-    Serial.print(FRC_WARMUP_DURATION_MS / 60000);
-    Serial.println(" minutes");
-    Serial.println("[FRC] Keep sensor in fresh outdoor air!");
+    Serial.print("[FRC] Warmup: up to ");
+    Serial.print(_frcWarmupMs / 1000);
+    Serial.println(" seconds");
+    Serial.println(_frcReference == FRC_REFERENCE_PPM ? "[FRC] Keep sensor in fresh outdoor air!" :
+                                                        "[FRC] Keep sensor next to the reference!");
     Serial.println("[FRC] ========================================");
-    
+
     // Acknowledge: 5 quick flashes
     _frcFlashLED(5, 150, 150);
-    
+
     if (logEvent) {
         char msg[96];
-        snprintf(msg, sizeof(msg), "FRC started - %d min warmup, %d ppm reference",
-                 FRC_WARMUP_DURATION_MS / 60000, FRC_REFERENCE_PPM);
+        snprintf(msg, sizeof(msg), "FRC started (%s) - up to %lus warmup, %d ppm reference",
+                 _frcRemote ? "remote" : "button", _frcWarmupMs / 1000, _frcReference);
         logEvent(FRC_EVENT_INFO, msg);
     }
 
     // Initial display update
     if (displayUpdate) {
-        displayUpdate(FRC_WARMUP_DURATION_MS, FRC_WARMUP_DURATION_MS, 0, 0, 0);
+        displayUpdate(_frcWarmupMs, _frcWarmupMs, 0, 0, 0);
     }
+}
 
-    // ========================================
-    // STOP PERIODIC MEASUREMENT
-    // ========================================
-    
-    int16_t error = sensor.stopPeriodicMeasurement();
-    if (error != 0) {
-        Serial.print("[FRC] stopPeriodicMeasurement error: ");
-        Serial.println(error);
-        // Continue anyway - might not have been running
+// Announce, then either warm up in periodic mode or stop it for single-shot
+static void _frcBegin(FRCEventCallback logEvent, FRCDisplayCallback displayUpdate) {
+    _frcAnnounce(logEvent, displayUpdate);
+
+#if FRC_USE_PERIODIC
+    // Keep measuring - periodic mode is stopped only for the FRC command
+    _frcBeginWarmup(millis());
+#else
+    _frcStopPeriodic(FRC_WARMUP);
+#endif
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void frcInit() {
+    _frcInitialized = true;
+    Serial.println("[FRC] Module initialized");
+    Serial.print("[FRC] Hold BOOT button ");
+    Serial.print(FRC_HOLD_TIME_MS / 1000);
+    Serial.println(" seconds to calibrate");
+}
+
+// ===========================================
+// Remote start / cancel
+// ===========================================
+
+// Starts a calibration from the next frcCheckButton() call. warmupMs = 0
+// uses FRC_WARMUP_DURATION_MS; convergence can still end it earlier.
+// Returns false if one is already running or the values are out of range.
+bool frcStart(uint16_t referencePpm, unsigned long warmupMs = 0) {
+    if (_frcState != FRC_IDLE || _frcStartRequested) return false;
+    if (referencePpm < FRC_MIN_REFERENCE_PPM || referencePpm > FRC_MAX_REFERENCE_PPM) return false;
+    if (warmupMs == 0) warmupMs = FRC_WARMUP_DURATION_MS;
+    if (warmupMs < FRC_MIN_WARMUP_MS || warmupMs > FRC_MAX_WARMUP_MS) return false;
+
+    _frcReference = referencePpm;
+    _frcWarmupMs = warmupMs;
+    _frcRemote = true;
+    _frcStartRequested = true;
+    return true;
+}
+
+// Long press - outdoor air at the compile-time reference
+bool frcStartButton() {
+    if (!frcStart(FRC_REFERENCE_PPM)) return false;
+    _frcRemote = false;
+    return true;
+}
+
+// Abandons a calibration before the FRC command is sent. Returns false if
+// there's nothing to cancel.
+bool frcCancel() {
+    if (_frcStartRequested) {
+        _frcStartRequested = false;
+        return true;
     }
-    delay(500);
-    
+    if (_frcState != FRC_STOP_PERIODIC && _frcState != FRC_WARMUP) return false;
+    _frcCancelRequested = true;
+    return true;
+}
+
+// ===========================================
+// Status
+// ===========================================
+
+// True from the start of calibration until periodic measurement is back
+bool frcActive() {
+    return _frcState >= FRC_STOP_PERIODIC;
+}
+
+FRCState frcState() {
+    return _frcState;
+}
+
+const char* frcStateName() {
+    switch (_frcState) {
+        case FRC_STOP_PERIODIC: return "stopping";
+        case FRC_WARMUP:        return "warmup";
+        case FRC_CALIBRATE:     return "calibrating";
+        case FRC_RESTART:       return "restarting";
+        default:                return "idle";
+    }
+}
+
+// Parameters of the current (or last) calibration
+uint16_t frcReference() {
+    return _frcReference;
+}
+
+bool frcRemote() {
+    return _frcRemote;
+}
+
+// Warmup progress, for remote reporting
+void frcProgress(unsigned long &elapsedMs, unsigned long &totalMs, int &readings, float &avgCO2) {
+    elapsedMs = _frcState == FRC_WARMUP ? millis() - _frcWarmupStart : 0;
+    totalMs = _frcWarmupMs;
+    readings = _frcReadingCount;
+    avgCO2 = _frcAvgCO2;
+}
+
+// Hands over the latest warmup reading once, for upload
+bool frcTakeWarmupReading(uint16_t &co2, float &temp, float &humidity) {
+    if (!_frcReadingPending) return false;
+    _frcReadingPending = false;
+    co2 = _frcPendingCO2;
+    temp = _frcPendingTemp;
+    humidity = _frcPendingHumidity;
+    return true;
+}
+
+// ===========================================
+// Main step - call every loop pass
+// Returns true once, when a calibration has finished and periodic
+// measurement is running again
+// ===========================================
+
+bool frcCheckButton(SensirionI2cScd4x &sensor, FRCEventCallback logEvent = nullptr,
+                    FRCDisplayCallback displayUpdate = nullptr) {
+    if (!_frcInitialized) return false;
+
+    unsigned long now = millis();
+    int16_t error;
+
+    _frcLedPoll(now);
+
+    if (_frcCancelRequested) {
+        _frcCancelRequested = false;
+        if (_frcState == FRC_STOP_PERIODIC || _frcState == FRC_WARMUP) {
+            Serial.println("[FRC] Cancelled");
+            _frcShotPending = false;
+            _frcSucceeded = false;
+            _frcSetResult(FRC_RESULT_CANCELLED, 0);
+            if (logEvent) logEvent(FRC_EVENT_WARNING, "FRC cancelled during warmup");
+            _frcEnter(FRC_RESTART);
+            return false;
+        }
+    }
+
+    switch (_frcState) {
+
+    case FRC_IDLE:
+        if (_frcStartRequested) {
+            _frcStartRequested = false;
+            _frcBegin(logEvent, displayUpdate);
+        }
+        return false;
+
     // ========================================
-    // WARMUP PHASE
+    // STOP PERIODIC - wait out the stop, then single-shot warmup or FRC
     // ========================================
-    
-    Serial.println("[FRC] Starting warmup...");
-    
-    unsigned long warmupStart = millis();
-    int readingCount = 0;
-    float avgCO2 = 0;
-    bool warmupSuccess = true;
-    
-    while (millis() - warmupStart < FRC_WARMUP_DURATION_MS) {
-        unsigned long elapsed = millis() - warmupStart;
-        unsigned long remaining = FRC_WARMUP_DURATION_MS - elapsed;
-
-        // Keep watchdog happy during 5-minute warmup
-        esp_task_wdt_reset();
-
-        // Single-shot measurement
-        uint16_t co2 = 0;
-        float temp = 0, humidity = 0;
-        
-        error = sensor.measureSingleShot();
-        if (error != 0) {
-            Serial.print("[FRC] measureSingleShot error: ");
-            Serial.println(error);
-            _frcFlashLED(2, 50, 50);
+
+    case FRC_STOP_PERIODIC:
+        if (scd4xBusy()) return false;
+        scd4xCollect(_frcCmd);
+        if (_frcAfterStop == FRC_CALIBRATE) {
+            _frcStartCalibration();
         } else {
-            // Wait for measurement (~5 seconds)
-            delay(5000);
-            
+            _frcBeginWarmup(now);
+        }
+        return false;
+
+    // ========================================
+    // WARMUP - every periodic reading, or a single-shot reading every
+    // FRC_WARMUP_INTERVAL_MS
+    // ========================================
+
+    case FRC_WARMUP: {
+        unsigned long elapsed = now - _frcWarmupStart;
+
+        if ((_frcConverged || elapsed >= _frcWarmupMs) && !_frcShotPending) {
+            float mean, slope;
+            _frcWindowStats(mean, _frcNoise, slope);
+            _frcStdError = _frcWindowCount > 0 ? _frcNoise / sqrt((float)_frcWindowCount) : 0;
+
+            if (_frcConverged) {
+                Serial.print("[FRC] Converged after ");
+                Serial.print(_frcConvergedMs / 1000);
+                Serial.println("s");
+            } else {
+                Serial.println("[FRC] Warmup complete (not converged)");
+                _frcConvergedMs = elapsed;
+                if (logEvent) {
+                    char msg[96];
+                    snprintf(msg, sizeof(msg), "FRC warmup did not converge: noise %.1f ppm, drift %.1f ppm/min",
+                             _frcNoise, slope);
+                    logEvent(FRC_EVENT_WARNING, msg);
+                }
+            }
+            Serial.print("[FRC] ");
+            Serial.print(_frcReadingCount);
+            Serial.print(" readings (");
+            Serial.print(_frcOutliers);
+            Serial.print(" outliers rejected), average: ");
+            Serial.print((int)_frcAvgCO2);
+            Serial.print(" ppm, noise ");
+            Serial.print(_frcNoise, 1);
+            Serial.println(" ppm");
+
+            // Std error of the average from this window
+            Serial.print("[FRC] Reference average ");
+            Serial.print(mean, 1);
+            Serial.print(" +/-");
+            Serial.print(_frcStdError, 2);
+            Serial.print(" ppm from ");
+            Serial.print(_frcWindowCount);
+            Serial.println(" readings");
+
+#if FRC_USE_PERIODIC
+            // The same window at the single-shot cadence, from the readings
+            // themselves. Each starting offset gives a different 30 s
+            // average; their range is how much a single-shot warmup's
+            // average would depend on when it happened to sample.
+            float subMean, subStdErr;
+            int subCount = _frcSubsampleStats(0, FRC_SUBSAMPLE_STRIDE, subMean, subStdErr);
+            if (subCount >= 2) {
+                float phaseMin = subMean, phaseMax = subMean;
+                for (int phase = 1; phase < FRC_SUBSAMPLE_STRIDE; phase++) {
+                    float m, se;
+                    if (_frcSubsampleStats(phase, FRC_SUBSAMPLE_STRIDE, m, se) == 0) continue;
+                    if (m < phaseMin) phaseMin = m;
+                    if (m > phaseMax) phaseMax = m;
+                }
+                Serial.print("[FRC] 30 s subsample: ");
+                Serial.print(subMean, 1);
+                Serial.print(" +/-");
+                Serial.print(subStdErr, 2);
+                Serial.print(" ppm from ");
+                Serial.print(subCount);
+                Serial.print(" readings, ");
+                Serial.print(FRC_SUBSAMPLE_STRIDE);
+                Serial.print(" offsets give ");
+                Serial.print(phaseMin, 1);
+                Serial.print("-");
+                Serial.print(phaseMax, 1);
+                Serial.println(" ppm");
+            }
+#endif
+
+            // Refuse if this clearly isn't outdoor air (or the reference's air)
+            int shift = (int)_frcReference - FRC_REFERENCE_PPM;
+            int minPpm = FRC_OUTDOOR_MIN_PPM + shift;
+            int maxPpm = FRC_OUTDOOR_MAX_PPM + shift;
+            if (_frcReadingCount == 0 || _frcAvgCO2 < minPpm || _frcAvgCO2 > maxPpm) {
+                Serial.println("[FRC] REFUSED: average too far from reference - calibration skipped");
+                _frcRapidFlash(10);
+                _frcSucceeded = false;
+                _frcSetResult(FRC_RESULT_REFUSED, 0);
+                if (logEvent) {
+                    char msg[96];
+                    snprintf(msg, sizeof(msg), "FRC refused - warmup avg %.0f ppm outside %d-%d for %d ppm reference",
+                             _frcAvgCO2, minPpm, maxPpm, _frcReference);
+                    logEvent(FRC_EVENT_ERROR, msg);
+                }
+                _frcEnter(FRC_RESTART);
+                return false;
+            }
+
+            // Warn if readings differ significantly from reference
+            {
+                float diff = _frcAvgCO2 - _frcReference;
+                if (diff > 100 || diff < -100) {
+                    Serial.print("[FRC] WARNING: Average differs from reference by ");
+                    Serial.print((int)diff);
+                    Serial.println(" ppm");
+                    Serial.println("[FRC] Ensure you're actually in fresh outdoor air!");
+
+                    if (logEvent) {
+                        char msg[96];
+                        snprintf(msg, sizeof(msg), "FRC warmup avg %.0f ppm vs reference %d ppm (diff: %.0f)",
+                                 _frcAvgCO2, _frcReference, diff);
+                        logEvent(FRC_EVENT_WARNING, msg);
+                    }
+                }
+            }
+#if FRC_USE_PERIODIC
+            // FRC is only accepted while idle
+            _frcStopPeriodic(FRC_CALIBRATE);
+#else
+            _frcStartCalibration();
+#endif
+            return false;
+        }
+
+        unsigned long remaining = elapsed < _frcWarmupMs ? _frcWarmupMs - elapsed : 0;
+
+#if FRC_USE_PERIODIC
+        if (now - _frcLastPollMs >= FRC_READY_POLL_MS) {
+            _frcLastPollMs = now;
+
+            uint16_t co2 = 0;
+            float temp = 0, humidity = 0;
             bool dataReady = false;
-            sensor.getDataReadyStatus(dataReady);
-            
-            if (dataReady) {
+            uint32_t t = micros();
+            error = sensor.getDataReadyStatus(dataReady);
+            i2cRecord(SCD4X_GET_DATA_READY, micros() - t, error);
+            if (error == 0 && dataReady) {
+                t = micros();
                 error = sensor.readMeasurement(co2, temp, humidity);
+                i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
                 if (error == 0 && co2 > 0) {
-                    readingCount++;
-                    avgCO2 = ((avgCO2 * (readingCount - 1)) + co2) / readingCount;
-                    
-                    Serial.print("[FRC] Reading ");
-                    Serial.print(readingCount);
-                    Serial.print(": CO2=");
-                    Serial.print(co2);
-                    Serial.print(" ppm (avg=");
-                    Serial.print((int)avgCO2);
-                    Serial.print(") | ");
-                    Serial.print(remaining / 1000);
-                    Serial.println("s remaining");
-
-                    // Update display after reading
-                    if (displayUpdate) {
-                        displayUpdate(remaining, FRC_WARMUP_DURATION_MS, readingCount, co2, avgCO2);
-                    }
-
-                    _frcFlashLED(1, 100, 0);
+                    _frcAcceptReading(co2, temp, humidity, now, displayUpdate);
                 }
             }
         }
+#else
+        if (!_frcShotPending && (long)(now - _frcNextShotMs) >= 0) {
+            _frcNextShotMs += FRC_WARMUP_INTERVAL_MS;
+            if (scd4xIssue(SCD4X_MEASURE_SINGLE_SHOT, _frcCmd)) {
+                _frcShotPending = true;
+            } else {
+                Serial.print("[FRC] measureSingleShot error: ");
+                Serial.println(_frcCmd.error);
+                _frcFlashLED(2, 50, 50);
+            }
+        }
 
-        // Wait for next reading interval, updating display every second
-        unsigned long nextReading = warmupStart + ((readingCount + 1) * FRC_WARMUP_INTERVAL_MS);
-        unsigned long lastDisplayUpdate = millis();
-        uint16_t lastCO2 = 0;  // Preserve last CO2 for display during wait
-
-        // Get the CO2 value we just read (if any) for display during wait
-        // Note: co2 variable is still in scope from above
+        if (_frcShotPending && scd4xReady(_frcCmd)) {
+            _frcShotPending = false;
+            scd4xCollect(_frcCmd);
 
-        while (millis() < nextReading && millis() - warmupStart < FRC_WARMUP_DURATION_MS) {
-            esp_task_wdt_reset();
+            uint16_t co2 = 0;
+            float temp = 0, humidity = 0;
+            bool dataReady = false;
+            uint32_t t = micros();
+            error = sensor.getDataReadyStatus(dataReady);
+            i2cRecord(SCD4X_GET_DATA_READY, micros() - t, error);
 
-            // Update display every second for countdown
-            if (displayUpdate && millis() - lastDisplayUpdate >= 1000) {
-                lastDisplayUpdate = millis();
-                unsigned long currentRemaining = FRC_WARMUP_DURATION_MS - (millis() - warmupStart);
-                displayUpdate(currentRemaining, FRC_WARMUP_DURATION_MS, readingCount, co2, avgCO2);
+            if (error == 0 && dataReady) {
+                t = micros();
+                error = sensor.readMeasurement(co2, temp, humidity);
+                i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
+                if (error == 0 && co2 > 0) {
+                    _frcAcceptReading(co2, temp, humidity, now, displayUpdate);
+                }
             }
+        }
+#endif
 
-            delay(100);
+        // Update display every second for countdown
+        if (displayUpdate && now - _frcLastDisplayMs >= 1000) {
+            _frcLastDisplayMs = now;
+            displayUpdate(remaining, _frcWarmupMs, _frcReadingCount, _frcLastCO2, _frcAvgCO2);
         }
+        return false;
     }
-    
-    Serial.println("[FRC] Warmup complete");
-    Serial.print("[FRC] ");
-    Serial.print(readingCount);
-    Serial.print(" readings, average: ");
-    Serial.print((int)avgCO2);
-    Serial.println(" ppm");
-    
-    // Warn if readings differ significantly from reference
-    if (readingCount > 0) {
-        float diff = avgCO2 - FRC_REFERENCE_PPM;
-        if (diff > 100 || diff < -100) {
-            Serial.print("[FRC] WARNING: Average differs from reference by ");
-            Serial.print((int)diff);
+
+    // ========================================
+    // PERFORM FRC - collect the correction once the command has executed
+    // ========================================
+
+    case FRC_CALIBRATE: {
+        if (_frcCmd.pending && !scd4xReady(_frcCmd)) return false;
+
+        uint16_t frcCorrection = 0;
+        error = scd4xCollect(_frcCmd, &frcCorrection);
+        _frcSucceeded = false;
+        _frcSetResult(FRC_RESULT_FAILED, 0);
+
+        if (error != 0) {
+            Serial.print("[FRC] ERROR: FRC command failed: ");
+            Serial.println(error);
+            _frcRapidFlash(10);
+
+            if (logEvent) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "FRC command failed, error: %d", error);
+                logEvent(FRC_EVENT_ERROR, msg);
+            }
+        } else if (frcCorrection == 0xFFFF) {
+            Serial.println("[FRC] ERROR: FRC failed (0xFFFF)");
+            Serial.println("[FRC] Sensor wasn't measuring before FRC");
+            _frcRapidFlash(10);
+
+            if (logEvent) {
+                logEvent(FRC_EVENT_ERROR, "FRC failed - sensor returned 0xFFFF");
+            }
+        } else {
+            // Success!
+            int16_t correction = (int16_t)(frcCorrection - 0x8000);
+            _frcSucceeded = true;
+            _frcSetResult(FRC_RESULT_OK, correction);
+
+            Serial.println("[FRC] ========================================");
+            Serial.println("[FRC] CALIBRATION SUCCESSFUL!");
+            Serial.print("[FRC] Correction applied: ");
+            Serial.print(correction);
             Serial.println(" ppm");
-            Serial.println("[FRC] Ensure you're actually in fresh outdoor air!");
-            
+            Serial.println("[FRC] ========================================");
+
+            _frcSlowFlash(2);
+
             if (logEvent) {
-                char msg[96];
-                snprintf(msg, sizeof(msg), "FRC warmup avg %.0f ppm vs reference %d ppm (diff: %.0f)",
-                         avgCO2, FRC_REFERENCE_PPM, diff);
-                logEvent(FRC_EVENT_WARNING, msg);
+                char msg[160];
+                snprintf(msg, sizeof(msg),
+                         "FRC successful! Correction: %d ppm, reference: %d ppm, converged in %lus, noise %.1f ppm, avg +/-%.2f ppm (%d readings)",
+                         correction, _frcReference, _frcConvergedMs / 1000, _frcNoise,
+                         _frcStdError, _frcWindowCount);
+                logEvent(FRC_EVENT_INFO, msg);
             }
         }
+        _frcEnter(FRC_RESTART);
+        return false;
     }
-    
+
     // ========================================
-    // PERFORM FRC
+    // RESTART PERIODIC MEASUREMENT
     // ========================================
-    
-    Serial.println("[FRC] Performing forced recalibration...");
-    _frcSlowFlash(3);
-    
-    uint16_t frcCorrection = 0;
-    error = sensor.performForcedRecalibration(FRC_REFERENCE_PPM, frcCorrection);
-    
-    if (error != 0) {
-        Serial.print("[FRC] ERROR: FRC command failed: ");
-        Serial.println(error);
-        _frcRapidFlash(10);
-        
-        if (logEvent) {
-            char msg[48];
-            snprintf(msg, sizeof(msg), "FRC command failed, error: %d", error);
-            logEvent(FRC_EVENT_ERROR, msg);
+
+    case FRC_RESTART:
+        // Cancelled mid-command - the sensor ignores us until it's done
+        if (scd4xBusy()) return false;
+        scd4xCollect(_frcCmd);
+        // A refused periodic-mode calibration never stopped it
+        if (!_frcStopped) {
+            _frcEnter(FRC_IDLE);
+            return true;
         }
-        
-        warmupSuccess = false;
-    } else if (frcCorrection == 0xFFFF) {
-        Serial.println("[FRC] ERROR: FRC failed (0xFFFF)");
-        Serial.println("[FRC] Sensor wasn't measuring before FRC");
-        _frcRapidFlash(10);
-        
-        if (logEvent) {
-            logEvent(FRC_EVENT_ERROR, "FRC failed - sensor returned 0xFFFF");
+        _frcStopped = false;
+        {
+            uint32_t t = micros();
+            error = sensor.startPeriodicMeasurement();
+            i2cRecord(SCD4X_START_PERIODIC, micros() - t, error);
         }
-        
-        warmupSuccess = false;
-    } else {
-        // Success!
-        int16_t correction = (int16_t)(frcCorrection - 0x8000);
-        
-        Serial.println("[FRC] ========================================");
-        Serial.println("[FRC] CALIBRATION SUCCESSFUL!");
-        Serial.print("[FRC] Correction applied: ");
-        Serial.print(correction);
-        Serial.println(" ppm");
-        Serial.println("[FRC] ========================================");
-        
-        _frcSlowFlash(2);
-        
-        if (logEvent) {
-            char msg[96];
-            snprintf(msg, sizeof(msg), "FRC successful! Correction: %d ppm, reference: %d ppm",
-                     correction, FRC_REFERENCE_PPM);
-            logEvent(FRC_EVENT_INFO, msg);
+        if (error != 0) {
+            Serial.print("[FRC] startPeriodicMeasurement error: ");
+            Serial.println(error);
+            if (logEvent) logEvent(FRC_EVENT_CRITICAL, "FRC: failed to restart periodic measurement");
         }
+        Serial.println("[FRC] Returning to normal operation");
+        Serial.println();
+        _frcEnter(FRC_IDLE);
+        return true;
     }
-    
-    // ========================================
-    // CLEANUP
-    // ========================================
-    
-    // Wait for button release
-    Serial.println("[FRC] Release button to continue...");
-    while (digitalRead(FRC_BUTTON_PIN) == LOW) {
-        esp_task_wdt_reset();
-        delay(50);
-    }
-    delay(200);  // Debounce
-    
-    Serial.println("[FRC] Returning to normal operation");
-    Serial.println();
-    
-    // NOTE: Caller must restart periodic measurement!
-    // We don't do it here so caller can handle any additional setup
-    
-    return true;
+
+    return false;
+}
+
+// Result of the last finished calibration
+bool frcLastSucceeded() {
+    return _frcSucceeded;
+}
+
+// Details of the last finished calibration
+const FRCResult& frcLastResult() {
+    return _frcResult;
 }
 
 #endif // FORCED_CALIBRATION_H
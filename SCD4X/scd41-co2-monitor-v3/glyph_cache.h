@@ -0,0 +1,226 @@
+/*
+ * Glyph Cache for the large CO2 digits
+ *
+ * The big CO2 number uses u8g2_font_logisoso28_tn, and U8g2 decodes the
+ * compressed glyph data for every digit on every refresh. This module
+ * rasterizes "0123456789-" once at startup into packed framebuffer columns
+ * so the hot draw path is a plain byte copy into the U8g2 buffer.
+ *
+ * Usage:
+ *   1. Call glyphCacheInit(u8g2, font, baselineY) after u8g2.begin()
+ *      (it uses the framebuffer as scratch space, so do it before drawing)
+ *   2. glyphCacheStrWidth(str) returns the precomputed width, or -1 if the
+ *      string contains a character that isn't cached
+ *   3. glyphCacheDrawStr(u8g2, x, str) blits the string at the cached baseline
+ *
+ * Works with full-buffer (_F_) constructors only. Rotation is detected at
+ * init, so U8G2_R0 and U8G2_R2 both work.
+ */
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define GLYPH_CACHE_CHARS "0123456789-"
+#define GLYPH_CACHE_COUNT 11
+
+// Upper bound on a glyph's width in pixels and height in 8-pixel pages
+#define GLYPH_CACHE_MAX_COLS 24
+#define GLYPH_CACHE_MAX_PAGES 5
+
+// ===========================================
+// State
+// ===========================================
+
+static bool _gcReady = false;
+static int8_t _gcDirection = 1;     // +1 for R0, -1 for mirrored (R2)
+static uint8_t _gcFirstPage = 0;    // First framebuffer page covered by the glyphs
+static uint8_t _gcPageCount = 0;
+static uint16_t _gcRowBytes = 128;  // Bytes per framebuffer page row
+
+static uint8_t _gcAdvance[GLYPH_CACHE_COUNT];   // Layout width of each glyph
+static int16_t _gcOrigin[GLYPH_CACHE_COUNT];    // Physical column of bitmap at logical x=0
+static uint8_t _gcCols[GLYPH_CACHE_COUNT];      // Bitmap width in columns
+static uint8_t _gcBitmap[GLYPH_CACHE_COUNT][GLYPH_CACHE_MAX_PAGES][GLYPH_CACHE_MAX_COLS];
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static int _gcIndex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c == '-') return 10;
+    return -1;
+}
+
+// Bounding box of set pixels in the framebuffer, in physical columns/pages
+static bool _gcBufferBounds(U8G2 &display, int &minCol, int &maxCol,
+                            int &minPage, int &maxPage) {
+    uint8_t *buf = display.getBufferPtr();
+    int pages = display.getBufferTileHeight();
+
+    minCol = _gcRowBytes;
+    maxCol = -1;
+    minPage = pages;
+    maxPage = -1;
+
+    for (int page = 0; page < pages; page++) {
+        for (int col = 0; col < _gcRowBytes; col++) {
+            if (buf[page * _gcRowBytes + col] == 0) continue;
+            if (col < minCol) minCol = col;
+            if (col > maxCol) maxCol = col;
+            if (page < minPage) minPage = page;
+            if (page > maxPage) maxPage = page;
+        }
+    }
+    return maxCol >= 0;
+}
+
+// ===========================================
+// Initialize - call after u8g2.begin()
+// Returns false if the font doesn't fit the cache limits
+// ===========================================
+
+bool glyphCacheInit(U8G2 &display, const uint8_t *font, int baselineY) {
+    _gcReady = false;
+    _gcRowBytes = display.getBufferTileWidth() * 8;
+
+    display.setFont(font);
+
+    // Probe rotation: draw the same glyph at two x offsets and see which
+    // way it moves in the physical buffer
+    int minA, maxA, minB, maxB, p0, p1;
+    display.clearBuffer();
+    display.drawGlyph(8, baselineY, '8');
+    _gcBufferBounds(display, minA, maxA, p0, p1);
+    display.clearBuffer();
+    display.drawGlyph(16, baselineY, '8');
+    _gcBufferBounds(display, minB, maxB, p0, p1);
+    _gcDirection = (minB > minA) ? 1 : -1;
+
+    // First pass: find the page range shared by all glyphs
+    int firstPage = 255, lastPage = -1;
+    const char *chars = GLYPH_CACHE_CHARS;
+    for (int i = 0; i < GLYPH_CACHE_COUNT; i++) {
+        int minCol, maxCol, minPage, maxPage;
+        display.clearBuffer();
+        display.drawGlyph(GLYPH_CACHE_MAX_COLS, baselineY, chars[i]);
+        if (!_gcBufferBounds(display, minCol, maxCol, minPage, maxPage)) continue;
+        if (minPage < firstPage) firstPage = minPage;
+        if (maxPage > lastPage) lastPage = maxPage;
+    }
+
+    if (lastPage < 0 || lastPage - firstPage + 1 > GLYPH_CACHE_MAX_PAGES) {
+        display.clearBuffer();
+        Serial.println("[GlyphCache] Font doesn't fit cache, using U8g2 glyphs");
+        return false;
+    }
+    _gcFirstPage = firstPage;
+    _gcPageCount = lastPage - firstPage + 1;
+
+    // Second pass: copy each glyph's columns out of the framebuffer.
+    // Glyphs are drawn at logical x = GLYPH_CACHE_MAX_COLS so a negative
+    // bearing doesn't clip against the left edge.
+    uint8_t *buf = display.getBufferPtr();
+    for (int i = 0; i < GLYPH_CACHE_COUNT; i++) {
+        display.clearBuffer();
+        _gcAdvance[i] = display.drawGlyph(GLYPH_CACHE_MAX_COLS, baselineY, chars[i]);
+
+        int minCol, maxCol, minPage, maxPage;
+        if (!_gcBufferBounds(display, minCol, maxCol, minPage, maxPage)) {
+            _gcCols[i] = 0;
+            _gcOrigin[i] = 0;
+            continue;
+        }
+
+        int cols = maxCol - minCol + 1;
+        if (cols > GLYPH_CACHE_MAX_COLS) {
+            display.clearBuffer();
+            Serial.println("[GlyphCache] Glyph too wide, using U8g2 glyphs");
+            return false;
+        }
+
+        _gcCols[i] = cols;
+        _gcOrigin[i] = minCol - _gcDirection * GLYPH_CACHE_MAX_COLS;
+        for (int p = 0; p < _gcPageCount; p++) {
+            memcpy(_gcBitmap[i][p], &buf[(_gcFirstPage + p) * _gcRowBytes + minCol], cols);
+        }
+    }
+
+    display.clearBuffer();
+    _gcReady = true;
+
+    Serial.print("[GlyphCache] Cached ");
+    Serial.print(GLYPH_CACHE_COUNT);
+    Serial.print(" glyphs, ");
+    Serial.print(sizeof(_gcBitmap));
+    Serial.println(" bytes");
+    return true;
+}
+
+bool glyphCacheReady() {
+    return _gcReady;
+}
+
+// ===========================================
+// Width of a string in pixels, -1 if not drawable from the cache
+// ===========================================
+
+int glyphCacheStrWidth(const char *str) {
+    if (!_gcReady) return -1;
+
+    int width = 0;
+    for (const char *c = str; *c; c++) {
+        int idx = _gcIndex(*c);
+        if (idx < 0) return -1;
+        width += _gcAdvance[idx];
+    }
+    return width;
+}
+
+// ===========================================
+// Blit a string at logical x, on the baseline given to glyphCacheInit()
+// Returns false (and draws nothing) if a character isn't cached
+// ===========================================
+
+bool glyphCacheDrawStr(U8G2 &display, int x, const char *str) {
+    if (glyphCacheStrWidth(str) < 0) return false;
+
+    uint8_t *buf = display.getBufferPtr();
+
+    for (const char *c = str; *c; c++) {
+        int idx = _gcIndex(*c);
+        int dst = _gcOrigin[idx] + _gcDirection * x;
+
+        // Clip to the framebuffer
+        int start = 0;
+        int cols = _gcCols[idx];
+        if (dst < 0) {
+            start = -dst;
+        }
+        if (dst + cols > _gcRowBytes) {
+            cols = _gcRowBytes - dst;
+        }
+
+        if (start < cols) {
+            for (int p = 0; p < _gcPageCount; p++) {
+                uint8_t *row = &buf[(_gcFirstPage + p) * _gcRowBytes + dst];
+                const uint8_t *src = _gcBitmap[idx][p];
+                for (int i = start; i < cols; i++) {
+                    row[i] |= src[i];
+                }
+            }
+        }
+
+        x += _gcAdvance[idx];
+    }
+    return true;
+}
+
+#endif // GLYPH_CACHE_H
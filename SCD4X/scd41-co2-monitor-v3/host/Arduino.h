@@ -0,0 +1,33 @@
+/*
+ * Just enough Arduino for the display headers on a PC: timing and a
+ * Serial that writes to stdout.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+struct HostSerial {
+    template <typename T> void print(const T &v) { std::cout << v; }
+    template <typename T> void println(const T &v) { std::cout << v << '\n'; }
+    void println() { std::cout << '\n'; }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,64 @@
+/*
+ * Host stand-in for the Arduino U8g2 wrapper
+ *
+ * Same class and method names as U8g2lib.h, each a straight call into the
+ * U8g2 C library. The display is the SH1106 128x64 full-buffer setup the
+ * sketch uses, with the byte transport stubbed out - sendBuffer() goes
+ * nowhere and the framebuffer is the picture.
+ *
+ * Only the methods the shared display headers call are here.
+ */
+
+#ifndef HOST_U8G2LIB_H
+#define HOST_U8G2LIB_H
+
+#include "u8g2.h"
+
+class U8G2 {
+public:
+    explicit U8G2(const u8g2_cb_t *rotation = U8G2_R0) {
+        u8g2_Setup_sh1106_128x64_noname_f(&u8g2, rotation, u8x8_byte_empty, u8x8_dummy_cb);
+    }
+
+    u8g2_t* getU8g2() { return &u8g2; }
+
+    bool begin() {
+        u8g2_InitDisplay(&u8g2);
+        u8g2_SetPowerSave(&u8g2, 0);
+        return true;
+    }
+
+    void clearBuffer() { u8g2_ClearBuffer(&u8g2); }
+    void sendBuffer() { u8g2_SendBuffer(&u8g2); }
+    uint8_t* getBufferPtr() { return u8g2_GetBufferPtr(&u8g2); }
+    uint8_t getBufferTileWidth() { return u8g2_GetBufferTileWidth(&u8g2); }
+    uint8_t getBufferTileHeight() { return u8g2_GetBufferTileHeight(&u8g2); }
+
+    void setContrast(uint8_t value) { u8g2_SetContrast(&u8g2, value); }
+    void setPowerSave(uint8_t is_enable) { u8g2_SetPowerSave(&u8g2, is_enable); }
+
+    void setFont(const uint8_t *font) { u8g2_SetFont(&u8g2, font); }
+    u8g2_uint_t getStrWidth(const char *s) { return u8g2_GetStrWidth(&u8g2, s); }
+    u8g2_uint_t drawStr(u8g2_uint_t x, u8g2_uint_t y, const char *s) {
+        return u8g2_DrawStr(&u8g2, x, y, s);
+    }
+    u8g2_uint_t drawGlyph(u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding) {
+        return u8g2_DrawGlyph(&u8g2, x, y, encoding);
+    }
+
+    void drawHLine(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w) { u8g2_DrawHLine(&u8g2, x, y, w); }
+    void drawLine(u8g2_uint_t x1, u8g2_uint_t y1, u8g2_uint_t x2, u8g2_uint_t y2) {
+        u8g2_DrawLine(&u8g2, x1, y1, x2, y2);
+    }
+    void drawFrame(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) {
+        u8g2_DrawFrame(&u8g2, x, y, w, h);
+    }
+    void drawBox(u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t w, u8g2_uint_t h) {
+        u8g2_DrawBox(&u8g2, x, y, w, h);
+    }
+
+protected:
+    u8g2_t u8g2;
+};
+
+#endif // HOST_U8G2LIB_H
@@ -0,0 +1,156 @@
+/*
+ * Host test of the button gesture decoder
+ *
+ * Feeds button_gesture.h debounced edges and deadline steps at fixed
+ * times and checks the events against what button_input.h promises. Each
+ * case steps the decoder the way the debounce timer does: on every edge,
+ * and at the time buttonGestureDeadline() asks for.
+ *
+ *   make button-test
+ */
+
+#include <Arduino.h>
+#include "../button_gesture.h"
+
+#define LONG_MS   1000
+#define DOUBLE_MS 300
+
+static int failures = 0;
+
+// ===========================================
+// Driver
+// ===========================================
+
+// One debounced edge: the level changes to `pressed` at `atMs`
+struct Edge {
+    uint32_t atMs;
+    bool pressed;
+};
+
+// Steps the decoder through the edges, plus every deadline it asks for
+// before the next edge (and up to endMs after the last), and records
+// the events in order
+static int runEdges(ButtonGesture &g, const Edge *edges, int count, uint32_t endMs,
+                    ButtonEvent *events, int maxEvents) {
+    int n = 0;
+    auto record = [&](ButtonEvent e) {
+        if (e != BUTTON_NONE && n < maxEvents) events[n++] = e;
+    };
+    auto stepDeadlines = [&](uint32_t untilMs) {
+        uint32_t deadline;
+        while (buttonGestureDeadline(g, deadline) && (int32_t)(deadline - untilMs) <= 0) {
+            uint8_t before = g.state;
+            record(buttonGestureStep(g, g.pressed, deadline));
+            if (g.state == before) break;
+        }
+    };
+
+    for (int i = 0; i < count; i++) {
+        // A deadline that falls exactly on the edge loses to the edge,
+        // like the timer callback that only runs once the line has settled
+        stepDeadlines(edges[i].atMs - 1);
+        record(buttonGestureStep(g, edges[i].pressed, edges[i].atMs));
+    }
+    stepDeadlines(endMs);
+    return n;
+}
+
+static void expect(const char *name, uint32_t longMs, uint32_t doubleMs,
+                   const Edge *edges, int count,
+                   std::initializer_list<ButtonEvent> expected) {
+    ButtonGesture g;
+    buttonGestureInit(g, longMs, doubleMs);
+    uint32_t endMs = edges[count - 1].atMs + longMs + doubleMs + 1;
+
+    ButtonEvent events[8];
+    int n = runEdges(g, edges, count, endMs, events, 8);
+
+    bool ok = n == (int)expected.size() && g.state == BUTTON_G_IDLE;
+    int i = 0;
+    for (ButtonEvent e : expected) {
+        if (i >= n || events[i] != e) ok = false;
+        i++;
+    }
+
+    printf("%-28s", name);
+    for (i = 0; i < n; i++) printf(" %s", buttonEventName(events[i]));
+    if (n == 0) printf(" -");
+    if (ok) {
+        printf("  ok\n");
+    } else {
+        printf("  FAIL (expected");
+        for (ButtonEvent e : expected) printf(" %s", buttonEventName(e));
+        printf(", state %u)\n", g.state);
+        failures++;
+    }
+}
+
+#define EXPECT(name, longMs, doubleMs, edges, ...) \
+    expect(name, longMs, doubleMs, edges, sizeof(edges) / sizeof(edges[0]), { __VA_ARGS__ })
+
+// ===========================================
+// Cases
+// ===========================================
+
+int main() {
+    // Press 100 ms, release; nothing else until the double window closes
+    const Edge shortPress[] = { {1000, true}, {1100, false} };
+    EXPECT("short", LONG_MS, DOUBLE_MS, shortPress, BUTTON_SHORT);
+
+    // Second press 150 ms after the first release
+    const Edge doublePress[] = { {1000, true}, {1100, false}, {1250, true}, {1350, false} };
+    EXPECT("double", LONG_MS, DOUBLE_MS, doublePress, BUTTON_DOUBLE);
+
+    // Second press exactly at the end of the window still counts
+    const Edge doubleAtDeadline[] = { {1000, true}, {1100, false}, {1100 + DOUBLE_MS, true}, {1500, false} };
+    EXPECT("second press at doubleMs", LONG_MS, DOUBLE_MS, doubleAtDeadline, BUTTON_DOUBLE);
+
+    // Second press after the window - two shorts
+    const Edge twoShorts[] = { {1000, true}, {1100, false}, {1450, true}, {1550, false} };
+    EXPECT("double window missed", LONG_MS, DOUBLE_MS, twoShorts, BUTTON_SHORT, BUTTON_SHORT);
+
+    // Held past longMs and not released within the run
+    const Edge longHeld[] = { {1000, true} };
+    {
+        ButtonGesture g;
+        buttonGestureInit(g, LONG_MS, DOUBLE_MS);
+        ButtonEvent events[8];
+        int n = runEdges(g, longHeld, 1, 5000, events, 8);
+        bool ok = n == 1 && events[0] == BUTTON_LONG && g.state == BUTTON_G_HELD;
+        printf("%-28s%s%s\n", "long", n ? " long" : " -", ok ? "  ok" : "  FAIL (expected long, held)");
+        if (!ok) failures++;
+    }
+
+    // Long, then released much later - the release adds nothing
+    const Edge longRelease[] = { {1000, true}, {3500, false} };
+    EXPECT("long then release", LONG_MS, DOUBLE_MS, longRelease, BUTTON_LONG);
+
+    // doubleMs = 0: short at the release, no double press at all
+    const Edge noDouble[] = { {1000, true}, {1100, false}, {1150, true}, {1250, false} };
+    EXPECT("doubleMs = 0", LONG_MS, 0, noDouble, BUTTON_SHORT, BUTTON_SHORT);
+
+    // doubleMs = 0 still reports long presses
+    EXPECT("doubleMs = 0, long", LONG_MS, 0, longRelease, BUTTON_LONG);
+
+    // Released exactly at the longMs deadline: the edge wins, so short
+    const Edge atDeadline[] = { {1000, true}, {1000 + LONG_MS, false} };
+    EXPECT("release at longMs", LONG_MS, DOUBLE_MS, atDeadline, BUTTON_SHORT);
+
+    // One millisecond later the deadline step has already reported long
+    const Edge pastDeadline[] = { {1000, true}, {1000 + LONG_MS + 1, false} };
+    EXPECT("release at longMs + 1", LONG_MS, DOUBLE_MS, pastDeadline, BUTTON_LONG);
+
+    // Same with doubleMs = 0
+    EXPECT("release at longMs, no dbl", LONG_MS, 0, atDeadline, BUTTON_SHORT);
+
+    // millis() wraps during a press
+    const Edge wrap[] = { {0xFFFFFF00u, true}, {0x00000100u, false} };
+    EXPECT("short across millis wrap", LONG_MS, DOUBLE_MS, wrap, BUTTON_SHORT);
+
+    if (failures) {
+        printf("%d case(s) failed\n", failures);
+        return 1;
+    }
+    printf("All cases passed\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Host snapshots of the v3 OLED screens
+ *
+ * Builds display_screens.h and glyph_cache.h against the U8g2 C library
+ * and renders every screen state with fixed sample data - the same states
+ * (including secondary pages 2-5) and PBM dump format as the sketch's
+ * `snap` command, so the output goes through snapshot_capture.py
+ * unchanged. The render time in each header
+ * is the average draw time on this machine (relative numbers only - an
+ * ESP32 is far slower).
+ *
+ * Also checks that the glyph cache draws the CO2 digits pixel-for-pixel
+ * like the U8g2 font; exits 1 if it doesn't.
+ *
+ * Build and compare against the committed goldens with `make check`; see
+ * the Makefile.
+ */
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include "../display_screens.h"
+#include "../glyph_cache.h"
+
+// Renders per screen for the average draw time
+#define RENDER_RUNS 200
+
+// Same as the sketch
+#define MEASUREMENT_INTERVAL_MS 60000
+#define WIFI_MAX_ATTEMPTS 30
+#define FRC_WARMUP_DURATION_MS 300000
+#define TREND_HISTORY_LEN 60
+#define PAGE_COUNT 5
+
+static U8G2 u8g2(U8G2_R2);      // Mounted upside down, like the monitor
+
+// ===========================================
+// Screen states
+// ===========================================
+
+// Fixed status bar so the snapshots are reproducible
+static ScreenReading sampleReading(uint16_t co2) {
+    ScreenReading r;
+    r.co2 = co2;
+    r.temp = 22.5;
+    r.humidity = 45.0;
+    r.error = false;
+    r.waiting = false;
+    r.useGlyphCache = true;
+    r.wifiConnected = true;
+    r.rssi = -61;
+    r.irStatus = nullptr;
+    r.uptimeMs = 83UL * 60000;
+    return r;
+}
+
+static void drawWaiting() {
+    screenDrawWaiting(u8g2, MEASUREMENT_INTERVAL_MS / 2, MEASUREMENT_INTERVAL_MS);
+}
+
+static void drawError() {
+    ScreenReading r = sampleReading(0);
+    r.error = true;
+    screenDrawReading(u8g2, r);
+}
+
+static void drawNormal() {
+    screenDrawReading(u8g2, sampleReading(850));
+}
+
+static void drawNormal5Digit() {
+    screenDrawReading(u8g2, sampleReading(10000));
+}
+
+static void drawCalibrating() {
+    screenDrawCalibrating(u8g2, FRC_WARMUP_DURATION_MS / 2, FRC_WARMUP_DURATION_MS, 5, 452, 447.5);
+}
+
+static void drawConnecting() {
+    screenDrawConnecting(u8g2, 12, WIFI_MAX_ATTEMPTS);
+}
+
+static void drawMessage() {
+    screenDrawMessage(u8g2, "WiFi Connected!", "192.168.1.42");
+}
+
+// Page numbers are 0-based like the sketch's DisplayPage; the dump names
+// match the device's page2-page5
+static void drawTrend() {
+    // 40 readings, rising from 620 ppm and levelling off past 900
+    static uint16_t history[TREND_HISTORY_LEN];
+    for (int i = 0; i < 40; i++) {
+        history[i] = 620 + (i < 30 ? i * 10 : 290 + (i - 30) * 2);
+    }
+    ScreenTrend t = { history, TREND_HISTORY_LEN, 40, 40 };
+    screenDrawTrendPage(u8g2, 1, PAGE_COUNT, t);
+}
+
+static void drawNetwork() {
+    ScreenNetwork n = { true, "192.168.1.42", -61, 1438, 1440, 0, 2 };
+    screenDrawNetworkPage(u8g2, 2, PAGE_COUNT, n);
+}
+
+static void drawIr() {
+    ScreenIr ir = { false, false, 37, 125, "on cool/auto", 0, 2, 48, 310 };
+    screenDrawIrPage(u8g2, 3, PAGE_COUNT, ir);
+}
+
+static void drawDiagnostics() {
+    ScreenDiagnostics d = { 1440, 3, 201532, 86400000UL + 83UL * 60000, 2150, 24800,
+                            20UL * 3600000, 3610 };
+    screenDrawDiagnosticsPage(u8g2, 4, PAGE_COUNT, d);
+}
+
+struct Snapshot {
+    const char* name;
+    void (*draw)();
+};
+
+static const Snapshot SNAPSHOTS[] = {
+    { "waiting",       drawWaiting },
+    { "error",         drawError },
+    { "normal",        drawNormal },
+    { "normal-5digit", drawNormal5Digit },
+    { "calibrating",   drawCalibrating },
+    { "connecting",    drawConnecting },
+    { "message",       drawMessage },
+    { "page2",         drawTrend },
+    { "page3",         drawNetwork },
+    { "page4",         drawIr },
+    { "page5",         drawDiagnostics },
+};
+
+// ===========================================
+// Checks
+// ===========================================
+
+// The cached digits must match what the font draws
+static bool glyphCacheMatchesFont(uint16_t co2) {
+    static uint8_t fontFrame[1024];
+    ScreenReading r = sampleReading(co2);
+    int size = u8g2.getBufferTileWidth() * u8g2.getBufferTileHeight() * 8;
+
+    r.useGlyphCache = false;
+    u8g2.clearBuffer();
+    screenDrawReading(u8g2, r);
+    memcpy(fontFrame, u8g2.getBufferPtr(), size);
+
+    r.useGlyphCache = true;
+    u8g2.clearBuffer();
+    screenDrawReading(u8g2, r);
+    return memcmp(fontFrame, u8g2.getBufferPtr(), size) == 0;
+}
+
+// ===========================================
+// Main
+// ===========================================
+
+int main() {
+    u8g2.begin();
+    if (!glyphCacheInit(u8g2, u8g2_font_logisoso28_tn, SCREEN_CO2_BASELINE_Y)) {
+        fprintf(stderr, "Glyph cache init failed\n");
+        return 1;
+    }
+
+    for (const Snapshot &s : SNAPSHOTS) {
+        unsigned long start = micros();
+        for (int i = 0; i < RENDER_RUNS; i++) {
+            u8g2.clearBuffer();
+            s.draw();
+        }
+        unsigned long renderUs = (micros() - start) / RENDER_RUNS;
+        screenDumpPbm(u8g2, s.name, renderUs);
+    }
+
+    bool ok = true;
+    const uint16_t values[] = { 400, 850, 1234, 5678, 9999, 10000 };
+    for (uint16_t v : values) {
+        if (!glyphCacheMatchesFont(v)) {
+            fprintf(stderr, "Glyph cache differs from the U8g2 font at %u ppm\n", v);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
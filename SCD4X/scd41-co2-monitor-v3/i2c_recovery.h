@@ -0,0 +1,600 @@
+/*
+ * Tiered I2C Recovery for the SCD41
+ *
+ * A failed sensor read arms the recovery ladder for the sensor's next 5 s
+ * measurement slot. Each step is tried only if the one before it didn't
+ * bring the sensor back, cheapest first:
+ *
+ *   1. retry       - probe get_data_ready_status up to 4 times, backing off
+ *                    100/200/400 ms between failed probes (a glitch, a CRC
+ *                    hit)
+ *   2. reinit      - stop, reinit, configure, start (sensor state wedged)
+ *   3. bus clear   - 9 SCL clocks and a STOP, then as reinit (a slave
+ *                    holding SDA low mid-byte)
+ *   4. power cycle - only with I2C_RECOVERY_POWER_PIN driving a switch in
+ *                    the sensor's supply (sensor latched up)
+ *   5. reboot      - ESP.restart(), the sketch saving its state first
+ *
+ * A step counts as having worked when the probe after it gets an answer.
+ * After the retry step the probe must also see data ready - a sensor that
+ * answers but isn't measuring goes on to reinit, which restarts it.
+ *
+ * Every step is timed. The ladder is reported as one event (category
+ * "i2c_recovery") listing each step, its duration and result. Nothing
+ * blocks: the sensor commands go through scd4x_async.h and the waits are
+ * polled, so the loop keeps running through a recovery. Only the bus clear
+ * itself (~100 us) and the configure callback (a few ms) run inline.
+ *
+ * Reboots are limited to I2C_RECOVERY_MAX_REBOOTS in a row (reset by the
+ * next good reading). The ladder and the reboot count survive the restart
+ * in RTC memory; the event after boot says why it happened. After a
+ * ladder fails without rebooting, new failures are ignored for
+ * I2C_RECOVERY_HOLDOFF_MS.
+ *
+ * Usage:
+ *   1. i2cRecoveryInit(sda, scl, configure, logEvent, beforeReboot) in
+ *      setup(), after scd4xAsyncBegin()
+ *   2. i2cRecoveryStart() when a sensor read fails
+ *   3. i2cRecoveryPoll() every loop pass - returns true once the ladder is
+ *      done; don't touch the sensor while i2cRecoveryActive()
+ *   4. i2cRecoveryNoteSuccess() after each good reading
+ */
+
+#ifndef I2C_RECOVERY_H
+#define I2C_RECOVERY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <esp_system.h>
+#include "scd4x_async.h"
+#include "i2c_telemetry.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// First step on the sensor's next measurement slot
+#define I2C_RECOVERY_START_DELAY_MS 5000
+
+// Retry step: probes, and the backoff before the second (doubles after).
+// 4 probes = 100, 200 and 400 ms between them.
+#define I2C_RECOVERY_RETRIES        4
+#define I2C_RECOVERY_BACKOFF_MS     100
+
+// GPIO driving a switch in the sensor's supply, HIGH = on. -1 = not fitted,
+// the power cycle step is skipped. Put the I2C pullups on the switched rail
+// too, or the sensor stays powered through SDA/SCL.
+#define I2C_RECOVERY_POWER_PIN      -1
+#define I2C_RECOVERY_POWER_OFF_MS   1000
+#define I2C_RECOVERY_POWER_UP_MS    30      // Datasheet power-up time
+
+#define I2C_RECOVERY_MAX_REBOOTS    1
+#define I2C_RECOVERY_HOLDOFF_MS     300000
+
+// ===========================================
+// Types
+// ===========================================
+
+enum I2cRecoveryStep {
+    REC_STEP_RETRY = 0,
+    REC_STEP_REINIT,
+    REC_STEP_BUS_CLEAR,
+    REC_STEP_POWER_CYCLE,
+    REC_STEP_REBOOT,
+    REC_STEP_COUNT
+};
+
+enum I2cRecoveryStepResult {
+    REC_RESULT_OK = 0,
+    REC_RESULT_FAILED,
+    REC_RESULT_SKIPPED,
+    REC_RESULT_REBOOT         // Reboot step taken - the ladder ends there
+};
+
+enum I2cRecoveryPhase {
+    REC_IDLE = 0,
+    REC_ARMED,          // Waiting for the next measurement slot
+    REC_PROBE,          // get_data_ready_status in flight
+    REC_BACKOFF,        // Waiting before the next probe
+    REC_STOPPING,       // stop_periodic_measurement in flight
+    REC_REINIT,         // reinit in flight
+    REC_POWER_OFF,      // Sensor unpowered
+    REC_POWER_UP,       // Waiting out power-up
+    REC_STARTING        // start_periodic_measurement sent
+};
+
+struct I2cRecoveryStepLog {
+    uint8_t step;           // I2cRecoveryStep
+    uint8_t result;         // I2cRecoveryStepResult
+    int16_t error;          // Last error seen in the step
+    uint32_t ms;
+};
+
+// Kept in RTC memory across the reboot step
+struct I2cRecoverySaved {
+    uint32_t magic;
+    uint8_t reboots;        // In a row, without a good reading since
+    uint8_t logCount;
+    I2cRecoveryStepLog log[REC_STEP_COUNT];
+    uint32_t totalMs;
+};
+
+#define I2C_RECOVERY_MAGIC 0x52454331   // "REC1"
+
+typedef int16_t (*I2cRecoveryConfigureCallback)();
+typedef bool (*I2cRecoveryEventCallback)(int type, const char* msg,
+                                          const char* category, const char* data);
+typedef void (*I2cRecoveryRebootCallback)();
+
+enum I2cRecoveryEventType {
+    REC_EVENT_INFO = 0,
+    REC_EVENT_WARNING = 1,
+    REC_EVENT_ERROR = 2,
+    REC_EVENT_CRITICAL = 3
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static uint8_t _recSda = 0;
+static uint8_t _recScl = 0;
+static I2cRecoveryConfigureCallback _recConfigure = nullptr;
+static I2cRecoveryEventCallback _recLogEvent = nullptr;
+static I2cRecoveryRebootCallback _recBeforeReboot = nullptr;
+
+static I2cRecoveryPhase _recPhase = REC_IDLE;
+static I2cRecoveryStep _recStep = REC_STEP_RETRY;
+static unsigned long _recWaitUntil = 0;
+static unsigned long _recLadderStart = 0;
+static unsigned long _recStepStart = 0;
+static unsigned long _recHoldoffUntil = 0;
+static bool _recHoldoff = false;
+static Scd4xFuture _recCmd = {};
+static uint8_t _recProbes = 0;
+static bool _recWaitedSlot = false;
+static int16_t _recStepError = 0;
+static bool _recFinished = false;
+static bool _recSucceeded = false;
+
+static I2cRecoveryStepLog _recLog[REC_STEP_COUNT];
+static uint8_t _recLogCount = 0;
+
+static RTC_NOINIT_ATTR I2cRecoverySaved _recSaved;
+static bool _recRebooted = false;
+
+// Stats
+static uint32_t _recLadders = 0;
+static uint32_t _recFailedLadders = 0;
+static uint32_t _recFixedBy[REC_STEP_COUNT];
+static uint32_t _recStepMsTotal[REC_STEP_COUNT];
+static uint32_t _recStepRuns[REC_STEP_COUNT];
+
+// ===========================================
+// Names
+// ===========================================
+
+const char* i2cRecoveryStepName(uint8_t step) {
+    switch (step) {
+        case REC_STEP_RETRY:       return "retry";
+        case REC_STEP_REINIT:      return "reinit";
+        case REC_STEP_BUS_CLEAR:   return "bus_clear";
+        case REC_STEP_POWER_CYCLE: return "power_cycle";
+        case REC_STEP_REBOOT:      return "reboot";
+        default:                   return "unknown";
+    }
+}
+
+static const char* _recResultName(uint8_t result) {
+    switch (result) {
+        case REC_RESULT_OK:      return "ok";
+        case REC_RESULT_FAILED:  return "failed";
+        case REC_RESULT_REBOOT:  return "reboot";
+        default:                 return "skipped";
+    }
+}
+
+// ===========================================
+// Helpers
+// ===========================================
+
+// JSON for the event: the steps tried and how each went
+static void _recLogJson(char* buf, size_t size, const I2cRecoveryStepLog* log,
+                        uint8_t count, uint32_t totalMs, const char* result) {
+    size_t n = snprintf(buf, size, "{\"result\":\"%s\",\"total_ms\":%lu,\"steps\":[",
+                        result, (unsigned long)totalMs);
+    for (uint8_t i = 0; i < count && n < size; i++) {
+        n += snprintf(buf + n, size - n, "%s{\"step\":\"%s\",\"result\":\"%s\",\"ms\":%lu,\"error\":%d}",
+                      i ? "," : "", i2cRecoveryStepName(log[i].step),
+                      _recResultName(log[i].result), (unsigned long)log[i].ms, log[i].error);
+    }
+    if (n < size) snprintf(buf + n, size - n, "]}");
+}
+
+static void _recEndStep(I2cRecoveryStepResult result) {
+    uint32_t ms = millis() - _recStepStart;
+    if (_recLogCount < REC_STEP_COUNT) {
+        I2cRecoveryStepLog &l = _recLog[_recLogCount++];
+        l.step = _recStep;
+        l.result = result;
+        l.error = _recStepError;
+        l.ms = ms;
+    }
+    if (result == REC_RESULT_OK || result == REC_RESULT_FAILED) {
+        _recStepRuns[_recStep]++;
+        _recStepMsTotal[_recStep] += ms;
+    }
+
+    Serial.print("[I2C] Step ");
+    Serial.print(_recStep + 1);
+    Serial.print(" ");
+    Serial.print(i2cRecoveryStepName(_recStep));
+    Serial.print(": ");
+    Serial.print(_recResultName(result));
+    if (result == REC_RESULT_OK || result == REC_RESULT_FAILED) {
+        Serial.print(" in ");
+        Serial.print(ms);
+        Serial.print(" ms");
+    }
+    if (result == REC_RESULT_FAILED && _recStepError != 0) {
+        Serial.print(" (error 0x");
+        Serial.print((uint16_t)_recStepError, HEX);
+        Serial.print(")");
+    }
+    Serial.println();
+}
+
+static void _recFinish(bool ok) {
+    uint32_t totalMs = millis() - _recLadderStart;
+    _recPhase = REC_IDLE;
+    _recFinished = true;
+    _recSucceeded = ok;
+    i2cRecordRecovery(ok);
+
+    char msg[96];
+    if (ok) {
+        _recFixedBy[_recStep]++;
+        snprintf(msg, sizeof(msg), "I2C recovered by %s after %lu ms",
+                 i2cRecoveryStepName(_recStep), (unsigned long)totalMs);
+    } else {
+        _recFailedLadders++;
+        _recHoldoff = true;
+        _recHoldoffUntil = millis() + I2C_RECOVERY_HOLDOFF_MS;
+        snprintf(msg, sizeof(msg), "I2C recovery failed after %lu ms - check wiring",
+                 (unsigned long)totalMs);
+    }
+    Serial.print("[I2C] ");
+    Serial.println(msg);
+
+    if (_recLogEvent) {
+        char data[384];
+        _recLogJson(data, sizeof(data), _recLog, _recLogCount, totalMs, ok ? "ok" : "failed");
+        _recLogEvent(ok ? REC_EVENT_INFO : REC_EVENT_CRITICAL, msg, "i2c_recovery", data);
+    }
+}
+
+static void _recProbe() {
+    scd4xIssue(SCD4X_GET_DATA_READY, _recCmd);
+    _recPhase = REC_PROBE;
+}
+
+static void _recWait(I2cRecoveryPhase phase, unsigned long ms) {
+    _recPhase = phase;
+    _recWaitUntil = millis() + ms;
+}
+
+static bool _recWaitDone() {
+    return (long)(millis() - _recWaitUntil) >= 0;
+}
+
+// Releases a slave stuck mid-byte: clock it out, then a STOP
+static void _recClearBus() {
+    Wire.end();
+    pinMode(_recSda, INPUT_PULLUP);
+    digitalWrite(_recScl, HIGH);
+    pinMode(_recScl, OUTPUT);
+    for (int i = 0; i < 9 && digitalRead(_recSda) == LOW; i++) {
+        digitalWrite(_recScl, LOW);
+        delayMicroseconds(5);
+        digitalWrite(_recScl, HIGH);
+        delayMicroseconds(5);
+    }
+    pinMode(_recSda, OUTPUT);
+    digitalWrite(_recSda, LOW);
+    delayMicroseconds(5);
+    digitalWrite(_recScl, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(_recSda, HIGH);
+    delayMicroseconds(5);
+    Wire.begin(_recSda, _recScl);
+}
+
+// Settings live in RAM unless persisted - reapply, then start measuring
+static void _recConfigureAndStart() {
+    if (_recConfigure) {
+        int16_t error = _recConfigure();
+        if (error != 0) _recStepError = error;
+    }
+    scd4xIssue(SCD4X_START_PERIODIC, _recCmd);
+    _recPhase = REC_STARTING;
+}
+
+static void _recReboot() {
+    uint32_t totalMs = millis() - _recLadderStart;
+    _recSaved.magic = I2C_RECOVERY_MAGIC;
+    _recSaved.reboots++;
+    _recSaved.logCount = _recLogCount;
+    memcpy(_recSaved.log, _recLog, sizeof(_recLog));
+    _recSaved.totalMs = totalMs;
+
+    Serial.println("[I2C] Rebooting to recover the sensor");
+    if (_recLogEvent) {
+        char data[384];
+        _recLogJson(data, sizeof(data), _recLog, _recLogCount, totalMs, "reboot");
+        _recLogEvent(REC_EVENT_CRITICAL, "I2C recovery: rebooting", "i2c_recovery", data);
+    }
+    if (_recBeforeReboot) _recBeforeReboot();
+    Serial.flush();
+    ESP.restart();
+}
+
+static void _recBeginStep(I2cRecoveryStep step) {
+    _recStep = step;
+    _recStepStart = millis();
+    _recStepError = 0;
+
+    switch (step) {
+    case REC_STEP_RETRY:
+        _recProbes = 0;
+        _recWaitedSlot = false;
+        _recProbe();
+        return;
+
+    case REC_STEP_REINIT:
+        scd4xIssue(SCD4X_STOP_PERIODIC, _recCmd);
+        _recPhase = REC_STOPPING;
+        return;
+
+    case REC_STEP_BUS_CLEAR:
+        _recClearBus();
+        scd4xIssue(SCD4X_STOP_PERIODIC, _recCmd);
+        _recPhase = REC_STOPPING;
+        return;
+
+    case REC_STEP_POWER_CYCLE:
+#if I2C_RECOVERY_POWER_PIN >= 0
+        Wire.end();
+        digitalWrite(I2C_RECOVERY_POWER_PIN, LOW);
+        _recWait(REC_POWER_OFF, I2C_RECOVERY_POWER_OFF_MS);
+#else
+        _recEndStep(REC_RESULT_SKIPPED);
+        _recBeginStep(REC_STEP_REBOOT);
+#endif
+        return;
+
+    case REC_STEP_REBOOT:
+        if (_recSaved.reboots >= I2C_RECOVERY_MAX_REBOOTS) {
+            _recEndStep(REC_RESULT_SKIPPED);
+            _recFinish(false);
+            return;
+        }
+        _recEndStep(REC_RESULT_REBOOT);
+        _recReboot();
+        return;
+
+    default:
+        _recFinish(false);
+        return;
+    }
+}
+
+static void _recStepFailed() {
+    _recEndStep(REC_RESULT_FAILED);
+    _recBeginStep((I2cRecoveryStep)(_recStep + 1));
+}
+
+// ===========================================
+// Initialize - call in setup(), after scd4xAsyncBegin()
+// ===========================================
+
+void i2cRecoveryInit(uint8_t sda, uint8_t scl, I2cRecoveryConfigureCallback configure,
+                     I2cRecoveryEventCallback logEvent = nullptr,
+                     I2cRecoveryRebootCallback beforeReboot = nullptr) {
+    _recSda = sda;
+    _recScl = scl;
+    _recConfigure = configure;
+    _recLogEvent = logEvent;
+    _recBeforeReboot = beforeReboot;
+
+#if I2C_RECOVERY_POWER_PIN >= 0
+    pinMode(I2C_RECOVERY_POWER_PIN, OUTPUT);
+    digitalWrite(I2C_RECOVERY_POWER_PIN, HIGH);
+#endif
+
+    // RTC memory is garbage after a power-on reset - trust it only after ours
+    _recRebooted = esp_reset_reason() == ESP_RST_SW && _recSaved.magic == I2C_RECOVERY_MAGIC &&
+                   _recSaved.logCount <= REC_STEP_COUNT;
+    if (!_recRebooted) {
+        memset(&_recSaved, 0, sizeof(_recSaved));
+        return;
+    }
+
+    Serial.print("[I2C] Rebooted by I2C recovery (");
+    Serial.print(_recSaved.reboots);
+    Serial.println(" in a row)");
+    if (logEvent) {
+        char data[384];
+        _recLogJson(data, sizeof(data), _recSaved.log, _recSaved.logCount,
+                    _recSaved.totalMs, "rebooted");
+        logEvent(REC_EVENT_WARNING, "Rebooted by I2C recovery", "i2c_recovery", data);
+    }
+    _recSaved.magic = 0;
+}
+
+// ===========================================
+// Control
+// ===========================================
+
+// A sensor read failed - arm the ladder for the next measurement slot.
+// Ignored while one is already running or after a failed one (holdoff).
+void i2cRecoveryStart() {
+    if (_recPhase != REC_IDLE) return;
+    if (_recHoldoff) {
+        if ((long)(millis() - _recHoldoffUntil) < 0) return;
+        _recHoldoff = false;
+    }
+
+    Serial.println("[I2C] Sensor read failed, recovery on the next slot");
+    _recLadders++;
+    _recLadderStart = millis();
+    _recLogCount = 0;
+    _recFinished = false;
+    _recWait(REC_ARMED, I2C_RECOVERY_START_DELAY_MS);
+}
+
+// A good reading - the sensor's fine, reboots start counting from zero
+void i2cRecoveryNoteSuccess() {
+    if (_recSaved.reboots != 0) _recSaved.reboots = 0;
+}
+
+bool i2cRecoveryActive() {
+    return _recPhase != REC_IDLE;
+}
+
+// True if this boot was the reboot step
+bool i2cRecoveryRebooted() {
+    return _recRebooted;
+}
+
+// ===========================================
+// Main step - call every loop pass
+// Returns true once, when a ladder has finished
+// ===========================================
+
+bool i2cRecoveryPoll() {
+    switch (_recPhase) {
+
+    case REC_IDLE:
+        if (_recFinished) {
+            _recFinished = false;
+            return true;
+        }
+        return false;
+
+    case REC_ARMED:
+        if (_recWaitDone()) _recBeginStep(REC_STEP_RETRY);
+        return false;
+
+    case REC_PROBE: {
+        if (_recCmd.pending && !scd4xReady(_recCmd)) return false;
+        uint16_t status = 0;
+        int16_t error = scd4xCollect(_recCmd, &status);
+        if (error == SCD4X_ERR_BUSY) {
+            _recProbe();    // Someone else's command still executing
+            return false;
+        }
+
+        if (error != 0) {
+            _recStepError = error;
+            if (_recStep == REC_STEP_RETRY && ++_recProbes < I2C_RECOVERY_RETRIES) {
+                _recWait(REC_BACKOFF, (unsigned long)I2C_RECOVERY_BACKOFF_MS << (_recProbes - 1));
+            } else {
+                _recStepFailed();
+            }
+            return false;
+        }
+
+        // Answering but not measuring? Give it one slot before moving on.
+        bool dataReady = (status & 0x07FF) != 0;
+        if (_recStep == REC_STEP_RETRY && !dataReady) {
+            if (!_recWaitedSlot) {
+                _recWaitedSlot = true;
+                _recWait(REC_BACKOFF, I2C_RECOVERY_START_DELAY_MS);
+            } else {
+                _recStepFailed();
+            }
+            return false;
+        }
+
+        _recEndStep(REC_RESULT_OK);
+        _recFinish(true);
+        return false;
+    }
+
+    case REC_BACKOFF:
+        if (_recWaitDone()) _recProbe();
+        return false;
+
+    case REC_STOPPING:
+        if (_recCmd.pending && !scd4xReady(_recCmd)) return false;
+        // May fail if it wasn't measuring - the probe decides
+        scd4xCollect(_recCmd);
+        scd4xIssue(SCD4X_REINIT, _recCmd);
+        _recPhase = REC_REINIT;
+        return false;
+
+    case REC_REINIT:
+        if (_recCmd.pending && !scd4xReady(_recCmd)) return false;
+        if (scd4xCollect(_recCmd) != 0) _recStepError = _recCmd.error;
+        _recConfigureAndStart();
+        return false;
+
+    case REC_POWER_OFF:
+        if (!_recWaitDone()) return false;
+#if I2C_RECOVERY_POWER_PIN >= 0
+        digitalWrite(I2C_RECOVERY_POWER_PIN, HIGH);
+#endif
+        _recWait(REC_POWER_UP, I2C_RECOVERY_POWER_UP_MS);
+        return false;
+
+    case REC_POWER_UP:
+        if (!_recWaitDone()) return false;
+        Wire.begin(_recSda, _recScl);
+        _recConfigureAndStart();
+        return false;
+
+    case REC_STARTING:
+        if (_recCmd.pending && !scd4xReady(_recCmd)) return false;
+        if (scd4xCollect(_recCmd) != 0) _recStepError = _recCmd.error;
+        _recProbe();
+        return false;
+    }
+    return false;
+}
+
+// Outcome of the last finished ladder
+bool i2cRecoveryLastSucceeded() {
+    return _recSucceeded;
+}
+
+// ===========================================
+// Stats
+// ===========================================
+
+void i2cRecoveryPrintStats() {
+    Serial.print("I2C recovery: ");
+    Serial.print(_recLadders);
+    Serial.print(" ladders, ");
+    Serial.print(_recFailedLadders);
+    Serial.print(" failed");
+    for (uint8_t s = 0; s < REC_STEP_COUNT; s++) {
+        if (_recStepRuns[s] == 0) continue;
+        Serial.print(", ");
+        Serial.print(i2cRecoveryStepName(s));
+        Serial.print(" ");
+        Serial.print(_recFixedBy[s]);
+        Serial.print("/");
+        Serial.print(_recStepRuns[s]);
+        Serial.print(" fixed, avg ");
+        Serial.print(_recStepMsTotal[s] / _recStepRuns[s]);
+        Serial.print(" ms");
+    }
+    if (_recPhase != REC_IDLE) {
+        Serial.print(" (running: ");
+        Serial.print(i2cRecoveryStepName(_recStep));
+        Serial.print(")");
+    }
+    Serial.println();
+}
+
+#endif // I2C_RECOVERY_H
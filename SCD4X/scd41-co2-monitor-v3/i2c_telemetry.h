@@ -0,0 +1,330 @@
+/*
+ * I2C Transaction Telemetry
+ *
+ * Records every SCD41 command: how long it took and how it failed. Marginal
+ * wiring shows up as NACKs and CRC mismatches spread over all commands and
+ * a long latency tail (clock stretching, retries inside the Wire driver); a
+ * dead or hung sensor as address NACKs and timeouts, then bus recoveries.
+ *
+ * Per command (keyed by the scd4x_async.h command table):
+ *   - count, errors, min / max / total latency
+ *   - latency histogram in power-of-two buckets, 256 us .. 512 ms
+ * Overall:
+ *   - errors by kind: NACK, timeout, CRC, short read, other
+ *   - bus recoveries attempted / failed
+ *
+ * Errors are classified from the Sensirion Arduino core encoding, which
+ * the async layer shares: the high byte is the kind (0x01 write, 0x02 read,
+ * 0x06 CRC), the low byte of a write error is the Wire.endTransmission()
+ * code (2 = address NACK, 3 = data NACK, 5 = timeout).
+ *
+ * Library calls include the command's execution time (the library sleeps
+ * it), so e.g. read_measurement sits just above 1 ms; async commands
+ * record bus time only.
+ *
+ * Usage:
+ *   1. Pass i2cRecord to scd4xAsyncBegin() for the async commands
+ *   2. Around each library call:
+ *        uint32_t t = micros();
+ *        error = sensor.readMeasurement(...);
+ *        i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
+ *   3. i2cRecordRecovery(ok) after each bus recovery
+ *   4. i2cTelemetryPrint() for the "i2c" command, i2cTelemetryJson() for
+ *      the health event
+ */
+
+#ifndef I2C_TELEMETRY_H
+#define I2C_TELEMETRY_H
+
+#include <Arduino.h>
+#include "scd4x_async.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// Bucket 0 is < 256 us, bucket i < 256 << i us, the last one everything
+// from 512 ms up
+#define I2C_HIST_BUCKETS    13
+#define I2C_HIST_BASE_SHIFT 8
+
+// Longest i2cTelemetryJson() output including the NUL - every command
+// called, every counter at 10 digits. Size the buffer with this.
+#define I2C_TELEMETRY_JSON_SIZE _i2tJsonSize()
+
+// ===========================================
+// Types
+// ===========================================
+
+enum I2cErrorKind {
+    I2C_ERR_KIND_NONE = 0,
+    I2C_ERR_KIND_NACK,      // Address or data not acknowledged
+    I2C_ERR_KIND_TIMEOUT,   // Bus stuck (SCL held low)
+    I2C_ERR_KIND_CRC,       // Word arrived, checksum didn't match
+    I2C_ERR_KIND_READ,      // Fewer bytes than requested
+    I2C_ERR_KIND_OTHER,
+    I2C_ERR_KIND_COUNT
+};
+
+struct I2cCommandStats {
+    uint32_t count;
+    uint32_t errors;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t hist[I2C_HIST_BUCKETS];
+};
+
+// ===========================================
+// JSON size
+// ===========================================
+
+#define _I2T_U32_DIGITS 10
+
+static constexpr size_t _i2tStrlen(const char* s) {
+    return *s ? 1 + _i2tStrlen(s + 1) : 0;
+}
+
+// ,"<name>":{"n":N,"err":N,"avg_us":N,"max_us":N,"h":[N,...]}
+static constexpr size_t _i2tJsonCommandsSize(int c = 0) {
+    return c == SCD4X_COMMAND_COUNT ? 0 :
+           _i2tStrlen(SCD4X_COMMANDS[c].name) + 44 + 4 * _I2T_U32_DIGITS +
+           I2C_HIST_BUCKETS * (_I2T_U32_DIGITS + 1) + _i2tJsonCommandsSize(c + 1);
+}
+
+// {"recoveries":N,"recoveries_failed":N, 5 x ,"<kind>":N ,"commands":{ }} NUL
+static constexpr size_t _i2tJsonSize() {
+    return 35 + 2 * _I2T_U32_DIGITS +
+           5 * (4 + _I2T_U32_DIGITS) + _i2tStrlen("nacktimeoutcrcreadother") +
+           13 + 2 + 1 + _i2tJsonCommandsSize();
+}
+
+// ===========================================
+// State
+// ===========================================
+
+static I2cCommandStats _i2tStats[SCD4X_COMMAND_COUNT];
+static uint32_t _i2tErrors[I2C_ERR_KIND_COUNT];
+static uint32_t _i2tRecoveries = 0;
+static uint32_t _i2tRecoveriesFailed = 0;
+static int16_t _i2tLastError = 0;
+static Scd4xCommand _i2tLastErrorCmd = SCD4X_READ_MEASUREMENT;
+
+// ===========================================
+// Classification
+// ===========================================
+
+I2cErrorKind i2cClassifyError(int16_t error) {
+    if (error == 0) return I2C_ERR_KIND_NONE;
+    switch (error & 0xFF00) {
+    case SCD4X_ERR_WRITE:
+        switch (error & 0xFF) {
+            case 2:
+            case 3:  return I2C_ERR_KIND_NACK;
+            case 5:  return I2C_ERR_KIND_TIMEOUT;
+            default: return I2C_ERR_KIND_OTHER;
+        }
+    case SCD4X_ERR_READ: return I2C_ERR_KIND_READ;
+    case SCD4X_ERR_CRC:  return I2C_ERR_KIND_CRC;
+    default:             return I2C_ERR_KIND_OTHER;
+    }
+}
+
+const char* i2cErrorKindName(uint8_t kind) {
+    switch (kind) {
+        case I2C_ERR_KIND_NONE:    return "none";
+        case I2C_ERR_KIND_NACK:    return "nack";
+        case I2C_ERR_KIND_TIMEOUT: return "timeout";
+        case I2C_ERR_KIND_CRC:     return "crc";
+        case I2C_ERR_KIND_READ:    return "read";
+        default:                   return "other";
+    }
+}
+
+// ===========================================
+// Recording
+// ===========================================
+
+static uint8_t _i2tBucket(uint32_t us) {
+    uint8_t b = 0;
+    us >>= I2C_HIST_BASE_SHIFT;
+    while (us && b < I2C_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Upper edge of a bucket in us (0 for the open-ended last one)
+static uint32_t _i2tBucketLimit(uint8_t b) {
+    return b < I2C_HIST_BUCKETS - 1 ? (1UL << (I2C_HIST_BASE_SHIFT + b)) : 0;
+}
+
+void i2cRecord(Scd4xCommand cmd, uint32_t us, int16_t error) {
+    if (cmd >= SCD4X_COMMAND_COUNT) return;
+    I2cCommandStats &s = _i2tStats[cmd];
+    if (s.count == 0 || us < s.minUs) s.minUs = us;
+    if (us > s.maxUs) s.maxUs = us;
+    s.count++;
+    s.totalUs += us;
+    s.hist[_i2tBucket(us)]++;
+
+    if (error != 0) {
+        s.errors++;
+        _i2tErrors[i2cClassifyError(error)]++;
+        _i2tLastError = error;
+        _i2tLastErrorCmd = cmd;
+    }
+}
+
+void i2cRecordRecovery(bool ok) {
+    _i2tRecoveries++;
+    if (!ok) _i2tRecoveriesFailed++;
+}
+
+void i2cTelemetryReset() {
+    memset(_i2tStats, 0, sizeof(_i2tStats));
+    memset(_i2tErrors, 0, sizeof(_i2tErrors));
+    _i2tRecoveries = 0;
+    _i2tRecoveriesFailed = 0;
+    _i2tLastError = 0;
+}
+
+// ===========================================
+// Queries
+// ===========================================
+
+uint32_t i2cErrorCount(I2cErrorKind kind) {
+    return kind < I2C_ERR_KIND_COUNT ? _i2tErrors[kind] : 0;
+}
+
+uint32_t i2cRecoveryCount() {
+    return _i2tRecoveries;
+}
+
+// Latency below which pct percent of the command's calls finished, to
+// bucket resolution (0 = no calls, or in the open-ended bucket)
+uint32_t i2cPercentileUs(Scd4xCommand cmd, uint8_t pct) {
+    const I2cCommandStats &s = _i2tStats[cmd];
+    if (s.count == 0) return 0;
+    uint32_t target = ((uint64_t)s.count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < I2C_HIST_BUCKETS; b++) {
+        seen += s.hist[b];
+        if (seen >= target) return _i2tBucketLimit(b);
+    }
+    return 0;
+}
+
+// ===========================================
+// Reports
+// ===========================================
+
+void i2cTelemetryPrint() {
+    Serial.println();
+    Serial.println("=== I2C Telemetry ===");
+    Serial.println("command                           calls  errs   min    avg    p95    max (us)");
+    for (int c = 0; c < SCD4X_COMMAND_COUNT; c++) {
+        const I2cCommandStats &s = _i2tStats[c];
+        if (s.count == 0) continue;
+        char line[112];
+        snprintf(line, sizeof(line), "%-32s %6lu %5lu %6lu %6lu %6lu %6lu",
+                 scd4xCommandName((Scd4xCommand)c), (unsigned long)s.count,
+                 (unsigned long)s.errors, (unsigned long)s.minUs,
+                 (unsigned long)(s.totalUs / s.count),
+                 (unsigned long)i2cPercentileUs((Scd4xCommand)c, 95),
+                 (unsigned long)s.maxUs);
+        Serial.println(line);
+
+        Serial.print("  histogram:");
+        for (uint8_t b = 0; b < I2C_HIST_BUCKETS; b++) {
+            Serial.print(' ');
+            Serial.print(s.hist[b]);
+        }
+        Serial.println();
+    }
+    Serial.println("  (buckets <256us <512us <1ms <2ms ... <512ms >=512ms)");
+
+    Serial.print("Errors:");
+    for (uint8_t k = I2C_ERR_KIND_NACK; k < I2C_ERR_KIND_COUNT; k++) {
+        Serial.print(' ');
+        Serial.print(i2cErrorKindName(k));
+        Serial.print('=');
+        Serial.print(_i2tErrors[k]);
+    }
+    Serial.println();
+    if (_i2tLastError != 0) {
+        Serial.print("Last error: 0x");
+        Serial.print((uint16_t)_i2tLastError, HEX);
+        Serial.print(" (");
+        Serial.print(i2cErrorKindName(i2cClassifyError(_i2tLastError)));
+        Serial.print(") on ");
+        Serial.println(scd4xCommandName(_i2tLastErrorCmd));
+    }
+    Serial.print("Recoveries: ");
+    Serial.print(_i2tRecoveries);
+    Serial.print(" (");
+    Serial.print(_i2tRecoveriesFailed);
+    Serial.println(" failed)");
+    Serial.println("=====================");
+}
+
+// One line for the periodic diagnostics
+void i2cTelemetryPrintStats() {
+    uint32_t calls = 0;
+    for (int c = 0; c < SCD4X_COMMAND_COUNT; c++) calls += _i2tStats[c].count;
+    Serial.print("I2C: ");
+    Serial.print(calls);
+    Serial.print(" transactions,");
+    for (uint8_t k = I2C_ERR_KIND_NACK; k < I2C_ERR_KIND_COUNT; k++) {
+        Serial.print(' ');
+        Serial.print(i2cErrorKindName(k));
+        Serial.print('=');
+        Serial.print(_i2tErrors[k]);
+    }
+    Serial.print(", ");
+    Serial.print(_i2tRecoveries);
+    Serial.println(" recoveries");
+}
+
+// JSON object for an event's data field. Commands that were never called
+// are left out; "h" is the latency histogram, trailing empty buckets
+// dropped. False (and {"truncated":true}) if size is too small - use
+// I2C_TELEMETRY_JSON_SIZE.
+bool i2cTelemetryJson(char* buf, size_t size) {
+    size_t n = snprintf(buf, size, "{\"recoveries\":%lu,\"recoveries_failed\":%lu",
+                        (unsigned long)_i2tRecoveries, (unsigned long)_i2tRecoveriesFailed);
+    for (uint8_t k = I2C_ERR_KIND_NACK; k < I2C_ERR_KIND_COUNT && n < size; k++) {
+        n += snprintf(buf + n, size - n, ",\"%s\":%lu", i2cErrorKindName(k),
+                      (unsigned long)_i2tErrors[k]);
+    }
+    if (n < size) n += snprintf(buf + n, size - n, ",\"commands\":{");
+
+    bool first = true;
+    for (int c = 0; c < SCD4X_COMMAND_COUNT && n < size; c++) {
+        const I2cCommandStats &s = _i2tStats[c];
+        if (s.count == 0) continue;
+        n += snprintf(buf + n, size - n,
+                      "%s\"%s\":{\"n\":%lu,\"err\":%lu,\"avg_us\":%lu,\"max_us\":%lu,\"h\":[",
+                      first ? "" : ",", scd4xCommandName((Scd4xCommand)c),
+                      (unsigned long)s.count, (unsigned long)s.errors,
+                      (unsigned long)(s.totalUs / s.count), (unsigned long)s.maxUs);
+        uint8_t used = I2C_HIST_BUCKETS;
+        while (used > 1 && s.hist[used - 1] == 0) used--;
+        for (uint8_t b = 0; b < used && n < size; b++) {
+            n += snprintf(buf + n, size - n, "%s%lu", b ? "," : "", (unsigned long)s.hist[b]);
+        }
+        if (n < size) n += snprintf(buf + n, size - n, "]}");
+        first = false;
+    }
+    if (n < size) n += snprintf(buf + n, size - n, "}}");
+
+    // Truncated - better no data than broken JSON
+    if (n >= size) {
+        snprintf(buf, size, "{\"truncated\":true}");
+        return false;
+    }
+    return true;
+}
+
+#endif // I2C_TELEMETRY_H
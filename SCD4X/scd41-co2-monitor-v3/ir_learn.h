@@ -0,0 +1,507 @@
+/*
+ * IR Learn Mode - capture remotes with an IR receiver
+ *
+ * A 38kHz IR receiver module (TSOP38238 or similar) on a spare GPIO is
+ * read with the RMT peripheral in receive mode. `learn <name>` arms the
+ * receiver; the next remote button press is captured, cleaned up and
+ * stored in NVS under that name, and can be sent right away with
+ * `send <name>` - no Flipper capture or reflash needed.
+ *
+ * Processing a capture:
+ *   1. Denoise - the RMT glitch filter drops very short pulses, then any
+ *      remaining pulse shorter than IR_LEARN_MIN_PULSE_US is merged into
+ *      its neighbours
+ *   2. Decode as Whynter protocol frames (14 bytes) if possible
+ *   3. Otherwise quantize - durations within IR_LEARN_CLUSTER_PERCENT of
+ *      each other share one averaged level, up to 16 levels, and each
+ *      timing is stored as a 4-bit level index
+ *
+ * A 300-timing Whynter capture takes 14 bytes of payload; a non-Whynter
+ * remote of the same length takes ~180 bytes instead of 600.
+ *
+ * Learned signals are handed out as IrSignal entries, so the IR scheduler
+ * and sendIRSignal() treat them like the generated Whynter.ir table.
+ *
+ * Usage:
+ *   1. irLearnInit(pin) in setup()
+ *   2. irLearnPoll() every loop pass
+ *   3. irLearnStart(name) to capture, irLearnFind(name) to look up
+ */
+
+#ifndef IR_LEARN_H
+#define IR_LEARN_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "esp32-hal-rmt.h"
+#include "whynter_codes.h"
+#include "ir_scheduler.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define IR_LEARN_PREFS_NAMESPACE "irlearn"
+#define IR_LEARN_VERSION 1
+
+#define IR_LEARN_MAX_SIGNALS 8
+#define IR_LEARN_NAME_LEN    16      // Including terminator
+
+// Receive buffer: 4 RMT memory blocks of 64 symbols, 2 timings per symbol
+#define IR_LEARN_MAX_SYMBOLS 256
+#define IR_LEARN_MAX_TIMINGS (IR_LEARN_MAX_SYMBOLS * 2)
+
+// 1 MHz tick - durations in microseconds
+#define IR_LEARN_TICK_HZ 1000000
+
+// Receive ends after this much idle (longer than any inter-frame gap)
+#define IR_LEARN_IDLE_US 12000
+
+// Hardware glitch filter in ticks. The RMT filter counts the 80 MHz source
+// clock and tops out at 255 of those (~3.2 us); rmt_receive() refuses
+// anything longer, so this only catches spikes. Real denoising is the
+// software minimum pulse.
+#define IR_LEARN_FILTER_TICKS  3
+#define IR_LEARN_MIN_PULSE_US  150
+
+// Shorter captures are treated as noise and the receiver re-armed
+#define IR_LEARN_MIN_TIMINGS 16
+
+// Give up waiting for a button press after this long
+#define IR_LEARN_TIMEOUT_MS 15000
+
+// Quantization
+#define IR_LEARN_MAX_LEVELS      16
+#define IR_LEARN_CLUSTER_PERCENT 20
+
+#define IR_LEARN_FREQUENCY 38000    // Receiver demodulates; assume 38kHz
+
+// ===========================================
+// Types
+// ===========================================
+
+enum IrLearnKind {
+    IR_LEARN_EMPTY = 0,
+    IR_LEARN_WHYNTER = 1,     // Decoded protocol frames
+    IR_LEARN_QUANTIZED = 2    // Level table + 4-bit indices
+};
+
+// Stored record. Only the used part is written to NVS: up to `whynter`
+// for protocol captures, up to the used bytes of `packed` otherwise.
+struct IrLearnRecord {
+    uint8_t version;
+    uint8_t kind;                               // IrLearnKind
+    char name[IR_LEARN_NAME_LEN];
+    WhynterCommand whynter;
+    uint8_t levelCount;
+    uint16_t timingCount;
+    uint16_t levels[IR_LEARN_MAX_LEVELS];
+    uint8_t packed[IR_LEARN_MAX_TIMINGS / 2];   // Two timings per byte, low nibble first
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static Preferences _irlPrefs;
+static int _irlPin = -1;
+
+static IrLearnRecord _irlRecords[IR_LEARN_MAX_SIGNALS];
+static IrSignal _irlSignals[IR_LEARN_MAX_SIGNALS];
+static uint16_t* _irlRaw[IR_LEARN_MAX_SIGNALS];   // Expanded timings for quantized records
+
+// Capture in progress
+static bool _irlActive = false;
+static bool _irlArmed = false;                    // rmtReadAsync() outstanding
+static char _irlName[IR_LEARN_NAME_LEN];
+static unsigned long _irlStartMs = 0;
+static rmt_data_t _irlSymbols[IR_LEARN_MAX_SYMBOLS];
+static size_t _irlSymbolCount = 0;
+static uint16_t _irlTimings[IR_LEARN_MAX_TIMINGS];
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static void _irlSlotKey(int slot, char* key) {
+    snprintf(key, 8, "sig%d", slot);
+}
+
+static size_t _irlRecordSize(const IrLearnRecord &rec) {
+    if (rec.kind == IR_LEARN_WHYNTER) {
+        return offsetof(IrLearnRecord, levelCount);
+    }
+    return offsetof(IrLearnRecord, packed) + (rec.timingCount + 1) / 2;
+}
+
+static uint8_t _irlIndexAt(const IrLearnRecord &rec, int i) {
+    uint8_t b = rec.packed[i / 2];
+    return (i & 1) ? (b >> 4) : (b & 0x0F);
+}
+
+// Build the IrSignal the rest of the sketch sees for a slot
+static void _irlPublish(int slot) {
+    IrLearnRecord &rec = _irlRecords[slot];
+    IrSignal &sig = _irlSignals[slot];
+
+    if (_irlRaw[slot]) {
+        free(_irlRaw[slot]);
+        _irlRaw[slot] = nullptr;
+    }
+
+    memset(&sig, 0, sizeof(sig));
+    sig.name = rec.name;
+    sig.frequency = IR_LEARN_FREQUENCY;
+    sig.dutyCycle = 0.33f;
+
+    if (rec.kind == IR_LEARN_WHYNTER) {
+        sig.kind = IR_SIGNAL_WHYNTER;
+        sig.whynter = &rec.whynter;
+    } else if (rec.kind == IR_LEARN_QUANTIZED) {
+        _irlRaw[slot] = (uint16_t*)malloc(rec.timingCount * sizeof(uint16_t));
+        if (!_irlRaw[slot]) {
+            rec.kind = IR_LEARN_EMPTY;
+            return;
+        }
+        for (int i = 0; i < rec.timingCount; i++) {
+            _irlRaw[slot][i] = rec.levels[_irlIndexAt(rec, i)];
+        }
+        sig.kind = IR_SIGNAL_RAW;
+        sig.raw = _irlRaw[slot];
+        sig.rawLength = rec.timingCount;
+    }
+}
+
+static int _irlFindSlot(const char* name) {
+    for (int i = 0; i < IR_LEARN_MAX_SIGNALS; i++) {
+        if (_irlRecords[i].kind != IR_LEARN_EMPTY &&
+            strcasecmp(_irlRecords[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool _irlArm() {
+    _irlSymbolCount = IR_LEARN_MAX_SYMBOLS;
+    if (!rmtReadAsync(_irlPin, _irlSymbols, &_irlSymbolCount)) {
+        Serial.println("[Learn] RMT receive failed");
+        return false;
+    }
+    _irlArmed = true;
+    return true;
+}
+
+// RMT symbols -> alternating mark/space durations starting with a mark.
+// The receiver output is active low, so a mark is level 0.
+// Pulses shorter than IR_LEARN_MIN_PULSE_US are merged into their neighbours.
+static size_t _irlSymbolsToTimings(const rmt_data_t* symbols, size_t count, uint16_t* out) {
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (int half = 0; half < 2; half++) {
+            uint16_t duration = half ? symbols[i].duration1 : symbols[i].duration0;
+            uint8_t level = half ? symbols[i].level1 : symbols[i].level0;
+            if (duration == 0) continue;
+
+            bool mark = (level == 0);
+            if (len == 0 && !mark) continue;      // Leading idle
+
+            bool isMarkSlot = (len % 2) == 0;
+            if (mark == isMarkSlot) {
+                if (len >= IR_LEARN_MAX_TIMINGS) return len;
+                out[len++] = duration;
+            } else {
+                // Same level as the previous entry - extend it
+                uint32_t sum = out[len - 1] + duration;
+                out[len - 1] = min(sum, (uint32_t)0xFFFF);
+            }
+        }
+    }
+
+    // Glitches: fold a too-short pulse and the following pulse into the
+    // one before it (mark-space-mark -> one mark)
+    size_t w = 0;
+    for (size_t r = 0; r < len; r++) {
+        if (w >= 2 && r + 1 < len && out[r] < IR_LEARN_MIN_PULSE_US) {
+            uint32_t sum = out[w - 1] + out[r] + out[r + 1];
+            out[w - 1] = min(sum, (uint32_t)0xFFFF);
+            r++;
+            continue;
+        }
+        out[w++] = out[r];
+    }
+    len = w;
+
+    // End on a mark - the trailing space is just the idle timeout
+    if (len % 2 == 0 && len > 0) len--;
+    return len;
+}
+
+static int _irlCompareU16(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+// Cluster durations into averaged levels and pack 4-bit indices.
+// Returns false if there are more than IR_LEARN_MAX_LEVELS distinct levels.
+static bool _irlQuantize(const uint16_t* timings, size_t len, IrLearnRecord &rec,
+                         uint16_t &maxErrorUs) {
+    static uint16_t sorted[IR_LEARN_MAX_TIMINGS];
+    memcpy(sorted, timings, len * sizeof(uint16_t));
+    qsort(sorted, len, sizeof(uint16_t), _irlCompareU16);
+
+    // Upper bound of each cluster, and its average
+    uint16_t upper[IR_LEARN_MAX_LEVELS];
+    uint8_t levelCount = 0;
+    uint32_t sum = 0, n = 0;
+    uint16_t clusterStart = sorted[0];
+    for (size_t i = 0; i <= len; i++) {
+        bool split = (i == len) ||
+                     (uint32_t)sorted[i] * 100 > (uint32_t)clusterStart * (100 + IR_LEARN_CLUSTER_PERCENT);
+        if (split) {
+            if (levelCount >= IR_LEARN_MAX_LEVELS) return false;
+            rec.levels[levelCount] = (sum + n / 2) / n;
+            upper[levelCount] = sorted[i - 1];
+            levelCount++;
+            if (i == len) break;
+            clusterStart = sorted[i];
+            sum = 0;
+            n = 0;
+        }
+        sum += sorted[i];
+        n++;
+    }
+
+    memset(rec.packed, 0, sizeof(rec.packed));
+    maxErrorUs = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t level = 0;
+        while (level < levelCount - 1 && timings[i] > upper[level]) level++;
+        rec.packed[i / 2] |= (i & 1) ? (level << 4) : level;
+
+        uint16_t err = abs((int)timings[i] - (int)rec.levels[level]);
+        if (err > maxErrorUs) maxErrorUs = err;
+    }
+    rec.levelCount = levelCount;
+    rec.timingCount = len;
+    return true;
+}
+
+// Turn the finished capture into a record and store it
+static void _irlProcessCapture() {
+    size_t len = _irlSymbolsToTimings(_irlSymbols, _irlSymbolCount, _irlTimings);
+    if (len < IR_LEARN_MIN_TIMINGS) {
+        // Noise or a stray pulse - keep listening
+        _irlArm();
+        return;
+    }
+
+    IrLearnRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.version = IR_LEARN_VERSION;
+    strncpy(rec.name, _irlName, IR_LEARN_NAME_LEN - 1);
+
+    uint16_t maxErrorUs = 0;
+    if (whynterDecodeRaw(_irlTimings, len, rec.whynter)) {
+        rec.kind = IR_LEARN_WHYNTER;
+    } else if (_irlQuantize(_irlTimings, len, rec, maxErrorUs)) {
+        rec.kind = IR_LEARN_QUANTIZED;
+    } else {
+        Serial.print("[Learn] Capture has more than ");
+        Serial.print(IR_LEARN_MAX_LEVELS);
+        Serial.println(" distinct timings, not stored - try again");
+        _irlArm();
+        return;
+    }
+
+    // Replace an existing signal with the same name, else use a free slot
+    int slot = _irlFindSlot(_irlName);
+    if (slot < 0) {
+        for (int i = 0; i < IR_LEARN_MAX_SIGNALS; i++) {
+            if (_irlRecords[i].kind == IR_LEARN_EMPTY) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    _irlActive = false;
+    if (slot < 0) {
+        Serial.println("[Learn] All slots used - forget a signal first");
+        return;
+    }
+
+    irSchedCancelSignal(&_irlSignals[slot]);
+    _irlRecords[slot] = rec;
+    _irlPublish(slot);
+
+    char key[8];
+    _irlSlotKey(slot, key);
+    size_t size = _irlRecordSize(rec);
+    _irlPrefs.putBytes(key, &_irlRecords[slot], size);
+
+    Serial.print("[Learn] Stored ");
+    Serial.print(rec.name);
+    Serial.print(": ");
+    Serial.print(len);
+    Serial.print(" timings -> ");
+    if (rec.kind == IR_LEARN_WHYNTER) {
+        Serial.print("Whynter frame x");
+        Serial.print(rec.whynter.repeats);
+        Serial.print(rec.whynter.hasTrailer ? " + trailer" : "");
+    } else {
+        Serial.print(rec.levelCount);
+        Serial.print(" levels, max error ");
+        Serial.print(maxErrorUs);
+        Serial.print(" us");
+    }
+    Serial.print(", ");
+    Serial.print(size);
+    Serial.println(" bytes");
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+bool irLearnInit(int pin) {
+    _irlPrefs.begin(IR_LEARN_PREFS_NAMESPACE, false);
+
+    int loaded = 0;
+    for (int slot = 0; slot < IR_LEARN_MAX_SIGNALS; slot++) {
+        char key[8];
+        _irlSlotKey(slot, key);
+        IrLearnRecord &rec = _irlRecords[slot];
+        memset(&rec, 0, sizeof(rec));
+        _irlRaw[slot] = nullptr;
+
+        size_t size = _irlPrefs.getBytes(key, &rec, sizeof(rec));
+        if (size == 0) continue;
+        if (rec.version != IR_LEARN_VERSION || size != _irlRecordSize(rec)) {
+            memset(&rec, 0, sizeof(rec));
+            continue;
+        }
+        rec.name[IR_LEARN_NAME_LEN - 1] = '\0';
+        _irlPublish(slot);
+        loaded++;
+    }
+    if (loaded > 0) {
+        Serial.print("[Learn] Loaded ");
+        Serial.print(loaded);
+        Serial.println(" learned signals");
+    }
+
+    if (!rmtInit(pin, RMT_RX_MODE, RMT_MEM_NUM_BLOCKS_4, IR_LEARN_TICK_HZ)) {
+        Serial.println("[Learn] RMT receiver init failed");
+        return false;
+    }
+    rmtSetRxMaxThreshold(pin, IR_LEARN_IDLE_US);
+    rmtSetRxMinThreshold(pin, IR_LEARN_FILTER_TICKS);
+    _irlPin = pin;
+
+    Serial.print("[Learn] IR receiver on GPIO ");
+    Serial.println(pin);
+    return true;
+}
+
+// ===========================================
+// Start / cancel a capture
+// ===========================================
+
+bool irLearnStart(const char* name) {
+    if (_irlPin < 0) {
+        Serial.println("[Learn] No IR receiver");
+        return false;
+    }
+    if (strlen(name) == 0 || strlen(name) >= IR_LEARN_NAME_LEN) {
+        Serial.print("[Learn] Name must be 1-");
+        Serial.print(IR_LEARN_NAME_LEN - 1);
+        Serial.println(" characters");
+        return false;
+    }
+
+    strncpy(_irlName, name, IR_LEARN_NAME_LEN - 1);
+    _irlName[IR_LEARN_NAME_LEN - 1] = '\0';
+
+    // A read left over from a cancelled capture is still armed - reuse it
+    if (!_irlArmed && !_irlArm()) return false;
+
+    _irlActive = true;
+    _irlStartMs = millis();
+    Serial.print("[Learn] Point the remote at the receiver and press the button for ");
+    Serial.println(_irlName);
+    return true;
+}
+
+void irLearnCancel() {
+    if (!_irlActive) return;
+    _irlActive = false;
+    Serial.println("[Learn] Cancelled");
+}
+
+bool irLearnActive() {
+    return _irlActive;
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void irLearnPoll() {
+    if (_irlArmed && rmtReceiveCompleted(_irlPin)) {
+        _irlArmed = false;
+        if (_irlActive) {
+            _irlProcessCapture();
+        }
+    }
+
+    if (_irlActive && millis() - _irlStartMs >= IR_LEARN_TIMEOUT_MS) {
+        _irlActive = false;
+        Serial.println("[Learn] Timed out, nothing received");
+    }
+}
+
+// ===========================================
+// Lookup / management
+// ===========================================
+
+const IrSignal* irLearnFind(const char* name) {
+    int slot = _irlFindSlot(name);
+    return slot >= 0 ? &_irlSignals[slot] : nullptr;
+}
+
+bool irLearnForget(const char* name) {
+    int slot = _irlFindSlot(name);
+    if (slot < 0) return false;
+
+    irSchedCancelSignal(&_irlSignals[slot]);
+    char key[8];
+    _irlSlotKey(slot, key);
+    _irlPrefs.remove(key);
+    memset(&_irlRecords[slot], 0, sizeof(_irlRecords[slot]));
+    _irlPublish(slot);
+    return true;
+}
+
+void irLearnList() {
+    int count = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < IR_LEARN_MAX_SIGNALS; i++) {
+        const IrLearnRecord &rec = _irlRecords[i];
+        if (rec.kind == IR_LEARN_EMPTY) continue;
+        count++;
+        bytes += _irlRecordSize(rec);
+        Serial.print("  ");
+        Serial.print(rec.name);
+        Serial.print(rec.kind == IR_LEARN_WHYNTER ? " (Whynter, " : " (quantized, ");
+        Serial.print(_irlRecordSize(rec));
+        Serial.println(" bytes)");
+    }
+    Serial.print("[Learn] ");
+    Serial.print(count);
+    Serial.print("/");
+    Serial.print(IR_LEARN_MAX_SIGNALS);
+    Serial.print(" slots used, ");
+    Serial.print(bytes);
+    Serial.println(" bytes");
+}
+
+#endif // IR_LEARN_H
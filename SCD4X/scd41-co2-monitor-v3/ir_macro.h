@@ -0,0 +1,492 @@
+/*
+ * IR Macros and Time-of-day Schedules
+ *
+ * A macro is a named sequence of steps separated by ';':
+ *
+ *   macro add cooldown ac on; ac cool, fan high; wait 5000; ac swing on
+ *
+ * Each step is "wait <ms>", "ac <target>" (see ac_state.h) or a signal
+ * name (learned or from Whynter.ir). Steps are run one at a time from
+ * irMacroPoll(): a step waits until the IR scheduler has sent everything
+ * the previous step queued, plus IR_MACRO_STEP_GAP_MS so the AC has
+ * finished beeping. Nothing blocks the loop.
+ *
+ * A schedule runs a macro - or a single step - at a wall-clock time:
+ *
+ *   sched add 23:00 ac off
+ *   sched add 07:30 weekdays cooldown
+ *
+ * Schedules need the clock from NTP; until it's set they don't fire.
+ * Macros and schedules are stored in NVS. Each macro keeps run stats
+ * (runs, failures, last run, duration) for the diagnostics.
+ *
+ * Usage:
+ *   1. irMacroInit(stepFn) in setup(), after the IR scheduler - stepFn
+ *      executes one "ac ..." or signal step and returns false if it can't
+ *   2. irMacroPoll() every loop pass
+ *   3. irMacroRun(name) to start a macro
+ */
+
+#ifndef IR_MACRO_H
+#define IR_MACRO_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <time.h>
+#include "ir_scheduler.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define IR_MACRO_PREFS_NAMESPACE "irmacro"
+#define IR_MACRO_VERSION 1
+
+#define IR_MACRO_MAX_MACROS    8
+#define IR_MACRO_MAX_SCHEDULES 8
+#define IR_MACRO_NAME_LEN      16     // Including terminator
+#define IR_MACRO_STEPS_LEN     96     // Including terminator
+#define IR_MACRO_ACTION_LEN    48     // Including terminator
+
+// Pause after a step's frames have gone out, before the next step
+#define IR_MACRO_STEP_GAP_MS 1000
+
+// A step whose frames haven't gone out after this fails the run
+#define IR_MACRO_STEP_TIMEOUT_MS 10000
+
+// Schedules are checked this often
+#define IR_MACRO_SCHED_CHECK_MS 1000
+
+// Day masks (bit 0 = Sunday, as tm_wday)
+#define IR_DAYS_ALL      0x7F
+#define IR_DAYS_WEEKDAYS 0x3E
+#define IR_DAYS_WEEKENDS 0x41
+
+// ===========================================
+// Types
+// ===========================================
+
+// Executes one step, returns false if it couldn't
+typedef bool (*IrMacroStepFn)(const char* step);
+
+struct IrMacroRecord {
+    uint8_t version;
+    char name[IR_MACRO_NAME_LEN];
+    char steps[IR_MACRO_STEPS_LEN];
+};
+
+struct IrScheduleRecord {
+    uint8_t version;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t days;                          // IR_DAYS_* mask
+    char action[IR_MACRO_ACTION_LEN];      // Macro name or a single step
+};
+
+struct IrMacroStats {
+    uint32_t runs;
+    uint32_t failures;
+    time_t lastRun;                        // 0 = never (or clock not set)
+    uint32_t lastDurationMs;
+    bool lastFailed;
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static Preferences _irmPrefs;
+static IrMacroStepFn _irmStep = nullptr;
+
+static IrMacroRecord _irmMacros[IR_MACRO_MAX_MACROS];
+static IrMacroStats _irmStats[IR_MACRO_MAX_MACROS];
+static IrScheduleRecord _irmSchedules[IR_MACRO_MAX_SCHEDULES];
+
+// Run in progress
+static int _irmRunning = -1;               // Macro slot
+static const char* _irmNext = nullptr;     // Next step in the macro's text
+static bool _irmWaitingForSend = false;    // Previous step's frames still queued
+static unsigned long _irmStepStartMs = 0;
+static unsigned long _irmNextStepMs = 0;
+static unsigned long _irmRunStartMs = 0;
+
+// Schedule checking
+static unsigned long _irmLastSchedCheck = 0;
+static int _irmLastSchedMinute = -1;       // Minute of day last checked
+static uint32_t _irmScheduledRuns = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static void _irmMacroKey(int slot, char* key) {
+    snprintf(key, 8, "m%d", slot);
+}
+
+static void _irmSchedKey(int slot, char* key) {
+    snprintf(key, 8, "s%d", slot);
+}
+
+static int _irmFindMacro(const char* name) {
+    for (int i = 0; i < IR_MACRO_MAX_MACROS; i++) {
+        if (_irmMacros[i].version && strcasecmp(_irmMacros[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const char* _irmDaysName(uint8_t days) {
+    switch (days) {
+        case IR_DAYS_ALL:      return "daily";
+        case IR_DAYS_WEEKDAYS: return "weekdays";
+        case IR_DAYS_WEEKENDS: return "weekends";
+        default:               return "custom";
+    }
+}
+
+// Copies the next ';'-separated step into buf, trimmed. Returns the
+// position after it, or nullptr at the end.
+static const char* _irmNextStep(const char* p, char* buf, size_t len) {
+    while (*p == ' ' || *p == ';') p++;
+    if (!*p) return nullptr;
+
+    const char* end = strchr(p, ';');
+    size_t n = end ? (size_t)(end - p) : strlen(p);
+    while (n > 0 && p[n - 1] == ' ') n--;
+    if (n >= len) n = len - 1;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return end ? end + 1 : p + strlen(p);
+}
+
+static void _irmFinish(bool failed, const char* why = nullptr) {
+    IrMacroStats &stats = _irmStats[_irmRunning];
+    stats.lastDurationMs = millis() - _irmRunStartMs;
+    stats.lastFailed = failed;
+    if (failed) stats.failures++;
+
+    Serial.print("[Macro] ");
+    Serial.print(_irmMacros[_irmRunning].name);
+    if (failed) {
+        Serial.print(" failed: ");
+        Serial.println(why);
+    } else {
+        Serial.print(" done in ");
+        Serial.print(stats.lastDurationMs);
+        Serial.println(" ms");
+    }
+    _irmRunning = -1;
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void irMacroInit(IrMacroStepFn stepFn) {
+    _irmStep = stepFn;
+    _irmPrefs.begin(IR_MACRO_PREFS_NAMESPACE, false);
+
+    int macros = 0, schedules = 0;
+    char key[8];
+    for (int i = 0; i < IR_MACRO_MAX_MACROS; i++) {
+        _irmMacroKey(i, key);
+        if (_irmPrefs.getBytes(key, &_irmMacros[i], sizeof(IrMacroRecord)) != sizeof(IrMacroRecord) ||
+            _irmMacros[i].version != IR_MACRO_VERSION) {
+            memset(&_irmMacros[i], 0, sizeof(IrMacroRecord));
+        } else {
+            macros++;
+        }
+    }
+    for (int i = 0; i < IR_MACRO_MAX_SCHEDULES; i++) {
+        _irmSchedKey(i, key);
+        if (_irmPrefs.getBytes(key, &_irmSchedules[i], sizeof(IrScheduleRecord)) != sizeof(IrScheduleRecord) ||
+            _irmSchedules[i].version != IR_MACRO_VERSION) {
+            memset(&_irmSchedules[i], 0, sizeof(IrScheduleRecord));
+        } else {
+            schedules++;
+        }
+    }
+
+    Serial.print("[Macro] ");
+    Serial.print(macros);
+    Serial.print(" macros, ");
+    Serial.print(schedules);
+    Serial.println(" schedules");
+}
+
+// ===========================================
+// Macros
+// ===========================================
+
+bool irMacroDefine(const char* name, const char* steps) {
+    if (!*name || strlen(name) >= IR_MACRO_NAME_LEN) {
+        Serial.println("[Macro] Name must be 1-15 characters");
+        return false;
+    }
+    if (strlen(steps) >= IR_MACRO_STEPS_LEN) {
+        Serial.print("[Macro] Steps too long (max ");
+        Serial.print(IR_MACRO_STEPS_LEN - 1);
+        Serial.println(" characters)");
+        return false;
+    }
+
+    int slot = _irmFindMacro(name);
+    if (slot == _irmRunning && slot >= 0) {
+        Serial.println("[Macro] Can't redefine a running macro");
+        return false;
+    }
+    if (slot < 0) {
+        for (int i = 0; i < IR_MACRO_MAX_MACROS; i++) {
+            if (!_irmMacros[i].version) { slot = i; break; }
+        }
+    }
+    if (slot < 0) {
+        Serial.println("[Macro] No free slots, delete one first");
+        return false;
+    }
+
+    IrMacroRecord &rec = _irmMacros[slot];
+    rec.version = IR_MACRO_VERSION;
+    strncpy(rec.name, name, IR_MACRO_NAME_LEN - 1);
+    rec.name[IR_MACRO_NAME_LEN - 1] = '\0';
+    strncpy(rec.steps, steps, IR_MACRO_STEPS_LEN - 1);
+    rec.steps[IR_MACRO_STEPS_LEN - 1] = '\0';
+    memset(&_irmStats[slot], 0, sizeof(IrMacroStats));
+
+    char key[8];
+    _irmMacroKey(slot, key);
+    _irmPrefs.putBytes(key, &rec, sizeof(rec));
+    return true;
+}
+
+bool irMacroDelete(const char* name) {
+    int slot = _irmFindMacro(name);
+    if (slot < 0 || slot == _irmRunning) return false;
+
+    memset(&_irmMacros[slot], 0, sizeof(IrMacroRecord));
+    char key[8];
+    _irmMacroKey(slot, key);
+    _irmPrefs.remove(key);
+    return true;
+}
+
+bool irMacroExists(const char* name) {
+    return _irmFindMacro(name) >= 0;
+}
+
+bool irMacroRunning() {
+    return _irmRunning >= 0;
+}
+
+bool irMacroRun(const char* name) {
+    int slot = _irmFindMacro(name);
+    if (slot < 0) {
+        Serial.print("[Macro] No such macro: ");
+        Serial.println(name);
+        return false;
+    }
+    if (_irmRunning >= 0) {
+        Serial.print("[Macro] ");
+        Serial.print(_irmMacros[_irmRunning].name);
+        Serial.print(" still running, ");
+        Serial.print(name);
+        Serial.println(" not started");
+        _irmStats[slot].failures++;
+        return false;
+    }
+
+    _irmRunning = slot;
+    _irmNext = _irmMacros[slot].steps;
+    _irmWaitingForSend = false;
+    _irmRunStartMs = millis();
+    _irmNextStepMs = _irmRunStartMs;
+    _irmStats[slot].runs++;
+    time_t wallClock = time(nullptr);
+    _irmStats[slot].lastRun = wallClock > 1600000000 ? wallClock : 0;   // 0 until NTP sets the clock
+
+    Serial.print("[Macro] Running ");
+    Serial.println(_irmMacros[slot].name);
+    return true;
+}
+
+void irMacroStop() {
+    if (_irmRunning >= 0) _irmFinish(true, "stopped");
+}
+
+// ===========================================
+// Schedules
+// ===========================================
+
+// days: IR_DAYS_* mask. action: macro name or single step.
+int irScheduleAdd(uint8_t hour, uint8_t minute, uint8_t days, const char* action) {
+    if (hour > 23 || minute > 59 || !days || !*action ||
+        strlen(action) >= IR_MACRO_ACTION_LEN) {
+        return -1;
+    }
+    for (int i = 0; i < IR_MACRO_MAX_SCHEDULES; i++) {
+        if (_irmSchedules[i].version) continue;
+
+        IrScheduleRecord &rec = _irmSchedules[i];
+        rec.version = IR_MACRO_VERSION;
+        rec.hour = hour;
+        rec.minute = minute;
+        rec.days = days;
+        strncpy(rec.action, action, IR_MACRO_ACTION_LEN - 1);
+        rec.action[IR_MACRO_ACTION_LEN - 1] = '\0';
+
+        char key[8];
+        _irmSchedKey(i, key);
+        _irmPrefs.putBytes(key, &rec, sizeof(rec));
+        return i;
+    }
+    return -1;
+}
+
+bool irScheduleDelete(int slot) {
+    if (slot < 0 || slot >= IR_MACRO_MAX_SCHEDULES || !_irmSchedules[slot].version) {
+        return false;
+    }
+    memset(&_irmSchedules[slot], 0, sizeof(IrScheduleRecord));
+    char key[8];
+    _irmSchedKey(slot, key);
+    _irmPrefs.remove(key);
+    return true;
+}
+
+static void _irmRunAction(const char* action) {
+    _irmScheduledRuns++;
+    Serial.print("[Sched] ");
+    Serial.println(action);
+    if (_irmFindMacro(action) >= 0) {
+        irMacroRun(action);
+    } else if (_irmStep && !_irmStep(action)) {
+        Serial.println("[Sched] Step failed");
+    }
+}
+
+static void _irmCheckSchedules(unsigned long now) {
+    if (now - _irmLastSchedCheck < IR_MACRO_SCHED_CHECK_MS) return;
+    _irmLastSchedCheck = now;
+
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo, 0)) return;
+
+    // Fire once per matching minute
+    int minuteOfDay = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+    if (minuteOfDay == _irmLastSchedMinute) return;
+    _irmLastSchedMinute = minuteOfDay;
+
+    for (int i = 0; i < IR_MACRO_MAX_SCHEDULES; i++) {
+        const IrScheduleRecord &rec = _irmSchedules[i];
+        if (rec.version && rec.hour == timeinfo.tm_hour && rec.minute == timeinfo.tm_min &&
+            (rec.days & (1 << timeinfo.tm_wday))) {
+            _irmRunAction(rec.action);
+        }
+    }
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void irMacroPoll() {
+    unsigned long now = millis();
+    _irmCheckSchedules(now);
+
+    if (_irmRunning < 0) return;
+
+    // Wait for the previous step's frames to go out, then the step gap
+    if (_irmWaitingForSend) {
+        if (!irSchedIdle()) {
+            if (now - _irmStepStartMs >= IR_MACRO_STEP_TIMEOUT_MS) {
+                _irmFinish(true, "step timed out");
+            }
+            return;
+        }
+        _irmWaitingForSend = false;
+        _irmNextStepMs = now + IR_MACRO_STEP_GAP_MS;
+    }
+    if ((long)(now - _irmNextStepMs) < 0) return;
+
+    char step[IR_MACRO_STEPS_LEN];
+    const char* next = _irmNextStep(_irmNext, step, sizeof(step));
+    if (!next) {
+        _irmFinish(false);
+        return;
+    }
+    _irmNext = next;
+
+    if (strncasecmp(step, "wait ", 5) == 0) {
+        _irmNextStepMs = now + strtoul(step + 5, nullptr, 10);
+        return;
+    }
+
+    if (!_irmStep || !_irmStep(step)) {
+        char why[IR_MACRO_STEPS_LEN + 16];
+        snprintf(why, sizeof(why), "step '%s'", step);
+        _irmFinish(true, why);
+        return;
+    }
+    _irmWaitingForSend = true;
+    _irmStepStartMs = now;
+}
+
+// ===========================================
+// Listing / stats
+// ===========================================
+
+void irMacroList() {
+    int count = 0;
+    for (int i = 0; i < IR_MACRO_MAX_MACROS; i++) {
+        if (!_irmMacros[i].version) continue;
+        count++;
+        Serial.print("  ");
+        Serial.print(_irmMacros[i].name);
+        Serial.print(": ");
+        Serial.println(_irmMacros[i].steps);
+    }
+    if (count == 0) Serial.println("[Macro] No macros defined");
+}
+
+void irScheduleList() {
+    int count = 0;
+    for (int i = 0; i < IR_MACRO_MAX_SCHEDULES; i++) {
+        const IrScheduleRecord &rec = _irmSchedules[i];
+        if (!rec.version) continue;
+        count++;
+        char line[80];
+        snprintf(line, sizeof(line), "  %d: %02u:%02u %s -> %s", i, rec.hour, rec.minute,
+                 _irmDaysName(rec.days), rec.action);
+        Serial.println(line);
+    }
+    if (count == 0) Serial.println("[Sched] No schedules");
+}
+
+void irMacroPrintStats() {
+    Serial.print("Macros: ");
+    Serial.print(_irmRunning >= 0 ? _irmMacros[_irmRunning].name : "idle");
+    Serial.print(", ");
+    Serial.print(_irmScheduledRuns);
+    Serial.println(" scheduled runs");
+
+    for (int i = 0; i < IR_MACRO_MAX_MACROS; i++) {
+        if (!_irmMacros[i].version) continue;
+        const IrMacroStats &stats = _irmStats[i];
+
+        char last[24] = "never";
+        if (stats.lastRun > 0) {
+            struct tm timeinfo;
+            localtime_r(&stats.lastRun, &timeinfo);
+            strftime(last, sizeof(last), "%m-%d %H:%M", &timeinfo);
+        }
+
+        char line[96];
+        snprintf(line, sizeof(line), "  %s: %lu runs, %lu failures, last %s%s, %lu ms",
+                 _irmMacros[i].name, (unsigned long)stats.runs, (unsigned long)stats.failures,
+                 last, stats.lastFailed ? " (failed)" : "", (unsigned long)stats.lastDurationMs);
+        Serial.println(line);
+    }
+}
+
+#endif // IR_MACRO_H
@@ -0,0 +1,132 @@
+/*
+ * Non-blocking IR Transmitter using the ESP32 RMT peripheral
+ *
+ * IRsend::sendRaw() bit-bangs the 38kHz carrier and busy-waits for the
+ * whole frame (~330 ms for the 3-burst Whynter AC_ON), so the main loop
+ * stalls on every send. The RMT peripheral generates the carrier and the
+ * mark/space timing in hardware from an item buffer, so a send is queued
+ * in microseconds and completes in the background.
+ *
+ * Usage:
+ *   1. irRmtInit(pin) in setup()
+ *   2. Pre-encode raw timings once with irRmtEncodeRaw() into a static
+ *      rmt_data_t buffer (it must stay valid while transmitting)
+ *   3. irRmtSendAsync(items, count, callback) returns immediately
+ *   4. irRmtPoll() every loop pass - calls the callback when the frame is out
+ *
+ * Requires ESP32 Arduino core 3.x (esp32-hal-rmt).
+ */
+
+#ifndef IR_RMT_H
+#define IR_RMT_H
+
+#include <Arduino.h>
+#include "esp32-hal-rmt.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// 1 MHz RMT tick - item durations are in microseconds
+#define IR_RMT_TICK_HZ 1000000
+
+// Whynter captures: 38kHz carrier, 33% duty cycle (from Whynter.ir)
+#define IR_RMT_CARRIER_HZ 38000
+#define IR_RMT_DUTY_CYCLE 0.33
+
+// RMT item durations are 15 bits
+#define IR_RMT_MAX_DURATION 32767
+
+// ===========================================
+// State
+// ===========================================
+
+// Called from irRmtPoll() once a frame has finished transmitting
+typedef void (*IRSendCompleteCallback)(uint32_t durationUs);
+
+static int _irRmtPin = -1;
+static bool _irRmtBusy = false;
+static unsigned long _irRmtStartUs = 0;
+static IRSendCompleteCallback _irRmtCallback = nullptr;
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+bool irRmtInit(int pin) {
+    if (!rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, IR_RMT_TICK_HZ)) {
+        Serial.println("[IR] RMT init failed");
+        return false;
+    }
+    if (!rmtSetCarrier(pin, true, true, IR_RMT_CARRIER_HZ, IR_RMT_DUTY_CYCLE)) {
+        Serial.println("[IR] RMT carrier setup failed");
+        return false;
+    }
+
+    _irRmtPin = pin;
+    Serial.print("[IR] RMT transmitter on GPIO ");
+    Serial.println(pin);
+    return true;
+}
+
+// ===========================================
+// Encode mark/space timings (microseconds) into RMT items
+// Returns the number of items written, 0 if the buffer is too small
+// ===========================================
+
+size_t irRmtEncodeRaw(const uint16_t* raw, size_t len, rmt_data_t* items, size_t maxItems) {
+    size_t count = (len + 1) / 2;
+    if (count > maxItems) return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint16_t mark = raw[2 * i];
+        // Odd length ends on a mark; a zero-length space ends the transmission
+        uint16_t space = (2 * i + 1 < len) ? raw[2 * i + 1] : 0;
+
+        items[i].level0 = 1;
+        items[i].duration0 = min(mark, (uint16_t)IR_RMT_MAX_DURATION);
+        items[i].level1 = 0;
+        items[i].duration1 = min(space, (uint16_t)IR_RMT_MAX_DURATION);
+    }
+    return count;
+}
+
+// ===========================================
+// Queue a transmission - returns false if still sending the previous one
+// ===========================================
+
+bool irRmtSendAsync(rmt_data_t* items, size_t count, IRSendCompleteCallback callback = nullptr) {
+    if (_irRmtPin < 0 || _irRmtBusy) return false;
+
+    if (!rmtWriteAsync(_irRmtPin, items, count)) {
+        return false;
+    }
+
+    _irRmtBusy = true;
+    _irRmtStartUs = micros();
+    _irRmtCallback = callback;
+    return true;
+}
+
+bool irRmtBusy() {
+    return _irRmtBusy;
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void irRmtPoll() {
+    if (!_irRmtBusy) return;
+    if (!rmtTransmitCompleted(_irRmtPin)) return;
+
+    _irRmtBusy = false;
+    uint32_t durationUs = micros() - _irRmtStartUs;
+    if (_irRmtCallback) {
+        IRSendCompleteCallback callback = _irRmtCallback;
+        _irRmtCallback = nullptr;
+        callback(durationUs);
+    }
+}
+
+#endif // IR_RMT_H
@@ -0,0 +1,366 @@
+/*
+ * IR Transmit Scheduler
+ *
+ * Serial on/off, spam mode and (later) automatic control all want the one
+ * IR LED. Instead of each of them calling the transmitter directly and
+ * racing each other, they enqueue signals here and irSchedPoll() sends
+ * them one at a time:
+ *
+ *   - Bounded queue (IR_SCHED_QUEUE_LEN). When full, a new command evicts
+ *     the newest lower-priority entry, or is rejected.
+ *   - Priorities: manual > automatic > spam. FIFO within a priority.
+ *   - A signal that is already pending isn't queued twice; the pending
+ *     entry keeps its place and takes the higher of the two priorities.
+ *   - After a frame completes, the next one waits for a gap proportional
+ *     to the frame's length (IR_SCHED_GAP_PERCENT, at least
+ *     IR_SCHED_MIN_GAP_MS) so the AC sees separate commands.
+ *   - An entry leaves the queue only once sendFn has started it. If sendFn
+ *     fails (e.g. the transmitter is busy) the entry stays at the head and
+ *     the scheduler backs off, doubling from IR_SCHED_RETRY_MS; after
+ *     IR_SCHED_MAX_ATTEMPTS failures it is dropped.
+ *
+ * Stats: frames sent in the last minute, time spent waiting in the queue,
+ * coalesced and dropped commands, and commands given up after failed sends.
+ *
+ * Usage:
+ *   1. irSchedInit(sendFn) in setup() - sendFn starts a transmission and
+ *      returns false if it couldn't
+ *   2. irSchedEnqueue(signal, priority) from anywhere
+ *   3. irSchedOnComplete(durationUs) from the transmitter's completion callback
+ *   4. irSchedPoll() every loop pass
+ */
+
+#ifndef IR_SCHEDULER_H
+#define IR_SCHEDULER_H
+
+#include <Arduino.h>
+#include "whynter_codes.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+#define IR_SCHED_QUEUE_LEN 8
+
+// Idle time after a frame, as a percentage of its length
+#define IR_SCHED_GAP_PERCENT 25
+#define IR_SCHED_MIN_GAP_MS  20
+
+// A transmission that never reports completion is abandoned after this
+#define IR_SCHED_SEND_TIMEOUT_MS 2000
+
+// Failed sends back off 50, 100, 200 ms; the fourth failure drops the entry
+#define IR_SCHED_RETRY_MS     50
+#define IR_SCHED_MAX_ATTEMPTS 4
+
+// ===========================================
+// Types
+// ===========================================
+
+enum IRPriority {
+    IR_PRIO_MANUAL = 0,   // Serial / button - highest
+    IR_PRIO_AUTO = 1,     // Automatic control
+    IR_PRIO_SPAM = 2      // Spam mode - lowest
+};
+
+enum IREnqueueResult {
+    IR_QUEUED = 0,
+    IR_COALESCED = 1,     // Already pending, merged with the existing entry
+    IR_REJECTED = 2       // Queue full of equal/higher priority commands
+};
+
+// Starts transmitting a signal, returns false if it couldn't
+typedef bool (*IRSchedSendFn)(const IrSignal* signal);
+
+struct IRQueueEntry {
+    const IrSignal* signal;
+    IRPriority priority;
+    unsigned long enqueuedMs;
+    uint32_t seq;          // Insertion order, for FIFO within a priority
+    uint8_t failures;      // Failed sendFn calls so far
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static IRSchedSendFn _irsSend = nullptr;
+static IRQueueEntry _irsQueue[IR_SCHED_QUEUE_LEN];
+static uint8_t _irsCount = 0;
+static uint32_t _irsSeq = 0;
+
+static bool _irsInFlight = false;
+static unsigned long _irsSendStartMs = 0;
+static unsigned long _irsNextAllowedMs = 0;
+
+// Stats
+static uint32_t _irsSent = 0;
+static uint32_t _irsCoalesced = 0;
+static uint32_t _irsDropped = 0;
+static uint32_t _irsSendFailures = 0;
+static uint32_t _irsGaveUp = 0;
+static uint32_t _irsTotalWaitMs = 0;
+static uint32_t _irsMaxWaitMs = 0;
+static uint32_t _irsLastWaitMs = 0;
+
+// Frames sent per minute of uptime
+static uint32_t _irsSentThisMinute = 0;
+static uint32_t _irsSentLastMinute = 0;
+static unsigned long _irsMinuteIndex = 0;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static const char* _irsPriorityName(IRPriority priority) {
+    switch (priority) {
+        case IR_PRIO_MANUAL: return "manual";
+        case IR_PRIO_AUTO:   return "auto";
+        default:             return "spam";
+    }
+}
+
+static void _irsRemove(int index) {
+    for (int i = index; i < _irsCount - 1; i++) {
+        _irsQueue[i] = _irsQueue[i + 1];
+    }
+    _irsCount--;
+}
+
+// Highest priority, oldest first
+static int _irsNextIndex() {
+    int best = -1;
+    for (int i = 0; i < _irsCount; i++) {
+        if (best < 0 ||
+            _irsQueue[i].priority < _irsQueue[best].priority ||
+            (_irsQueue[i].priority == _irsQueue[best].priority &&
+             _irsQueue[i].seq < _irsQueue[best].seq)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Lowest priority, newest first - the eviction candidate
+static int _irsWorstIndex() {
+    int worst = -1;
+    for (int i = 0; i < _irsCount; i++) {
+        if (worst < 0 ||
+            _irsQueue[i].priority > _irsQueue[worst].priority ||
+            (_irsQueue[i].priority == _irsQueue[worst].priority &&
+             _irsQueue[i].seq > _irsQueue[worst].seq)) {
+            worst = i;
+        }
+    }
+    return worst;
+}
+
+static void _irsRollMinute(unsigned long now) {
+    unsigned long minuteIndex = now / 60000UL;
+    if (minuteIndex != _irsMinuteIndex) {
+        // A skipped minute had no sends
+        _irsSentLastMinute = (minuteIndex == _irsMinuteIndex + 1) ? _irsSentThisMinute : 0;
+        _irsSentThisMinute = 0;
+        _irsMinuteIndex = minuteIndex;
+    }
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void irSchedInit(IRSchedSendFn sendFn) {
+    _irsSend = sendFn;
+    _irsCount = 0;
+    _irsInFlight = false;
+    _irsNextAllowedMs = millis();
+}
+
+// ===========================================
+// Enqueue
+// ===========================================
+
+IREnqueueResult irSchedEnqueue(const IrSignal* signal, IRPriority priority) {
+    if (!signal) return IR_REJECTED;
+
+    // Coalesce with a pending copy of the same signal
+    for (int i = 0; i < _irsCount; i++) {
+        if (_irsQueue[i].signal == signal) {
+            if (priority < _irsQueue[i].priority) {
+                _irsQueue[i].priority = priority;
+            }
+            _irsCoalesced++;
+            return IR_COALESCED;
+        }
+    }
+
+    if (_irsCount >= IR_SCHED_QUEUE_LEN) {
+        int worst = _irsWorstIndex();
+        if (_irsQueue[worst].priority <= priority) {
+            _irsDropped++;
+            return IR_REJECTED;
+        }
+        Serial.print("[IR] Queue full, dropped ");
+        Serial.print(_irsQueue[worst].signal->name);
+        Serial.print(" (");
+        Serial.print(_irsPriorityName(_irsQueue[worst].priority));
+        Serial.println(")");
+        _irsRemove(worst);
+        _irsDropped++;
+    }
+
+    IRQueueEntry &entry = _irsQueue[_irsCount++];
+    entry.signal = signal;
+    entry.priority = priority;
+    entry.enqueuedMs = millis();
+    entry.seq = _irsSeq++;
+    entry.failures = 0;
+    return IR_QUEUED;
+}
+
+// Drop every pending command of one priority (e.g. when spam stops)
+void irSchedCancel(IRPriority priority) {
+    for (int i = _irsCount - 1; i >= 0; i--) {
+        if (_irsQueue[i].priority == priority) {
+            _irsRemove(i);
+        }
+    }
+}
+
+// Drop pending copies of one signal (e.g. before its data is replaced)
+void irSchedCancelSignal(const IrSignal* signal) {
+    for (int i = _irsCount - 1; i >= 0; i--) {
+        if (_irsQueue[i].signal == signal) {
+            _irsRemove(i);
+        }
+    }
+}
+
+// ===========================================
+// Completion - call from the transmitter's completion callback
+// ===========================================
+
+void irSchedOnComplete(uint32_t durationUs) {
+    _irsInFlight = false;
+
+    uint32_t gapMs = (durationUs / 1000) * IR_SCHED_GAP_PERCENT / 100;
+    if (gapMs < IR_SCHED_MIN_GAP_MS) gapMs = IR_SCHED_MIN_GAP_MS;
+    _irsNextAllowedMs = millis() + gapMs;
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void irSchedPoll() {
+    unsigned long now = millis();
+    _irsRollMinute(now);
+
+    if (_irsInFlight) {
+        if (now - _irsSendStartMs < IR_SCHED_SEND_TIMEOUT_MS) return;
+        Serial.println("[IR] Send never completed, releasing scheduler");
+        irSchedOnComplete(0);
+    }
+
+    if (_irsCount == 0 || !_irsSend) return;
+    if ((long)(now - _irsNextAllowedMs) < 0) return;
+
+    int index = _irsNextIndex();
+    IRQueueEntry entry = _irsQueue[index];
+
+    // Mark in flight first - a blocking sendFn completes before returning
+    _irsInFlight = true;
+    _irsSendStartMs = now;
+    bool started = _irsSend(entry.signal);
+
+    // sendFn may have queued or cancelled commands, so find the entry again
+    index = -1;
+    for (int i = 0; i < _irsCount; i++) {
+        if (_irsQueue[i].seq == entry.seq) {
+            index = i;
+            break;
+        }
+    }
+
+    if (!started) {
+        _irsInFlight = false;
+        _irsSendFailures++;
+        if (index < 0) return;
+
+        IRQueueEntry &failed = _irsQueue[index];
+        failed.failures++;
+        if (failed.failures >= IR_SCHED_MAX_ATTEMPTS) {
+            Serial.print("[IR] Giving up on ");
+            Serial.print(failed.signal->name);
+            Serial.print(" after ");
+            Serial.print(failed.failures);
+            Serial.println(" failed sends");
+            _irsRemove(index);
+            _irsGaveUp++;
+            return;
+        }
+        _irsNextAllowedMs = now + (IR_SCHED_RETRY_MS << (failed.failures - 1));
+        return;
+    }
+
+    if (index >= 0) _irsRemove(index);
+
+    uint32_t waitMs = now - entry.enqueuedMs;
+    _irsLastWaitMs = waitMs;
+    _irsTotalWaitMs += waitMs;
+    if (waitMs > _irsMaxWaitMs) _irsMaxWaitMs = waitMs;
+    _irsSent++;
+    _irsSentThisMinute++;
+}
+
+// ===========================================
+// Status / stats
+// ===========================================
+
+uint8_t irSchedQueueDepth() {
+    return _irsCount;
+}
+
+bool irSchedIdle() {
+    return _irsCount == 0 && !_irsInFlight;
+}
+
+uint32_t irSchedSent() {
+    return _irsSent;
+}
+
+// Frames sent in the last complete minute (current minute during the first)
+uint32_t irSchedSendsPerMinute() {
+    return _irsMinuteIndex > 0 ? _irsSentLastMinute : _irsSentThisMinute;
+}
+
+uint32_t irSchedAvgWaitMs() {
+    return _irsSent > 0 ? _irsTotalWaitMs / _irsSent : 0;
+}
+
+uint32_t irSchedMaxWaitMs() {
+    return _irsMaxWaitMs;
+}
+
+uint32_t irSchedLastWaitMs() {
+    return _irsLastWaitMs;
+}
+
+uint32_t irSchedCoalesced() {
+    return _irsCoalesced;
+}
+
+uint32_t irSchedDropped() {
+    return _irsDropped;
+}
+
+uint32_t irSchedSendFailures() {
+    return _irsSendFailures;
+}
+
+// Commands dropped after IR_SCHED_MAX_ATTEMPTS failed sends
+uint32_t irSchedGaveUp() {
+    return _irsGaveUp;
+}
+
+#endif // IR_SCHEDULER_H
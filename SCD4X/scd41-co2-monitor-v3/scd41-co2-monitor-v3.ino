@@ -9,6 +9,7 @@
  *   - Sensirion SCD41 CO2 sensor (I2C)
  *   - Inland 1.3" 128x64 OLED (SH1106, SPI) - mounted upside-down
  *   - IR LED on GPIO 4
+ *   - Optional 38kHz IR receiver (TSOP38238) on GPIO 34 for learn mode
  *
  * Wiring:
  *   SCD41 (I2C):           OLED (SPI):              IR LED:
@@ -20,15 +21,39 @@
  *                          DC   -> GPIO 14
  *                          CS   -> GPIO 27
  *
+ *   IR receiver (optional): VS -> 3V3, GND -> GND, OUT -> GPIO 34
+ *
  * Serial Commands (for IR control):
  *   on      - Send AC ON signal once
  *   off     - Send AC OFF signal once
  *   spamon  - Start spamming ON signal (250ms interval)
  *   spamoff - Start spamming OFF signal (250ms interval)
  *   stop    - Stop spamming
+ *   send X  - Send a named signal from Whynter.ir (e.g. send fan_high)
+ *   codes   - List the named signals
+ *   ac X    - Set AC state, sending only what changed (e.g. ac cool, fan high)
+ *   ac      - Print the assumed AC state
+ *   learn X - Capture a remote button with the IR receiver, store it as X
+ *   learned - List learned signals
+ *   forget X - Delete a learned signal
+ *   frc PPM [S] - Start FRC against PPM, optional warmup S seconds (frc cancel)
+ *   cal     - Print calibration history and the drift estimate
+ *   i2c     - Print per-command I2C latency and error counters (i2c reset to clear)
+ *   vent    - Print ventilation control stats (vent on / vent off to enable/disable)
+ *   fan     - Print fan confirmation stats (MQTT fan node and sensor inference)
+ *   macro   - List macros (macro add NAME steps / macro del NAME / macro stop)
+ *   run X   - Run macro X
+ *   sched   - List schedules (sched add HH:MM [weekdays|weekends] action / sched del N)
  *   spam    - Toggle spam mode
+ *   bench   - Time display rendering with/without glyph cache
+ *   snap    - Dump every screen state as PBM snapshots
+ *   latency - Print loop latency stats and reset them
  *   help    - Print available commands
  *
+ * Display pages:
+ *   Short-press BOOT to cycle reading / trend / network / IR / diagnostics.
+ *   Double-press BOOT to stop IR spam (same as "stop").
+ *
  * Calibration:
  *   Hold BOOT button for 3 seconds to start forced recalibration.
  *   Take sensor outside to fresh air first!
@@ -41,9 +66,24 @@
 #include <Wire.h>
 #include <U8g2lib.h>
 #include <esp_task_wdt.h>
+
+// IR backend: 1 = RMT peripheral (non-blocking), 0 = IRsend::sendRaw (blocking)
+#define IR_USE_RMT 1
+
+#if IR_USE_RMT
+#include "ir_rmt.h"
+#else
 #include <IRremoteESP8266.h>
 #include <IRsend.h>
-
+#endif
+
+#include "whynter_codes.h"
+#include "ir_scheduler.h"
+#include "ac_state.h"
+#include "ir_learn.h"
+#include "fan_link.h"
+#include "ac_confirm.h"
+#include "ir_macro.h"
 #include "secrets.h"
 
 // Event types (must be defined before forced_calibration.h)
@@ -54,10 +94,21 @@ enum EventType {
     EVENT_CRITICAL = 3
 };
 
-// Forward declaration for forced_calibration.h callback
-bool sendEvent(EventType type, const char* message);
+// Forward declaration for forced_calibration.h callback. category and data
+// (a JSON object) are optional, for structured events.
+bool sendEvent(EventType type, const char* message,
+               const char* category = nullptr, const char* data = nullptr);
 
 #include "forced_calibration.h"
+#include "i2c_telemetry.h"
+#include "i2c_recovery.h"
+#include "scd4x_mux.h"
+#include "calibration_history.h"
+#include "button_input.h"
+#include "glyph_cache.h"
+#include "display_screens.h"
+#include "display_power.h"
+#include "vent_control.h"
 
 // ===========================================
 // Configuration
@@ -82,9 +133,22 @@ const int WATCHDOG_TIMEOUT_SECONDS = 120;
 // IR spam interval
 const unsigned long IR_SPAM_INTERVAL_MS = 250;
 
+// Loop passes slower than this are counted as stalls in the latency stats
+const unsigned long LOOP_STALL_THRESHOLD_US = 100000;
+
 // Display update interval (update more frequently than measurements for responsiveness)
 const unsigned long DISPLAY_UPDATE_INTERVAL_MS = 1000;
 
+// Frames rendered per variant by the "bench" serial command
+const int DISPLAY_BENCH_FRAMES = 20;
+
+// Readings kept for the trend page (60 x 60s = last hour)
+const int TREND_HISTORY_LEN = 60;
+
+// Wall-clock time (display quiet hours) - US Central with DST
+const char* NTP_SERVER = "pool.ntp.org";
+const char* TIMEZONE = "CST6CDT,M3.2.0,M11.1.0";
+
 // ===========================================
 // Hardware Pin Definitions
 // ===========================================
@@ -105,6 +169,9 @@ const unsigned long DISPLAY_UPDATE_INTERVAL_MS = 1000;
 // IR LED
 #define IR_LED_PIN 4
 
+// IR receiver for learn mode (input-only pin)
+#define IR_RX_PIN 34
+
 // ===========================================
 // OLED Display (Software SPI, rotated 180° for upside-down mounting)
 // ===========================================
@@ -112,64 +179,27 @@ const unsigned long DISPLAY_UPDATE_INTERVAL_MS = 1000;
 U8G2_SH1106_128X64_NONAME_F_4W_SW_SPI u8g2(U8G2_R2, OLED_CLK, OLED_MOSI, OLED_CS, OLED_DC, OLED_RES);
 
 // ===========================================
-// IR Signal Data (Whynter AC - from Flipper Zero capture)
-// 38kHz carrier, timings in microseconds
-// ===========================================
-
-// AC_ON raw timing data (3 bursts)
-const uint16_t AC_ON_RAW[] = {
-    4384, 4450, 512, 1639, 516, 591, 486, 1641, 514, 1642, 512, 563, 514, 563, 514, 1640,
-    514, 563, 514, 562, 515, 1639, 515, 564, 513, 563, 514, 1641, 514, 1641, 514, 563,
-    514, 1640, 515, 563, 514, 562, 515, 562, 515, 1642, 513, 1641, 514, 1639, 516, 1638,
-    516, 1640, 515, 1638, 518, 1639, 515, 1643, 565, 509, 515, 562, 515, 562, 515, 591,
-    486, 562, 515, 562, 515, 562, 515, 562, 515, 1641, 514, 562, 515, 1641, 514, 563,
-    514, 562, 515, 1668, 487, 1641, 514, 1641, 514, 562, 515, 1641, 567, 510, 514, 1641,
-    514, 1642, 513, 5239,
-    // Second burst (repeat)
-    4385, 4451, 512, 1640, 515, 563, 514, 1642, 565, 1588, 514, 562, 515, 562, 515, 1640,
-    515, 562, 515, 562, 515, 1640, 515, 562, 515, 562, 515, 1640, 514, 1641, 567, 509,
-    515, 1638, 517, 562, 515, 563, 514, 562, 515, 1639, 516, 1640, 515, 1640, 515, 1639,
-    516, 1639, 516, 1641, 514, 1640, 515, 1640, 515, 562, 515, 562, 515, 563, 514, 562,
-    515, 562, 515, 562, 515, 563, 514, 563, 514, 1641, 514, 562, 515, 1638, 516, 562,
-    515, 563, 514, 1640, 515, 1640, 514, 1641, 514, 591, 486, 1639, 516, 563, 567, 1588,
-    514, 1668, 487, 5240,
-    // Third burst
-    4384, 4447, 516, 1668, 486, 1641, 514, 562, 515, 1669, 486, 563, 514, 1641, 514, 564,
-    513, 1639, 516, 562, 515, 1641, 514, 1668, 487, 562, 515, 563, 514, 1640, 515, 562,
-    515, 1639, 516, 563, 514, 563, 514, 1640, 515, 562, 515, 563, 568, 508, 516, 562,
-    515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562,
-    515, 1639, 516, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 563, 514, 563,
-    514, 563, 514, 591, 486, 1639, 516, 562, 515, 1668, 487, 1640, 515, 562, 515, 1640,
-    515, 1641, 514
-};
-const uint16_t AC_ON_RAW_LEN = sizeof(AC_ON_RAW) / sizeof(AC_ON_RAW[0]);
-
-// AC_OFF raw timing data (2 bursts)
-const uint16_t AC_OFF_RAW[] = {
-    4379, 4477, 486, 1643, 512, 564, 513, 1669, 486, 1669, 486, 564, 514, 565, 512, 1639,
-    569, 511, 513, 563, 514, 1641, 567, 510, 515, 565, 512, 1669, 539, 1588, 514, 591,
-    486, 1640, 515, 562, 515, 1669, 486, 1641, 514, 1642, 513, 1643, 512, 564, 513, 1642,
-    513, 1641, 514, 1642, 512, 564, 513, 563, 514, 564, 513, 591, 486, 1669, 486, 563,
-    514, 563, 514, 1669, 486, 1641, 514, 1642, 513, 591, 486, 564, 514, 564, 513, 591,
-    486, 564, 513, 591, 486, 564, 513, 563, 514, 1642, 513, 1642, 513, 1641, 514, 1641,
-    514, 1640, 515, 5241,
-    // Second burst
-    4385, 4449, 514, 1641, 514, 563, 514, 1640, 515, 1641, 514, 563, 514, 563, 514, 1644,
-    511, 563, 514, 563, 514, 1641, 514, 562, 515, 563, 514, 1641, 514, 1640, 515, 563,
-    514, 1641, 514, 564, 513, 1643, 512, 1643, 512, 1642, 513, 1640, 515, 563, 514, 1642,
-    514, 1639, 516, 1642, 513, 563, 514, 563, 514, 563, 514, 565, 512, 1642, 513, 563,
-    567, 509, 516, 1641, 514, 1668, 486, 1642, 513, 563, 514, 563, 514, 591, 486, 565,
-    512, 562, 516, 562, 515, 562, 515, 563, 514, 1641, 514, 1641, 514, 1640, 514, 1641,
-    514, 1642, 513
-};
-const uint16_t AC_OFF_RAW_LEN = sizeof(AC_OFF_RAW) / sizeof(AC_OFF_RAW[0]);
+// IR Commands (Whynter AC)
+// whynter_codes.h is generated from whynter-ir-blaster/Whynter.ir by
+// flipper_ir_codegen.py; timings are synthesized by whynter_protocol.h
+// ===========================================
+
+// Timings are synthesized into this buffer at send time
+static uint16_t irRawBuffer[WHYNTER_MAX_RAW_LEN];
+
+#if IR_USE_RMT
+// RMT items for the frame being sent - must stay valid until it completes
+static rmt_data_t irItems[(WHYNTER_MAX_RAW_LEN + 1) / 2];
+#endif
 
 // ===========================================
 // Global state
 // ===========================================
 
 SensirionI2cScd4x sensor;
+#if !IR_USE_RMT
 IRsend irsend(IR_LED_PIN);
+#endif
 
 // Display state
 static uint16_t displayCO2 = 0;
@@ -178,154 +208,246 @@ static float displayHumidity = 0.0;
 static bool displayError = false;
 static bool displayWaiting = true;
 static unsigned long lastDisplayUpdate = 0;
+static bool glyphCacheEnabled = true;
+
+// Display timing (microseconds, last updateDisplay() call)
+static uint32_t lastDisplayDrawUs = 0;
+static uint32_t lastDisplaySendUs = 0;
+
+// Display pages - short BOOT press cycles through them, only the
+// visible page is computed and drawn
+enum DisplayPage {
+    PAGE_READING = 0,
+    PAGE_TREND,
+    PAGE_NETWORK,
+    PAGE_IR,
+    PAGE_DIAGNOSTICS,
+    PAGE_COUNT
+};
+static DisplayPage currentPage = PAGE_READING;
+
+// CO2 history for the trend page (ring buffer)
+static uint16_t co2History[TREND_HISTORY_LEN];
+static int co2HistoryHead = 0;
+static int co2HistoryCount = 0;
 
 // IR state
 static bool irSpamming = false;
 static bool irSpamOn = true;  // true = spam ON signal, false = spam OFF signal
 static unsigned long lastIrSpam = 0;
+static uint32_t irFramesSent = 0;
+static unsigned long lastIrSendTime = 0;
+static uint32_t lastIrFrameUs = 0;       // Duration of the last transmitted frame
+static uint32_t irSendsSkippedBusy = 0;  // Sends dropped because a frame was still going out
+static const IrSignal* irSignalOn = nullptr;
+static const IrSignal* irSignalOff = nullptr;
+
+// Loop latency (time between loop() starts), reset by the "latency" command
+static unsigned long lastLoopStartUs = 0;
+static uint32_t loopPasses = 0;
+static uint64_t loopTotalUs = 0;
+static uint32_t loopMaxUs = 0;
+static uint32_t loopStalls = 0;
 
 // Stats
 static uint32_t totalMeasurements = 0;
 static uint32_t successfulUploads = 0;
+static uint32_t warmupUploads = 0;      // FRC warmup, not in the success rate
 static uint32_t totalI2CErrors = 0;
 static uint32_t totalWiFiReconnects = 0;
-static uint32_t consecutiveI2CFailures = 0;
 static uint32_t consecutiveUploadFailures = 0;
 
 // Timing
 static unsigned long lastMeasurementTime = 0;
+static unsigned long lastWarmupUploadTime = 0;
+
+// 5 s readings taken while the AC confirmation window is open. The latest
+// one stands in for the 60 s reading, whose data-ready flag it cleared.
+static unsigned long lastFastSampleTime = 0;
+static unsigned long fastSampleTime = 0;
+static uint16_t fastCO2 = 0;
+static float fastTemp = 0.0;
+static float fastHumidity = 0.0;
 
 // ===========================================
 // Display Functions
 // ===========================================
 
+void drawReadingPage() {
+    ScreenReading reading;
+    reading.co2 = displayCO2;
+    reading.temp = displayTemp;
+    reading.humidity = displayHumidity;
+    reading.error = displayError;
+    reading.waiting = displayWaiting;
+    reading.useGlyphCache = glyphCacheEnabled;
+    reading.wifiConnected = WiFi.status() == WL_CONNECTED;
+    reading.rssi = reading.wifiConnected ? WiFi.RSSI() : 0;
+    reading.irStatus = irSpamming ? (irSpamOn ? "IR:ON" : "IR:OFF") : nullptr;
+    reading.uptimeMs = millis();
+    screenDrawReading(u8g2, reading);
+}
+
+// The last row's descenders (1 px below the baseline) must stay on the
+// 64-row panel after the burn-in shift, which moves content down on screen
+static_assert(PAGE_ROW_FIRST_Y + (PAGE_ROWS - 1) * PAGE_ROW_HEIGHT + 1 + DP_SHIFT_MAX_PX <= 63,
+              "Secondary page rows run off the bottom of the display");
+
+void drawTrendPage() {
+    ScreenTrend trend;
+    trend.history = co2History;
+    trend.capacity = TREND_HISTORY_LEN;
+    trend.head = co2HistoryHead;
+    trend.count = co2HistoryCount;
+    screenDrawTrendPage(u8g2, currentPage, PAGE_COUNT, trend);
+}
+
+void drawNetworkPage() {
+    ScreenNetwork net;
+    String ip = WiFi.localIP().toString();
+    net.connected = WiFi.status() == WL_CONNECTED;
+    net.ip = ip.c_str();
+    net.rssi = net.connected ? WiFi.RSSI() : 0;
+    net.uploads = successfulUploads;
+    net.measurements = totalMeasurements;
+    net.consecutiveFailures = consecutiveUploadFailures;
+    net.reconnects = totalWiFiReconnects;
+    screenDrawNetworkPage(u8g2, currentPage, PAGE_COUNT, net);
+}
+
+void drawIrPage() {
+    char state[24];
+    acStateDescribe(state, sizeof(state));
+
+    ScreenIr ir;
+    ir.spamming = irSpamming;
+    ir.spamOn = irSpamOn;
+    ir.framesSent = irFramesSent;
+    ir.lastSendAgoS = lastIrSendTime > 0 ? (long)((millis() - lastIrSendTime) / 1000) : -1;
+    ir.acState = state;
+    ir.queueDepth = irSchedQueueDepth();
+    ir.sendsPerMinute = irSchedSendsPerMinute();
+    ir.avgWaitMs = irSchedAvgWaitMs();
+    ir.maxWaitMs = irSchedMaxWaitMs();
+    screenDrawIrPage(u8g2, currentPage, PAGE_COUNT, ir);
+}
+
+void drawDiagnosticsPage() {
+    ScreenDiagnostics diag;
+    diag.measurements = totalMeasurements;
+    diag.i2cErrors = totalI2CErrors;
+    diag.freeHeap = ESP.getFreeHeap();
+    diag.uptimeMs = millis();
+    diag.drawUs = lastDisplayDrawUs;
+    diag.sendUs = lastDisplaySendUs;
+    diag.panelOnMs = displayPowerPanelOnMs();
+    diag.framesPerHour = displayPowerFramesPerHour();
+    screenDrawDiagnosticsPage(u8g2, currentPage, PAGE_COUNT, diag);
+}
+
+// Render the visible page only (nothing while the panel is blanked)
 void updateDisplay() {
-    u8g2.clearBuffer();
+    if (!displayPowerPanelOn()) {
+        return;
+    }
 
-    // CO2 reading - big and centered
-    u8g2.setFont(u8g2_font_logisoso28_tn);  // Large numeric font
-    char co2Str[8];
+    unsigned long drawStart = micros();
+    u8g2.clearBuffer();
 
-    if (displayError) {
-        strcpy(co2Str, "ERR");
-        u8g2.setFont(u8g2_font_ncenB14_tr);
-    } else if (displayWaiting || displayCO2 == 0) {
-        strcpy(co2Str, "---");
-    } else {
-        snprintf(co2Str, sizeof(co2Str), "%d", displayCO2);
+    switch (currentPage) {
+        case PAGE_TREND:       drawTrendPage(); break;
+        case PAGE_NETWORK:     drawNetworkPage(); break;
+        case PAGE_IR:          drawIrPage(); break;
+        case PAGE_DIAGNOSTICS: drawDiagnosticsPage(); break;
+        default:               drawReadingPage(); break;
     }
 
-    // Center the CO2 value
-    int width = u8g2.getStrWidth(co2Str);
-    u8g2.drawStr((128 - width) / 2 - 15, 32, co2Str);
+    displayPowerBeforeSend(u8g2);
 
-    // "ppm" label
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.drawStr(90, 32, "ppm");
+    unsigned long sendStart = micros();
+    lastDisplayDrawUs = sendStart - drawStart;
+    u8g2.sendBuffer();
+    lastDisplaySendUs = micros() - sendStart;
+}
 
-    // Temp and humidity on same line
-    u8g2.setFont(u8g2_font_6x10_tr);
-    char envStr[32];
-    if (!displayWaiting && displayCO2 > 0) {
-        snprintf(envStr, sizeof(envStr), "%.1fC  %.0f%%", displayTemp, displayHumidity);
-    } else {
-        strcpy(envStr, "--.-C  --%");
+void nextDisplayPage() {
+    currentPage = (DisplayPage)((currentPage + 1) % PAGE_COUNT);
+}
+
+void recordTrendReading(uint16_t co2) {
+    co2History[co2HistoryHead] = co2;
+    co2HistoryHead = (co2HistoryHead + 1) % TREND_HISTORY_LEN;
+    if (co2HistoryCount < TREND_HISTORY_LEN) {
+        co2HistoryCount++;
     }
-    width = u8g2.getStrWidth(envStr);
-    u8g2.drawStr((128 - width) / 2, 45, envStr);
+}
 
-    // Divider line
-    u8g2.drawHLine(0, 50, 128);
+// Render the main screen repeatedly with and without the glyph cache
+void runDisplayBenchmark() {
+    bool savedEnabled = glyphCacheEnabled;
+    DisplayPage savedPage = currentPage;
+    currentPage = PAGE_READING;
 
-    // Status bar at bottom
-    u8g2.setFont(u8g2_font_5x7_tr);
+    Serial.println();
+    Serial.println("=== Display Benchmark ===");
+    Serial.print("Frames per variant: ");
+    Serial.println(DISPLAY_BENCH_FRAMES);
+
+    for (int variant = 0; variant < 2; variant++) {
+        glyphCacheEnabled = (variant == 0);
+        if (glyphCacheEnabled && !glyphCacheReady()) {
+            Serial.println("Glyph cache: not available, skipped");
+            continue;
+        }
 
-    // WiFi indicator
-    if (WiFi.status() == WL_CONNECTED) {
-        int rssi = WiFi.RSSI();
-        char wifiStr[12];
-        snprintf(wifiStr, sizeof(wifiStr), "WiFi %d", rssi);
-        u8g2.drawStr(0, 62, wifiStr);
-    } else {
-        u8g2.drawStr(0, 62, "No WiFi");
-    }
+        uint32_t drawTotal = 0, sendTotal = 0, drawMax = 0;
+        for (int i = 0; i < DISPLAY_BENCH_FRAMES; i++) {
+            esp_task_wdt_reset();
+            updateDisplay();
+            drawTotal += lastDisplayDrawUs;
+            sendTotal += lastDisplaySendUs;
+            if (lastDisplayDrawUs > drawMax) drawMax = lastDisplayDrawUs;
+        }
 
-    // IR status (if spamming)
-    if (irSpamming) {
-        u8g2.drawStr(50, 62, irSpamOn ? "IR:ON" : "IR:OFF");
+        Serial.print(glyphCacheEnabled ? "Glyph cache: " : "U8g2 font:   ");
+        Serial.print("draw avg ");
+        Serial.print(drawTotal / DISPLAY_BENCH_FRAMES);
+        Serial.print(" us (max ");
+        Serial.print(drawMax);
+        Serial.print(" us), sendBuffer avg ");
+        Serial.print(sendTotal / DISPLAY_BENCH_FRAMES);
+        Serial.println(" us");
     }
 
-    // Uptime
-    char uptimeStr[12];
-    unsigned long mins = millis() / 60000;
-    if (mins < 60) {
-        snprintf(uptimeStr, sizeof(uptimeStr), "%lum", mins);
-    } else {
-        snprintf(uptimeStr, sizeof(uptimeStr), "%luh%lum", mins / 60, mins % 60);
-    }
-    u8g2.drawStr(100, 62, uptimeStr);
+    Serial.println("=========================");
+    Serial.println();
+    glyphCacheEnabled = savedEnabled;
+    currentPage = savedPage;
+}
 
+// Every frame goes out through here, so it gets the burn-in shift and is
+// counted in the frames-per-hour stat
+void sendDisplayFrame() {
+    displayPowerBeforeSend(u8g2);
     u8g2.sendBuffer();
 }
 
 void displayMessage(const char* line1, const char* line2 = nullptr) {
     u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-
-    int y = line2 ? 25 : 35;
-    int w = u8g2.getStrWidth(line1);
-    u8g2.drawStr((128 - w) / 2, y, line1);
-
-    if (line2) {
-        w = u8g2.getStrWidth(line2);
-        u8g2.drawStr((128 - w) / 2, 45, line2);
-    }
-
-    u8g2.sendBuffer();
+    screenDrawMessage(u8g2, line1, line2);
+    sendDisplayFrame();
 }
 
 void displayConnecting(int attempt, int maxAttempts) {
     u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.drawStr(20, 25, "Connecting...");
-
-    // Progress bar
-    u8g2.drawFrame(14, 35, 100, 12);
-    int progress = (attempt * 100) / maxAttempts;
-    u8g2.drawBox(15, 36, progress, 10);
-
-    u8g2.setFont(u8g2_font_5x7_tr);
-    char buf[20];
-    snprintf(buf, sizeof(buf), "Attempt %d/%d", attempt, maxAttempts);
-    int w = u8g2.getStrWidth(buf);
-    u8g2.drawStr((128 - w) / 2, 58, buf);
-
-    u8g2.sendBuffer();
+    screenDrawConnecting(u8g2, attempt, maxAttempts);
+    sendDisplayFrame();
 }
 
 void displayWaitingCountdown(unsigned long remainingMs) {
     u8g2.clearBuffer();
-
-    // Title
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.drawStr(22, 18, "Waiting for");
-    u8g2.drawStr(18, 32, "first reading");
-
-    // Progress bar
-    unsigned long elapsed = MEASUREMENT_INTERVAL_MS - remainingMs;
-    int progress = (elapsed * 100) / MEASUREMENT_INTERVAL_MS;
-    u8g2.drawFrame(14, 42, 100, 8);
-    u8g2.drawBox(15, 43, (progress * 98) / 100, 6);
-
-    // Time remaining (M:SS format)
-    u8g2.setFont(u8g2_font_6x10_tr);
-    char buf[16];
-    unsigned long secs = remainingMs / 1000;
-    snprintf(buf, sizeof(buf), "%lu:%02lu left", secs / 60, secs % 60);
-    int w = u8g2.getStrWidth(buf);
-    u8g2.drawStr((128 - w) / 2, 58, buf);
-
-    u8g2.sendBuffer();
+    screenDrawWaiting(u8g2, remainingMs, MEASUREMENT_INTERVAL_MS);
+    sendDisplayFrame();
 }
 
 // ===========================================
@@ -345,7 +467,7 @@ void flashLED(int times, int duration = 100) {
 // Event logging
 // ===========================================
 
-bool sendEvent(EventType type, const char* message) {
+bool sendEvent(EventType type, const char* message, const char* category, const char* data) {
     if (WiFi.status() != WL_CONNECTED) {
         Serial.print("[Event not sent - no WiFi] ");
         Serial.println(message);
@@ -373,7 +495,14 @@ bool sendEvent(EventType type, const char* message) {
                      "\",\"uptime\":" + String(millis() / 1000) +
                      ",\"heap\":" + String(ESP.getFreeHeap()) +
                      ",\"total_measurements\":" + String(totalMeasurements) +
-                     ",\"i2c_errors\":" + String(totalI2CErrors) + "}";
+                     ",\"i2c_errors\":" + String(totalI2CErrors);
+    if (category) {
+        payload += ",\"category\":\"" + String(category) + "\"";
+    }
+    if (data) {
+        payload += ",\"data\":" + String(data);
+    }
+    payload += "}";
 
     int httpCode = http.POST(payload);
     http.end();
@@ -386,45 +515,189 @@ bool frcEventCallback(int type, const char* msg) {
     return sendEvent((EventType)type, msg);
 }
 
+// ===========================================
+// Remote calibration
+// ===========================================
+
+// Started from serial ("frc 450 600") or MQTT on FRC_TOPIC_PREFIX<device>/frc
+// with the same arguments ("<reference ppm> [warmup s]" or "cancel").
+// Progress and the result go to .../frc/status as JSON (retained).
+#define FRC_TOPIC_PREFIX "scd41/"
+#define FRC_REMOTE_PROGRESS_MS 15000
+
+char frcCommandTopic[48];
+char frcStatusTopic[56];
+unsigned long lastFrcProgress = 0;
+FRCState lastFrcState = FRC_IDLE;
+
+// Returns false (and says why) if the command wasn't accepted
+bool handleFrcCommand(const char* args, const char* origin) {
+    while (*args == ' ') args++;
+    if (strcasecmp(args, "cancel") == 0) {
+        bool ok = frcCancel();
+        Serial.println(ok ? "[FRC] Cancelling" : "[FRC] Nothing to cancel");
+        return ok;
+    }
+
+    unsigned int reference = 0;
+    unsigned long warmupS = 0;
+    if (sscanf(args, "%u %lu", &reference, &warmupS) < 1) {
+        Serial.println("[FRC] Usage: frc <reference ppm> [warmup s] / frc cancel");
+        return false;
+    }
+    if (!frcStart(reference, warmupS * 1000)) {
+        Serial.print("[FRC] Not started - busy, or outside ");
+        Serial.print(FRC_MIN_REFERENCE_PPM);
+        Serial.print("-");
+        Serial.print(FRC_MAX_REFERENCE_PPM);
+        Serial.print(" ppm / ");
+        Serial.print(FRC_MIN_WARMUP_MS / 1000);
+        Serial.print("-");
+        Serial.print(FRC_MAX_WARMUP_MS / 1000);
+        Serial.println(" s");
+        return false;
+    }
+    Serial.print("[FRC] Start requested (");
+    Serial.print(origin);
+    Serial.println(")");
+    return true;
+}
+
+void frcRemoteMessage(const char*, const char* payload) {
+    if (!handleFrcCommand(payload, "mqtt")) {
+        fanLinkPublish(frcStatusTopic, "{\"state\":\"rejected\"}", true);
+    }
+}
+
+void publishFrcProgress() {
+    unsigned long elapsedMs, totalMs;
+    int readings;
+    float avg;
+    frcProgress(elapsedMs, totalMs, readings, avg);
+
+    char json[160];
+    snprintf(json, sizeof(json),
+             "{\"state\":\"%s\",\"reference\":%u,\"elapsed_s\":%lu,\"total_s\":%lu,"
+             "\"readings\":%d,\"avg\":%.1f}",
+             frcStateName(), frcReference(), elapsedMs / 1000, totalMs / 1000, readings, avg);
+    fanLinkPublish(frcStatusTopic, json, true);
+}
+
+void publishFrcResult() {
+    const FRCResult& res = frcLastResult();
+    char json[192];
+    snprintf(json, sizeof(json),
+             "{\"state\":\"done\",\"result\":\"%s\",\"reference\":%u,\"correction\":%d,"
+             "\"avg\":%.1f,\"noise\":%.1f,\"readings\":%u,\"converged_s\":%lu}",
+             frcResultName(res.result), res.reference, res.correction, res.avgCO2,
+             res.noise, res.readings, (unsigned long)(res.convergedMs / 1000));
+    fanLinkPublish(frcStatusTopic, json, true);
+}
+
+// Progress on every state change and every FRC_REMOTE_PROGRESS_MS of warmup
+void frcRemotePoll(unsigned long now) {
+    FRCState state = frcState();
+    if (frcActive() && (state != lastFrcState || now - lastFrcProgress >= FRC_REMOTE_PROGRESS_MS)) {
+        publishFrcProgress();
+        lastFrcProgress = now;
+    }
+    lastFrcState = state;
+}
+
+// Wrapper for calibration history callback
+bool calHistoryEventCallback(int type, const char* msg, const char* category, const char* data) {
+    return sendEvent((EventType)type, msg, category, data);
+}
+
+// Wrapper for I2C recovery callback
+bool i2cRecoveryEventCallback(int type, const char* msg, const char* category, const char* data) {
+    return sendEvent((EventType)type, msg, category, data);
+}
+
+// Wrapper for ventilation control callback
+bool ventEventCallback(int type, const char* msg) {
+    return sendEvent((EventType)type, msg);
+}
+
 // FRC display callback - shows calibration progress on OLED
 void frcDisplayUpdate(unsigned long remainingMs, unsigned long totalMs,
                       int readingCount, uint16_t currentCO2, float avgCO2) {
+    // Keep the panel awake for the whole calibration
+    displayPowerWake(u8g2, "calibration");
     u8g2.clearBuffer();
+    screenDrawCalibrating(u8g2, remainingMs, totalMs, readingCount, currentCO2, avgCO2);
+    sendDisplayFrame();
+}
 
-    // Title
-    u8g2.setFont(u8g2_font_ncenB10_tr);
-    u8g2.drawStr(8, 14, "CALIBRATING...");
+// ===========================================
+// Framebuffer snapshots
+// ===========================================
 
-    // Current CO2 reading
-    u8g2.setFont(u8g2_font_6x10_tr);
-    char buf[24];
-    if (currentCO2 > 0) {
-        snprintf(buf, sizeof(buf), "CO2: %d ppm", currentCO2);
-    } else {
-        strcpy(buf, "CO2: ---");
-    }
-    u8g2.drawStr(20, 28, buf);
+// Render every screen state with fixed sample data and dump each one
+void runSnapshots() {
+    // Save state the screens read
+    uint16_t savedCO2 = displayCO2;
+    float savedTemp = displayTemp;
+    float savedHumidity = displayHumidity;
+    bool savedError = displayError;
+    bool savedWaiting = displayWaiting;
+    DisplayPage savedPage = currentPage;
 
-    // Average
-    if (readingCount > 0) {
-        snprintf(buf, sizeof(buf), "Avg: %d ppm", (int)avgCO2);
-    } else {
-        strcpy(buf, "Avg: ---");
-    }
-    u8g2.drawStr(20, 40, buf);
+    displayPowerWake(u8g2, "snapshot");
+    displayPowerSetShift(false);
+    currentPage = PAGE_READING;
 
-    // Progress bar
-    int progress = ((totalMs - remainingMs) * 100) / totalMs;
-    u8g2.drawFrame(14, 46, 100, 8);
-    u8g2.drawBox(15, 47, (progress * 98) / 100, 6);
+    unsigned long start;
 
-    // Time remaining (MM:SS format)
-    unsigned long secs = remainingMs / 1000;
-    snprintf(buf, sizeof(buf), "%lu:%02lu left", secs / 60, secs % 60);
-    int w = u8g2.getStrWidth(buf);
-    u8g2.drawStr((128 - w) / 2, 62, buf);
+    start = micros();
+    displayWaitingCountdown(MEASUREMENT_INTERVAL_MS / 2);
+    screenDumpPbm(u8g2, "waiting", micros() - start);
 
-    u8g2.sendBuffer();
+    displayWaiting = false;
+    displayError = true;
+    start = micros();
+    updateDisplay();
+    screenDumpPbm(u8g2, "error", micros() - start);
+
+    displayError = false;
+    displayCO2 = 850;
+    displayTemp = 22.5;
+    displayHumidity = 45.0;
+    start = micros();
+    updateDisplay();
+    screenDumpPbm(u8g2, "normal", micros() - start);
+
+    displayCO2 = 10000;
+    start = micros();
+    updateDisplay();
+    screenDumpPbm(u8g2, "normal-5digit", micros() - start);
+
+    start = micros();
+    frcDisplayUpdate(FRC_WARMUP_DURATION_MS / 2, FRC_WARMUP_DURATION_MS, 5, 452, 447.5);
+    screenDumpPbm(u8g2, "calibrating", micros() - start);
+
+    start = micros();
+    displayConnecting(12, WIFI_MAX_ATTEMPTS);
+    screenDumpPbm(u8g2, "connecting", micros() - start);
+
+    for (int page = PAGE_TREND; page < PAGE_COUNT; page++) {
+        currentPage = (DisplayPage)page;
+        start = micros();
+        updateDisplay();
+        char name[16];
+        snprintf(name, sizeof(name), "page%d", page + 1);
+        screenDumpPbm(u8g2, name, micros() - start);
+    }
+
+    // Restore
+    displayCO2 = savedCO2;
+    displayTemp = savedTemp;
+    displayHumidity = savedHumidity;
+    displayError = savedError;
+    displayWaiting = savedWaiting;
+    currentPage = savedPage;
+    displayPowerSetShift(true);
+    lastDisplayUpdate = 0;
 }
 
 // ===========================================
@@ -480,7 +753,8 @@ bool ensureWiFi() {
 // Sensor data upload
 // ===========================================
 
-bool sendReading(uint16_t co2, float temp, float humidity) {
+// tag marks readings taken outside normal operation (e.g. "frc_warmup")
+bool sendReading(uint16_t co2, float temp, float humidity, const char* tag = nullptr) {
     if (!ensureWiFi()) {
         return false;
     }
@@ -497,7 +771,50 @@ bool sendReading(uint16_t co2, float temp, float humidity) {
                      ",\"humidity\":" + String(humidity, 1) +
                      ",\"rssi\":" + String(WiFi.RSSI()) +
                      ",\"uptime\":" + String(millis() / 1000) +
-                     ",\"heap\":" + String(ESP.getFreeHeap()) + "}";
+                     ",\"heap\":" + String(ESP.getFreeHeap());
+    if (tag) {
+        payload += ",\"tag\":\"" + String(tag) + "\"";
+    }
+    payload += "}";
+
+    Serial.print("POST ");
+    Serial.print(url);
+    Serial.print(" -> ");
+
+    int httpCode = http.POST(payload);
+    http.end();
+
+    if (httpCode == 200) {
+        Serial.println("OK");
+        return true;
+    } else {
+        Serial.print("Failed (");
+        Serial.print(httpCode);
+        Serial.println(")");
+        return false;
+    }
+}
+
+// Every mux channel in one request - see scd4x_mux.h
+bool sendBatchReading() {
+    if (!ensureWiFi()) {
+        return false;
+    }
+
+    char readings[768];
+    muxReadingsJson(deviceName, readings, sizeof(readings));
+
+    HTTPClient http;
+    String url = String(apiEndpoint) + "/api/sensor/batch";
+    http.begin(url);
+    http.addHeader("Content-Type", "application/json");
+    http.setTimeout(10000);
+
+    String payload = "{\"device\":\"" + String(deviceName) +
+                     "\",\"rssi\":" + String(WiFi.RSSI()) +
+                     ",\"uptime\":" + String(millis() / 1000) +
+                     ",\"heap\":" + String(ESP.getFreeHeap()) +
+                     ",\"readings\":" + String(readings) + "}";
 
     Serial.print("POST ");
     Serial.print(url);
@@ -517,78 +834,404 @@ bool sendReading(uint16_t co2, float temp, float humidity) {
     }
 }
 
+// The measurement period's upload: the primary alone, or with a mux all
+// sensors in one batch. A failed primary (ok = false) still uploads the
+// other channels, so only does anything with a mux.
+bool uploadReading(bool ok, uint16_t co2, float temp, float humidity, int16_t error = 0) {
+#if MUX_ENABLED
+    muxSetPrimary(ok, co2, temp, humidity, error);
+    return sendBatchReading();
+#else
+    (void)error;    // Only the mux batch reports it
+    return ok && sendReading(co2, temp, humidity);
+#endif
+}
+
 // ===========================================
-// I2C recovery
+// Sensor configuration
 // ===========================================
 
-bool recoverI2C() {
-    Serial.println("Attempting I2C recovery...");
-    displayMessage("I2C Error", "Recovering...");
+// Settings the sensor keeps in RAM only - applied at boot and again by
+// the recovery ladder after a reinit or power cycle. Sensor must be idle.
+int16_t configureScd41(SensirionI2cScd4x &scd) {
+    int16_t error;
+    int16_t lastError = 0;
+    uint32_t t;
 
-    // End I2C
-    Wire.end();
-    delay(100);
+    // Set altitude for pressure compensation
+    t = micros();
+    error = scd.setSensorAltitude(SENSOR_ALTITUDE_METERS);
+    i2cRecord(SCD4X_SET_SENSOR_ALTITUDE, micros() - t, error);
+    if (error != 0) {
+        Serial.print("setSensorAltitude error: ");
+        Serial.println(error);
+        lastError = error;
+    } else {
+        Serial.print("Altitude set: ");
+        Serial.print(SENSOR_ALTITUDE_METERS);
+        Serial.println(" m");
+    }
 
-    // Manually clock out any stuck transaction
-    pinMode(I2C_SDA, OUTPUT);
-    pinMode(I2C_SCL, OUTPUT);
+    // Set temperature offset
+    t = micros();
+    error = scd.setTemperatureOffset(TEMPERATURE_OFFSET_C);
+    i2cRecord(SCD4X_SET_TEMPERATURE_OFFSET, micros() - t, error);
+    if (error != 0) {
+        Serial.print("setTemperatureOffset error: ");
+        Serial.println(error);
+        lastError = error;
+    } else {
+        Serial.print("Temperature offset set: ");
+        Serial.print(TEMPERATURE_OFFSET_C, 1);
+        Serial.println(" C");
+    }
 
-    // 9 clock pulses to release stuck slave
-    digitalWrite(I2C_SDA, HIGH);
-    for (int i = 0; i < 9; i++) {
-        digitalWrite(I2C_SCL, HIGH);
-        delayMicroseconds(5);
-        digitalWrite(I2C_SCL, LOW);
-        delayMicroseconds(5);
+    // Disable ASC - relying on manual FRC calibration
+    t = micros();
+    error = scd.setAutomaticSelfCalibrationEnabled(false);
+    i2cRecord(SCD4X_SET_ASC_ENABLED, micros() - t, error);
+    if (error != 0) {
+        Serial.print("setAutomaticSelfCalibrationEnabled error: ");
+        Serial.println(error);
+        lastError = error;
+    } else {
+        Serial.println("ASC disabled (using manual FRC calibration)");
     }
+    return lastError;
+}
 
-    // Generate STOP condition
-    digitalWrite(I2C_SDA, LOW);
-    delayMicroseconds(5);
-    digitalWrite(I2C_SCL, HIGH);
-    delayMicroseconds(5);
-    digitalWrite(I2C_SDA, HIGH);
+// The primary sensor (recovery ladder callback)
+int16_t configureSensor() {
+    return configureScd41(sensor);
+}
 
-    delay(100);
+// ===========================================
+// State kept across a recovery reboot
+// ===========================================
 
-    // Reinitialize
-    Wire.begin(I2C_SDA, I2C_SCL);
-    sensor.begin(Wire, SCD41_I2C_ADDR_62);
-    delay(50);
+#define BOOT_STATE_MAGIC 0x53544154     // "STAT"
 
-    // Verify sensor responds
-    uint64_t serialNumber = 0;
-    int16_t error = sensor.getSerialNumber(serialNumber);
+struct BootState {
+    uint32_t magic;
+    uint32_t totalMeasurements;
+    uint32_t successfulUploads;
+    uint32_t totalI2CErrors;
+    uint32_t totalWiFiReconnects;
+};
 
-    if (error == 0) {
-        Serial.println("I2C recovery successful");
-        displayMessage("I2C Recovered!");
-        delay(1000);
+static RTC_NOINIT_ATTR BootState bootState;
+
+// Called by the recovery ladder right before ESP.restart()
+void saveBootState() {
+    bootState.magic = BOOT_STATE_MAGIC;
+    bootState.totalMeasurements = totalMeasurements;
+    bootState.successfulUploads = successfulUploads;
+    bootState.totalI2CErrors = totalI2CErrors;
+    bootState.totalWiFiReconnects = totalWiFiReconnects;
+}
 
-        // Restart periodic measurement
-        sensor.stopPeriodicMeasurement();
-        delay(500);
-        sensor.startPeriodicMeasurement();
+void restoreBootState() {
+    if (bootState.magic != BOOT_STATE_MAGIC) return;
+    bootState.magic = 0;
+    totalMeasurements = bootState.totalMeasurements;
+    successfulUploads = bootState.successfulUploads;
+    totalI2CErrors = bootState.totalI2CErrors;
+    totalWiFiReconnects = bootState.totalWiFiReconnects;
+    Serial.println("Stats restored after recovery reboot");
+}
 
-        return true;
+// ===========================================
+// Fast sampling for AC confirmation
+// ===========================================
+
+void sampleForConfirmation(unsigned long now) {
+    if (!acConfirmActive() || now - lastFastSampleTime < AC_CONFIRM_SAMPLE_MS) {
+        return;
     }
 
-    Serial.println("I2C recovery failed");
-    displayMessage("I2C Failed!", "Check wiring");
-    delay(2000);
-    return false;
+    bool dataReady = false;
+    uint32_t t = micros();
+    int16_t error = sensor.getDataReadyStatus(dataReady);
+    i2cRecord(SCD4X_GET_DATA_READY, micros() - t, error);
+    if (error != 0) {
+        totalI2CErrors++;
+        lastFastSampleTime = now;
+        i2cRecoveryStart();
+        return;
+    }
+    if (!dataReady) {
+        // Not our phase yet - look again shortly instead of a whole period later
+        lastFastSampleTime = now - AC_CONFIRM_SAMPLE_MS + 500;
+        return;
+    }
+
+    lastFastSampleTime = now;
+    uint16_t co2 = 0;
+    float temp = 0.0;
+    float humidity = 0.0;
+    t = micros();
+    error = sensor.readMeasurement(co2, temp, humidity);
+    i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
+    if (error != 0) {
+        totalI2CErrors++;
+        i2cRecoveryStart();
+        return;
+    }
+
+    fastCO2 = co2;
+    fastTemp = temp;
+    fastHumidity = humidity;
+    fastSampleTime = now;
+    acConfirmSample(co2, temp, humidity);
 }
 
 // ===========================================
 // IR Control
 // ===========================================
 
-void sendIROn() {
-    irsend.sendRaw(AC_ON_RAW, AC_ON_RAW_LEN, 38);
+// Frame finished transmitting (called from irRmtPoll() with the RMT backend)
+void onIrSendComplete(uint32_t durationUs) {
+    irFramesSent++;
+    lastIrSendTime = millis();
+    lastIrFrameUs = durationUs;
+    irSchedOnComplete(durationUs);
+}
+
+// Synthesize the command's timings and transmit it
+// Returns false if the previous frame is still being transmitted
+bool sendIRCommand(const WhynterCommand &cmd) {
+#if IR_USE_RMT
+    // irItems is owned by the RMT driver until the current frame is out
+    if (irRmtBusy()) {
+        irSendsSkippedBusy++;
+        return false;
+    }
+    size_t rawLen = whynterEncodeRaw(cmd, irRawBuffer, WHYNTER_MAX_RAW_LEN);
+    size_t count = irRmtEncodeRaw(irRawBuffer, rawLen, irItems,
+                                  sizeof(irItems) / sizeof(irItems[0]));
+    if (count == 0 || !irRmtSendAsync(irItems, count, onIrSendComplete)) {
+        irSendsSkippedBusy++;
+        return false;
+    }
+#else
+    size_t rawLen = whynterEncodeRaw(cmd, irRawBuffer, WHYNTER_MAX_RAW_LEN);
+    unsigned long start = micros();
+    irsend.sendRaw(irRawBuffer, rawLen, WHYNTER_FREQ_KHZ);
+    onIrSendComplete(micros() - start);
+#endif
+    return true;
+}
+
+// Send any signal from the generated table (see the "send" command)
+bool sendIRSignal(const IrSignal* signal) {
+    if (signal->kind == IR_SIGNAL_WHYNTER) {
+        if (!sendIRCommand(*signal->whynter)) return false;
+        acStateObserve(signal);
+        return true;
+    }
+    if (signal->kind != IR_SIGNAL_RAW) {
+        Serial.print("[IR] Parsed signals not supported: ");
+        Serial.println(signal->protocol);
+        return false;
+    }
+
+#if IR_USE_RMT
+    if (irRmtBusy()) {
+        irSendsSkippedBusy++;
+        return false;
+    }
+    size_t count = irRmtEncodeRaw(signal->raw, signal->rawLength, irItems,
+                                  sizeof(irItems) / sizeof(irItems[0]));
+    if (count == 0 || !irRmtSendAsync(irItems, count, onIrSendComplete)) {
+        irSendsSkippedBusy++;
+        return false;
+    }
+#else
+    unsigned long start = micros();
+    irsend.sendRaw(signal->raw, signal->rawLength, signal->frequency / 1000);
+    onIrSendComplete(micros() - start);
+#endif
+    return true;
+}
+
+void initIR() {
+#if IR_USE_RMT
+    irRmtInit(IR_LED_PIN);
+#else
+    irsend.begin();
+#endif
+    irSignalOn = whynterFindSignal("Ac_On");
+    irSignalOff = whynterFindSignal("Ac_Off");
+    irSchedInit(sendIRSignal);
+    acStateInit();
+    irLearnInit(IR_RX_PIN);
+    irMacroInit(runMacroStep);
+}
+
+// Ventilation actuator - fan mode to ventilate, off otherwise. Retries
+// force the command out even though the AC model thinks it's already there.
+const char* VENT_ON_TARGET = "fan";
+const char* VENT_OFF_TARGET = "off";
+
+bool ventActuate(bool on, bool retry) {
+    if (!retry) {
+        fanLinkStart(on);
+        // Into fan mode or out of it - only CO2 responds either way
+        acConfirmStart(on, true);
+    }
+    return acStateApply(on ? VENT_ON_TARGET : VENT_OFF_TARGET, IR_PRIO_AUTO, retry);
+}
+
+// "stop" / double press - end spam and any confirmation in progress
+void stopSpam() {
+    irSpamming = false;
+    irSchedCancel(IR_PRIO_SPAM);
+    fanLinkEnd();
+    acConfirmCancel();
+    Serial.println("[IR] Spam stopped");
+}
+
+void stopSpamFor(bool on, const char* why) {
+    if (irSpamming && irSpamOn == on) {
+        irSpamming = false;
+        irSchedCancel(IR_PRIO_SPAM);
+        Serial.print("[IR] Spam stopped, ");
+        Serial.println(why);
+    }
+}
+
+// Fan link activation ended - the fan node confirmed the state, or it timed out
+void fanLinkEnded(bool on, bool confirmed) {
+    if (confirmed) {
+        acConfirmCancel();
+        stopSpamFor(on, "fan node confirmed");
+        ventControlConfirm(on);
+    } else if (!acConfirmActive()) {
+        stopSpamFor(on, "no confirmation");
+    }
+    // Otherwise the readings still get their chance
+}
+
+// Sensor confirmation window ended - the room responded, or it timed out
+void acConfirmEnded(bool on, bool confirmed) {
+    if (confirmed) {
+        fanLinkEnd();
+        stopSpamFor(on, "readings confirmed");
+        ventControlConfirm(on);
+    } else {
+        stopSpamFor(on, "no confirmation");
+        char msg[80];
+        snprintf(msg, sizeof(msg), "AC %s not confirmed by readings after %lus",
+                 on ? "ON" : "OFF", AC_CONFIRM_TIMEOUT_MS / 1000);
+        sendEvent(EVENT_WARNING, msg);
+    }
+}
+
+// One macro/schedule step: "ac <target>" or a signal name
+bool runMacroStep(const char* step) {
+    if (strncasecmp(step, "ac ", 3) == 0) {
+        return acStateApply(step + 3, IR_PRIO_AUTO);
+    }
+    const IrSignal* signal = irLearnFind(step);
+    if (!signal) signal = whynterFindSignal(step);
+    if (!signal) {
+        Serial.print("[Macro] Unknown signal: ");
+        Serial.println(step);
+        return false;
+    }
+    return queueIR(signal, IR_PRIO_AUTO);
+}
+
+// Queue a signal for the scheduler and report what happened
+bool queueIR(const IrSignal* signal, IRPriority priority) {
+    IREnqueueResult result = irSchedEnqueue(signal, priority);
+    if (priority == IR_PRIO_SPAM) {
+        // Spam re-queues every interval; only log new entries
+        if (result == IR_QUEUED) {
+            Serial.print("[IR] ");
+            Serial.print(signal->name);
+            Serial.println(" queued (spam)");
+        }
+        return result != IR_REJECTED;
+    }
+
+    Serial.print("[IR] ");
+    Serial.print(signal ? signal->name : "?");
+    switch (result) {
+        case IR_QUEUED:    Serial.println(" queued"); break;
+        case IR_COALESCED: Serial.println(" already pending"); break;
+        default:           Serial.println(" rejected, queue full"); break;
+    }
+    return result != IR_REJECTED;
+}
+
+// ===========================================
+// Loop latency
+// ===========================================
+
+void recordLoopLatency() {
+    unsigned long nowUs = micros();
+    if (lastLoopStartUs != 0) {
+        uint32_t period = nowUs - lastLoopStartUs;
+        loopPasses++;
+        loopTotalUs += period;
+        if (period > loopMaxUs) loopMaxUs = period;
+        if (period > LOOP_STALL_THRESHOLD_US) loopStalls++;
+    }
+    lastLoopStartUs = nowUs;
 }
 
-void sendIROff() {
-    irsend.sendRaw(AC_OFF_RAW, AC_OFF_RAW_LEN, 38);
+void printLoopLatency(bool reset) {
+    Serial.print("Loop: avg ");
+    Serial.print(loopPasses > 0 ? (uint32_t)(loopTotalUs / loopPasses) : 0);
+    Serial.print(" us, max ");
+    Serial.print(loopMaxUs);
+    Serial.print(" us, ");
+    Serial.print(loopStalls);
+    Serial.print(" stalls > ");
+    Serial.print(LOOP_STALL_THRESHOLD_US / 1000);
+    Serial.print(" ms over ");
+    Serial.print(loopPasses);
+    Serial.print(" passes (IR backend: ");
+    Serial.print(IR_USE_RMT ? "RMT" : "IRsend");
+    Serial.print(", spam ");
+    Serial.print(irSpamming ? "on" : "off");
+    Serial.println(")");
+
+    if (reset) {
+        loopPasses = 0;
+        loopTotalUs = 0;
+        loopMaxUs = 0;
+        loopStalls = 0;
+    }
+}
+
+// ===========================================
+// BOOT button
+// ===========================================
+
+void handleButtonEvent(ButtonEvent event) {
+    switch (event) {
+    case BUTTON_SHORT:
+        // Wakes a dimmed/blank panel, otherwise next page
+        if (!displayPowerWake(u8g2, "button")) {
+            nextDisplayPage();
+        }
+        lastDisplayUpdate = 0;
+        break;
+    case BUTTON_DOUBLE:
+        stopSpam();
+        break;
+    case BUTTON_LONG:
+        if (frcStartButton()) {
+            Serial.println("[FRC] Button held - starting calibration");
+        } else {
+            Serial.println("[FRC] Button held - calibration already running");
+        }
+        break;
+    default:
+        break;
+    }
 }
 
 void printHelp() {
@@ -600,6 +1243,29 @@ void printHelp() {
     Serial.println("  spamon  - Start spamming ON signal");
     Serial.println("  spamoff - Start spamming OFF signal");
     Serial.println("  stop    - Stop spamming");
+    Serial.println("  send X  - Send a named signal (e.g. send fan_high)");
+    Serial.println("  codes   - List the named signals");
+    Serial.println("  ac X    - Set AC state (e.g. ac cool, fan high / ac off / ac swing on)");
+    Serial.println("  ac      - Print the assumed AC state");
+    Serial.println("  learn X - Capture a remote button as X (learn alone cancels)");
+    Serial.println("  learned - List learned signals");
+    Serial.println("  forget X - Delete a learned signal");
+    Serial.println("  frc PPM [S] - Calibrate against PPM (optional warmup S seconds) / frc cancel");
+    Serial.println("  frc     - Calibration state");
+    Serial.println("  cal     - Calibration history and drift estimate");
+    Serial.println("  i2c     - I2C latency and error counters (i2c reset)");
+    Serial.println("  vent    - Ventilation control stats (vent on / vent off)");
+    Serial.println("  fan     - Fan confirmation stats (MQTT fan node, sensor inference)");
+    Serial.println("  macro   - List macros");
+    Serial.println("  macro add NAME s1; s2 - Define a macro (steps: ac X / signal / wait MS)");
+    Serial.println("  macro del NAME / macro stop");
+    Serial.println("  run X   - Run macro X");
+    Serial.println("  sched   - List schedules");
+    Serial.println("  sched add HH:MM [weekdays|weekends] X - Run macro or step X daily");
+    Serial.println("  sched del N - Delete schedule N");
+    Serial.println("  bench   - Time display rendering with/without glyph cache");
+    Serial.println("  snap    - Dump every screen state as PBM snapshots");
+    Serial.println("  latency - Print loop latency stats and reset them");
     Serial.println("  help    - Print this message");
     Serial.println("=======================");
     Serial.println();
@@ -619,13 +1285,19 @@ void handleSerialCommands() {
     }
 
     if (cmd == "on") {
-        sendIROn();
-        Serial.println("[IR] AC ON signal sent");
+        queueIR(irSignalOn, IR_PRIO_MANUAL);
     } else if (cmd == "off") {
-        sendIROff();
-        Serial.println("[IR] AC OFF signal sent");
+        queueIR(irSignalOff, IR_PRIO_MANUAL);
     } else if (cmd == "spam") {
         irSpamming = !irSpamming;
+        irSchedCancel(IR_PRIO_SPAM);
+        if (irSpamming) {
+            fanLinkStart(irSpamOn);
+            acConfirmStart(irSpamOn);
+        } else {
+            fanLinkEnd();
+            acConfirmCancel();
+        }
         Serial.print("[IR] Spam mode: ");
         Serial.print(irSpamming ? "ON" : "OFF");
         if (irSpamming) {
@@ -638,16 +1310,172 @@ void handleSerialCommands() {
     } else if (cmd == "spamon") {
         irSpamming = true;
         irSpamOn = true;
+        irSchedCancel(IR_PRIO_SPAM);
+        fanLinkStart(true);
+        acConfirmStart(true);
         lastIrSpam = millis();
         Serial.println("[IR] Spamming AC ON signal");
     } else if (cmd == "spamoff") {
         irSpamming = true;
         irSpamOn = false;
+        irSchedCancel(IR_PRIO_SPAM);
+        fanLinkStart(false);
+        acConfirmStart(false);
         lastIrSpam = millis();
         Serial.println("[IR] Spamming AC OFF signal");
     } else if (cmd == "stop") {
-        irSpamming = false;
-        Serial.println("[IR] Spam stopped");
+        stopSpam();
+    } else if (cmd.startsWith("send ")) {
+        String name = cmd.substring(5);
+        name.trim();
+        // Learned signals first, so a re-learned capture replaces Whynter.ir
+        const IrSignal* signal = irLearnFind(name.c_str());
+        if (!signal) signal = whynterFindSignal(name.c_str());
+        if (!signal) {
+            Serial.print("[IR] Unknown signal: ");
+            Serial.println(name);
+        } else {
+            queueIR(signal, IR_PRIO_MANUAL);
+        }
+    } else if (cmd == "ac") {
+        char state[32];
+        acStateDescribe(state, sizeof(state));
+        Serial.print("[AC] Assumed state: ");
+        Serial.println(state);
+    } else if (cmd.startsWith("ac ")) {
+        acStateApply(cmd.substring(3).c_str(), IR_PRIO_MANUAL);
+    } else if (cmd == "learn") {
+        irLearnCancel();
+    } else if (cmd.startsWith("learn ")) {
+        String name = cmd.substring(6);
+        name.trim();
+        // The LED sits next to the receiver - don't capture our own spam
+        if (irSpamming) {
+            irSpamming = false;
+            irSchedCancel(IR_PRIO_SPAM);
+            fanLinkEnd();
+            acConfirmCancel();
+            Serial.println("[IR] Spam stopped for learning");
+        }
+        irLearnStart(name.c_str());
+    } else if (cmd == "learned") {
+        irLearnList();
+    } else if (cmd.startsWith("forget ")) {
+        String name = cmd.substring(7);
+        name.trim();
+        Serial.println(irLearnForget(name.c_str()) ? "[Learn] Forgotten" : "[Learn] No such signal");
+    } else if (cmd == "frc") {
+        Serial.print("[FRC] State: ");
+        Serial.print(frcStateName());
+        Serial.print(", reference ");
+        Serial.print(frcReference());
+        Serial.print(" ppm, last result ");
+        Serial.println(frcResultName(frcLastResult().result));
+    } else if (cmd.startsWith("frc ")) {
+        handleFrcCommand(cmd.c_str() + 4, "serial");
+    } else if (cmd == "cal") {
+        calHistoryPrint();
+        calHistoryPrintStats();
+    } else if (cmd == "i2c") {
+        i2cTelemetryPrint();
+        i2cRecoveryPrintStats();
+#if MUX_ENABLED
+    } else if (cmd == "mux") {
+        muxPrintStats();
+#endif
+    } else if (cmd == "i2c reset") {
+        i2cTelemetryReset();
+        Serial.println("[I2C] Telemetry cleared");
+    } else if (cmd == "vent") {
+        ventControlPrintStats();
+    } else if (cmd == "vent on") {
+        ventControlSetEnabled(true);
+    } else if (cmd == "vent off") {
+        ventControlSetEnabled(false);
+    } else if (cmd == "fan") {
+        fanLinkPrintStats();
+        acConfirmPrintStats();
+    } else if (cmd == "macro") {
+        irMacroList();
+        irMacroPrintStats();
+    } else if (cmd == "macro stop") {
+        irMacroStop();
+    } else if (cmd.startsWith("macro add ")) {
+        String rest = cmd.substring(10);
+        rest.trim();
+        int space = rest.indexOf(' ');
+        if (space < 0) {
+            Serial.println("[Macro] Usage: macro add NAME step; step; ...");
+        } else {
+            String name = rest.substring(0, space);
+            String steps = rest.substring(space + 1);
+            steps.trim();
+            if (irMacroDefine(name.c_str(), steps.c_str())) {
+                Serial.print("[Macro] Saved ");
+                Serial.println(name);
+            }
+        }
+    } else if (cmd.startsWith("macro del ")) {
+        String name = cmd.substring(10);
+        name.trim();
+        Serial.println(irMacroDelete(name.c_str()) ? "[Macro] Deleted" : "[Macro] No such macro (or running)");
+    } else if (cmd.startsWith("run ")) {
+        String name = cmd.substring(4);
+        name.trim();
+        irMacroRun(name.c_str());
+    } else if (cmd == "sched") {
+        irScheduleList();
+    } else if (cmd.startsWith("sched add ")) {
+        String rest = cmd.substring(10);
+        rest.trim();
+        int hour = -1, minute = -1, used = 0;
+        sscanf(rest.c_str(), "%d:%d%n", &hour, &minute, &used);
+        String action = used > 0 ? rest.substring(used) : String();
+        action.trim();
+
+        uint8_t days = IR_DAYS_ALL;
+        if (action.startsWith("weekdays ")) {
+            days = IR_DAYS_WEEKDAYS;
+            action = action.substring(9);
+        } else if (action.startsWith("weekends ")) {
+            days = IR_DAYS_WEEKENDS;
+            action = action.substring(9);
+        } else if (action.startsWith("daily ")) {
+            action = action.substring(6);
+        }
+        action.trim();
+
+        int slot = (hour >= 0 && minute >= 0) ? irScheduleAdd(hour, minute, days, action.c_str()) : -1;
+        if (slot >= 0) {
+            Serial.print("[Sched] Added #");
+            Serial.println(slot);
+        } else {
+            Serial.println("[Sched] Usage: sched add HH:MM [weekdays|weekends] action (max 8)");
+        }
+    } else if (cmd.startsWith("sched del ")) {
+        // Whole argument must be a number - toInt() would read "foo" as 0
+        String arg = cmd.substring(10);
+        arg.trim();
+        char* end = nullptr;
+        long slot = strtol(arg.c_str(), &end, 10);
+        if (arg.length() == 0 || *end != '\0') {
+            Serial.println("[Sched] Usage: sched del N");
+        } else {
+            Serial.println(irScheduleDelete(slot) ? "[Sched] Deleted" : "[Sched] No such schedule");
+        }
+    } else if (cmd == "codes") {
+        Serial.print("[IR] Signals: ");
+        for (size_t i = 0; i < WHYNTER_SIGNAL_COUNT; i++) {
+            if (i > 0) Serial.print(", ");
+            Serial.print(WHYNTER_SIGNALS[i].name);
+        }
+        Serial.println();
+    } else if (cmd == "bench") {
+        runDisplayBenchmark();
+    } else if (cmd == "snap") {
+        runSnapshots();
+    } else if (cmd == "latency") {
+        printLoopLatency(true);
     } else if (cmd == "help") {
         printHelp();
     } else {
@@ -675,13 +1503,34 @@ void printDiagnostics() {
         Serial.print("0.0");
     }
     Serial.println("%)");
+    Serial.print("FRC warmup uploads: ");
+    Serial.println(warmupUploads);
     Serial.print("I2C errors: ");
     Serial.println(totalI2CErrors);
+    i2cTelemetryPrintStats();
+    i2cRecoveryPrintStats();
+#if MUX_ENABLED
+    muxPrintStats();
+#endif
     Serial.print("WiFi reconnects: ");
     Serial.println(totalWiFiReconnects);
     Serial.print("Free heap: ");
     Serial.print(ESP.getFreeHeap());
     Serial.println(" bytes");
+    Serial.print("Display: draw ");
+    Serial.print(lastDisplayDrawUs);
+    Serial.print(" us, send ");
+    Serial.print(lastDisplaySendUs);
+    Serial.print(" us (glyph cache ");
+    Serial.print(glyphCacheReady() && glyphCacheEnabled ? "on" : "off");
+    Serial.println(")");
+    Serial.print("Panel: ");
+    Serial.print(displayPowerStateName());
+    Serial.print(", on ");
+    Serial.print(displayPowerPanelOnMs() / 1000);
+    Serial.print(" s, ");
+    Serial.print(displayPowerFramesPerHour());
+    Serial.println(" frames/hour");
     Serial.print("Uptime: ");
     Serial.print(millis() / 1000);
     Serial.println(" seconds");
@@ -693,6 +1542,44 @@ void printDiagnostics() {
     } else {
         Serial.println("OFF");
     }
+    Serial.print("IR frames: ");
+    Serial.print(irFramesSent);
+    Serial.print(" sent, last ");
+    Serial.print(lastIrFrameUs / 1000);
+    Serial.print(" ms, ");
+    Serial.print(irSendsSkippedBusy);
+    Serial.println(" skipped (busy)");
+    Serial.print("IR queue: ");
+    Serial.print(irSchedQueueDepth());
+    Serial.print(" pending, ");
+    Serial.print(irSchedSendsPerMinute());
+    Serial.print(" sent/min, wait avg ");
+    Serial.print(irSchedAvgWaitMs());
+    Serial.print(" ms max ");
+    Serial.print(irSchedMaxWaitMs());
+    Serial.print(" ms, ");
+    Serial.print(irSchedCoalesced());
+    Serial.print(" coalesced, ");
+    Serial.print(irSchedDropped());
+    Serial.print(" dropped, ");
+    Serial.print(irSchedGaveUp());
+    Serial.println(" gave up");
+    char acState[32];
+    acStateDescribe(acState, sizeof(acState));
+    Serial.print("AC state: ");
+    Serial.print(acState);
+    Serial.print(" (assumed), ");
+    Serial.print(acStateCommandsSent());
+    Serial.print(" commands sent, ");
+    Serial.print(acStateCommandsSkipped());
+    Serial.println(" redundant requests skipped");
+    ventControlPrintStats();
+    fanLinkPrintStats();
+    acConfirmPrintStats();
+    irMacroPrintStats();
+    calHistoryPrintStats();
+    buttonPrintStats();
+    printLoopLatency(false);
     Serial.println("===================");
     Serial.println();
 }
@@ -724,6 +1611,8 @@ void setup() {
     // Initialize OLED first for visual feedback
     Serial.println("Initializing OLED...");
     u8g2.begin();
+    glyphCacheInit(u8g2, u8g2_font_logisoso28_tn, SCREEN_CO2_BASELINE_Y);
+    displayPowerInit(u8g2);
     displayMessage("CO2 Monitor v3", "Starting...");
     delay(500);
 
@@ -738,54 +1627,51 @@ void setup() {
     Serial.println("========================================");
     Serial.println();
     Serial.println("IR commands: on, off, spamon, spamoff, stop, help");
+    Serial.println("Display benchmark: bench");
+    Serial.println("Short-press BOOT to change display page");
     Serial.println("Hold BOOT button 3 seconds to calibrate");
     Serial.println();
 
     // Initialize IR
-    irsend.begin();
+    initIR();
+
+    // Start I2C and stop any running measurement before WiFi - the sensor
+    // then sits out its 500 ms stop time while we connect
+    Wire.begin(I2C_SDA, I2C_SCL);
+    sensor.begin(Wire, SCD41_I2C_ADDR_62);
+    scd4xAsyncBegin(Wire, SCD41_I2C_ADDR_62, i2cRecord);
+#if MUX_ENABLED
+    // Stops the other channels too, leaving the primary's selected
+    muxBegin(Wire, SCD41_I2C_ADDR_62);
+#endif
+    Scd4xFuture stopCmd;
+    scd4xIssue(SCD4X_STOP_PERIODIC, stopCmd);
 
     // Connect WiFi
     displayMessage("Connecting WiFi...");
     connectWiFi();
 
-    // Initialize I2C and sensor
-    displayMessage("Init sensor...");
-    Wire.begin(I2C_SDA, I2C_SCL);
-    sensor.begin(Wire, SCD41_I2C_ADDR_62);
-    delay(30);
-
-    // Stop any running measurement
-    sensor.stopPeriodicMeasurement();
-    delay(500);
+    // Wall-clock time for display quiet hours (syncs in the background)
+    configTzTime(TIMEZONE, NTP_SERVER);
 
-    // Configure sensor
+    // Configure sensor (only waits if WiFi connected in under 500 ms)
+    displayMessage("Init sensor...");
+    scd4xAwait(stopCmd);
     int16_t error;
+    uint32_t t;
 
-    // Set altitude for pressure compensation
-    error = sensor.setSensorAltitude(SENSOR_ALTITUDE_METERS);
-    if (error != 0) {
-        Serial.print("setSensorAltitude error: ");
-        Serial.println(error);
-    } else {
-        Serial.print("Altitude set: ");
-        Serial.print(SENSOR_ALTITUDE_METERS);
-        Serial.println(" m");
-    }
+    // Recovery ladder for failed reads; reports why if it rebooted us
+    i2cRecoveryInit(I2C_SDA, I2C_SCL, configureSensor, i2cRecoveryEventCallback, saveBootState);
+    if (i2cRecoveryRebooted()) restoreBootState();
 
-    // Set temperature offset
-    error = sensor.setTemperatureOffset(TEMPERATURE_OFFSET_C);
-    if (error != 0) {
-        Serial.print("setTemperatureOffset error: ");
-        Serial.println(error);
-    } else {
-        Serial.print("Temperature offset set: ");
-        Serial.print(TEMPERATURE_OFFSET_C, 1);
-        Serial.println(" C");
-    }
+    // Settings are only accepted while idle, so before the start
+    configureSensor();
 
     // Verify sensor and get serial number
     uint64_t serialNumber = 0;
+    t = micros();
     error = sensor.getSerialNumber(serialNumber);
+    i2cRecord(SCD4X_GET_SERIAL_NUMBER, micros() - t, error);
     if (error != 0) {
         Serial.println("ERROR: SCD41 not found! Check wiring.");
         displayMessage("Sensor Error!", "Check wiring");
@@ -809,7 +1695,9 @@ void setup() {
     }
 
     // Start periodic measurement mode
+    t = micros();
     error = sensor.startPeriodicMeasurement();
+    i2cRecord(SCD4X_START_PERIODIC, micros() - t, error);
     if (error != 0) {
         Serial.print("startPeriodicMeasurement error: ");
         Serial.println(error);
@@ -818,13 +1706,34 @@ void setup() {
         Serial.println("Periodic measurement started");
     }
 
-    // Disable ASC - relying on manual FRC calibration
-    sensor.setAutomaticSelfCalibrationEnabled(false);
-    Serial.println("ASC disabled (using manual FRC calibration)");
+#if MUX_ENABLED
+    // Their stops ran out alongside the primary's
+    muxStartOthers(configureScd41);
+#endif
 
     // Initialize FRC module
     frcInit();
 
+    // BOOT button: short = page, double = stop spam, hold = calibrate
+    buttonInit(FRC_BUTTON_PIN, FRC_HOLD_TIME_MS, BUTTON_DOUBLE_MS);
+
+    // Calibration results and baseline drift, kept in NVS
+    calHistoryInit(calHistoryEventCallback);
+
+    // CO2-driven ventilation through the AC model
+    ventControlInit(ventActuate, ventEventCallback);
+
+    // MQTT fan-state confirmation (connects from loop)
+    fanLinkInit(mqttServer, fanLinkEnded);
+
+    // Remote calibration over the same MQTT connection
+    snprintf(frcCommandTopic, sizeof(frcCommandTopic), "%s%s/frc", FRC_TOPIC_PREFIX, deviceName);
+    snprintf(frcStatusTopic, sizeof(frcStatusTopic), "%s/status", frcCommandTopic);
+    fanLinkSubscribe(frcCommandTopic, frcRemoteMessage);
+
+    // Sensor-inferred confirmation for installs without a fan node
+    acConfirmInit(acConfirmEnded);
+
     // Set initial timing
     lastMeasurementTime = millis();
     lastDisplayUpdate = millis();
@@ -843,28 +1752,57 @@ void setup() {
 void loop() {
     // Reset watchdog
     esp_task_wdt_reset();
+    recordLoopLatency();
 
     unsigned long now = millis();
 
+#if IR_USE_RMT
+    // Finish any IR frame going out in the background
+    irRmtPoll();
+#endif
+
     // Handle serial commands (IR control)
     handleSerialCommands();
 
-    // Handle IR spam mode
+    // MQTT fan link - ends spam as soon as the fan node confirms
+    fanLinkPoll();
+    acConfirmPoll();
+
+    // Handle IR spam mode - queued at the lowest priority; the scheduler
+    // paces it to the frame length and lets manual commands go first
     if (irSpamming && (now - lastIrSpam >= IR_SPAM_INTERVAL_MS)) {
+        queueIR(irSpamOn ? irSignalOn : irSignalOff, IR_PRIO_SPAM);
         lastIrSpam = now;
-        if (irSpamOn) {
-            sendIROn();
-            Serial.println("[IR] ON signal sent");
-        } else {
-            sendIROff();
-            Serial.println("[IR] OFF signal sent");
-        }
+    }
+
+    // Send the next queued IR command once the transmitter is free
+    irSchedPoll();
+
+    // Finish an IR learn capture
+    irLearnPoll();
+
+    // Next macro step, time-of-day schedules
+    irMacroPoll();
+
+    // Re-send unconfirmed ventilation commands
+    ventControlPoll();
+
+    // Dim/blank the panel after inactivity or during quiet hours
+    displayPowerUpdate(u8g2);
+
+    // BOOT button gestures, decoded off the loop by button_input.h
+    ButtonEvent buttonEvent;
+    while (buttonTakeEvent(buttonEvent)) {
+        handleButtonEvent(buttonEvent);
     }
 
     // Update display periodically (for clock, WiFi status, etc.)
-    if (now - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL_MS) {
+    // While dimmed, the display only changes when a new reading arrives.
+    // During calibration the FRC module owns the screen.
+    if (!frcActive() && displayPowerPeriodicRefresh() &&
+        now - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL_MS) {
         lastDisplayUpdate = now;
-        if (displayWaiting) {
+        if (displayWaiting && currentPage == PAGE_READING) {
             // Show countdown during waiting phase
             unsigned long elapsed = now - lastMeasurementTime;
             unsigned long remaining = elapsed < MEASUREMENT_INTERVAL_MS ?
@@ -875,16 +1813,52 @@ void loop() {
         }
     }
 
-    // Check for FRC button press
+    // I2C recovery ladder - owns the sensor until it's done. Read again on
+    // the next slot once it's back.
+    if (i2cRecoveryPoll() && i2cRecoveryLastSucceeded()) {
+        displayError = false;
+        lastMeasurementTime = millis() - MEASUREMENT_INTERVAL_MS + I2C_RECOVERY_START_DELAY_MS;
+    }
+    if (i2cRecoveryActive()) {
+        delay(50);
+        return;
+    }
+
+    // Forced recalibration - one step per pass, the rest of the loop keeps
+    // running. The module restarts periodic measurement itself.
     if (frcCheckButton(sensor, frcEventCallback, frcDisplayUpdate)) {
-        // FRC was performed, restart periodic measurement
-        sensor.startPeriodicMeasurement();
+        publishFrcResult();
+        calHistoryRecord(frcLastResult());
         lastMeasurementTime = millis();
-        displayMessage("Calibration", "Complete!");
-        delay(2000);
+        displayMessage("Calibration", frcLastSucceeded() ? "Complete!" : "Failed");
+        lastDisplayUpdate = millis();
+        return;
+    }
+
+    frcRemotePoll(now);
+
+    // Warmup readings are uploaded too, tagged so they can be told apart -
+    // at the normal interval, not every 5 s sample
+    uint16_t frcCO2 = 0;
+    float frcTemp = 0.0;
+    float frcHumidity = 0.0;
+    if (frcTakeWarmupReading(frcCO2, frcTemp, frcHumidity) &&
+        now - lastWarmupUploadTime >= MEASUREMENT_INTERVAL_MS) {
+        lastWarmupUploadTime = now;
+        if (sendReading(frcCO2, frcTemp, frcHumidity, "frc_warmup")) {
+            warmupUploads++;
+        }
+    }
+
+    // The sensor belongs to the FRC module until it's done
+    if (frcActive()) {
+        delay(50);
         return;
     }
 
+    // 5 s readings while waiting for the room to respond to an AC command
+    sampleForConfirmation(now);
+
     // Check if it's time for a measurement
     if (now - lastMeasurementTime < MEASUREMENT_INTERVAL_MS) {
         delay(50);
@@ -892,69 +1866,70 @@ void loop() {
     }
     lastMeasurementTime = now;
 
+#if MUX_ENABLED
+    // The other channels measured in the same windows - read them first
+    // so they upload even when the primary fails
+    muxReadOthers();
+#endif
+
     // Read measurement
     uint16_t co2 = 0;
     float temp = 0.0;
     float humidity = 0.0;
 
     bool dataReady = false;
+    uint32_t t = micros();
     int16_t error = sensor.getDataReadyStatus(dataReady);
+    i2cRecord(SCD4X_GET_DATA_READY, micros() - t, error);
 
     if (error != 0) {
         Serial.print("getDataReadyStatus error: ");
         Serial.println(error);
         totalI2CErrors++;
-        consecutiveI2CFailures++;
         displayError = true;
         updateDisplay();
-
-        if (consecutiveI2CFailures >= 3) {
-            sendEvent(EVENT_WARNING, "Attempting I2C recovery");
-            if (recoverI2C()) {
-                sendEvent(EVENT_INFO, "I2C recovery successful");
-                consecutiveI2CFailures = 0;
-                displayError = false;
-            } else {
-                sendEvent(EVENT_CRITICAL, "I2C recovery failed");
-            }
-        }
+        uploadReading(false, 0, 0, 0, error);
+        i2cRecoveryStart();
         return;
     }
 
-    if (!dataReady) {
+    // A confirmation sample may have just taken this period's reading
+    bool useFast = !dataReady && fastSampleTime > 0 &&
+                   now - fastSampleTime < 2 * AC_CONFIRM_SAMPLE_MS;
+
+    if (!dataReady && !useFast) {
         Serial.println("Data not ready (unexpected at 60s interval)");
+        uploadReading(false, 0, 0, 0);
         return;
     }
 
-    error = sensor.readMeasurement(co2, temp, humidity);
+    if (useFast) {
+        co2 = fastCO2;
+        temp = fastTemp;
+        humidity = fastHumidity;
+    } else {
+        t = micros();
+        error = sensor.readMeasurement(co2, temp, humidity);
+        i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
+    }
 
     if (error != 0) {
         Serial.print("readMeasurement error: ");
         Serial.println(error);
         totalI2CErrors++;
-        consecutiveI2CFailures++;
         displayError = true;
         updateDisplay();
 
         char errMsg[64];
         snprintf(errMsg, sizeof(errMsg), "Read failed, error: %d", error);
         sendEvent(EVENT_ERROR, errMsg);
-
-        if (consecutiveI2CFailures >= 3) {
-            sendEvent(EVENT_WARNING, "Attempting I2C recovery");
-            if (recoverI2C()) {
-                sendEvent(EVENT_INFO, "I2C recovery successful");
-                consecutiveI2CFailures = 0;
-                displayError = false;
-            } else {
-                sendEvent(EVENT_CRITICAL, "I2C recovery failed");
-            }
-        }
+        uploadReading(false, 0, 0, 0, error);
+        i2cRecoveryStart();
         return;
     }
 
     // Successful read
-    consecutiveI2CFailures = 0;
+    i2cRecoveryNoteSuccess();
     totalMeasurements++;
     displayError = false;
     displayWaiting = false;
@@ -963,6 +1938,14 @@ void loop() {
     displayCO2 = co2;
     displayTemp = temp;
     displayHumidity = humidity;
+    recordTrendReading(co2);
+    displayPowerCheckAlarm(u8g2, co2);
+    ventControlUpdate(co2);
+    calHistoryUpdate(co2);
+    if (!useFast) {
+        // The confirmation window would otherwise miss this 5 s period
+        acConfirmSample(co2, temp, humidity);
+    }
     updateDisplay();
 
     // Sanity check
@@ -982,7 +1965,7 @@ void loop() {
     Serial.println(" %");
 
     // Send to API
-    if (sendReading(co2, temp, humidity)) {
+    if (uploadReading(true, co2, temp, humidity)) {
         successfulUploads++;
         consecutiveUploadFailures = 0;
         flashLED(1);
@@ -1009,6 +1992,10 @@ void loop() {
                  totalMeasurements > 0 ? (100.0 * successfulUploads / totalMeasurements) : 0.0,
                  totalI2CErrors,
                  totalWiFiReconnects);
-        sendEvent(EVENT_INFO, healthMsg);
+        static char i2cData[I2C_TELEMETRY_JSON_SIZE];
+        if (!i2cTelemetryJson(i2cData, sizeof(i2cData))) {
+            Serial.println("[I2C] Telemetry JSON truncated");
+        }
+        sendEvent(EVENT_INFO, healthMsg, "health", i2cData);
     }
 }
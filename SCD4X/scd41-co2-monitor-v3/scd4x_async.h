@@ -0,0 +1,301 @@
+/*
+ * Non-blocking SCD4x Commands
+ *
+ * SensirionI2cScd4x sleeps inside every call for the command's execution
+ * time - 500 ms for stop_periodic_measurement, 400 ms for a forced
+ * recalibration, 5 s for a single-shot measurement. This layer sends the
+ * same commands straight over Wire and returns a future holding the time
+ * the result is ready, so the loop keeps running meanwhile:
+ *
+ *   Scd4xFuture f;
+ *   scd4xIssue(SCD4X_STOP_PERIODIC, f);      // returns at once
+ *   ...
+ *   if (scd4xReady(f)) scd4xCollect(f);      // 500 ms later
+ *
+ * Execution times come from the datasheet and live in the SCD4X_COMMANDS
+ * table below, checked at compile time against the command enum. While a
+ * command executes the sensor doesn't answer, so scd4xIssue() refuses a
+ * second one until the first is ready (SCD4X_ERR_BUSY).
+ *
+ * Several sensors at the same address behind a mux are told apart with
+ * scd4xAsyncSelectDevice(): each device has its own busy time, so one can
+ * execute while the next is sent a command. A future must be collected
+ * with its own device selected.
+ *
+ * Mixing with the library is fine as long as its calls don't overlap a
+ * command issued here. Errors use the library's encoding (kind in the high
+ * byte, Wire code in the low byte), so callers can treat both alike.
+ *
+ * Usage:
+ *   1. scd4xAsyncBegin(Wire, address[, observer]) in setup(), after
+ *      Wire.begin() - the observer sees each finished bus transaction
+ *   2. scd4xIssue() / scd4xIssueWithArg() to start a command
+ *   3. scd4xReady(future), then scd4xCollect(future, words) for the result
+ */
+
+#ifndef SCD4X_ASYNC_H
+#define SCD4X_ASYNC_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// ===========================================
+// Errors - same high bytes as the Sensirion Arduino core
+// ===========================================
+
+#define SCD4X_ERR_NONE      0
+#define SCD4X_ERR_WRITE     0x0100  // | Wire.endTransmission() code (2 = address
+                                    //   NACK, 3 = data NACK, 5 = timeout)
+#define SCD4X_ERR_READ      0x0200  // Fewer bytes than expected
+#define SCD4X_ERR_CRC       0x0600  // Word CRC mismatch
+#define SCD4X_ERR_BUSY      0x0F00  // Previous command still executing
+#define SCD4X_ERR_NOT_READY 0x0F01  // Collected before its ready time
+#define SCD4X_ERR_DEVICE    0x0F02  // Collected with another device selected
+
+// Longest response (get_serial_number, read_measurement)
+#define SCD4X_MAX_WORDS 3
+
+// Sensors sharing the address (mux channels)
+#define SCD4X_MAX_DEVICES 8
+
+// ===========================================
+// Command table
+// ===========================================
+
+enum Scd4xCommand {
+    SCD4X_START_PERIODIC = 0,
+    SCD4X_READ_MEASUREMENT,
+    SCD4X_STOP_PERIODIC,
+    SCD4X_SET_TEMPERATURE_OFFSET,
+    SCD4X_SET_SENSOR_ALTITUDE,
+    SCD4X_PERFORM_FRC,
+    SCD4X_SET_ASC_ENABLED,
+    SCD4X_GET_DATA_READY,
+    SCD4X_PERSIST_SETTINGS,
+    SCD4X_GET_SERIAL_NUMBER,
+    SCD4X_PERFORM_SELF_TEST,
+    SCD4X_PERFORM_FACTORY_RESET,
+    SCD4X_REINIT,
+    SCD4X_MEASURE_SINGLE_SHOT,
+    SCD4X_MEASURE_SINGLE_SHOT_RHT,
+    SCD4X_POWER_DOWN,
+    SCD4X_WAKE_UP,
+    SCD4X_COMMAND_COUNT
+};
+
+struct Scd4xCommandInfo {
+    Scd4xCommand id;
+    uint16_t code;
+    uint16_t execMs;        // Datasheet execution time
+    uint8_t rxWords;        // Words read back after execMs
+    const char* name;
+};
+
+static constexpr Scd4xCommandInfo SCD4X_COMMANDS[] = {
+    { SCD4X_START_PERIODIC,          0x21B1, 0,     0, "start_periodic_measurement" },
+    { SCD4X_READ_MEASUREMENT,        0xEC05, 1,     3, "read_measurement" },
+    { SCD4X_STOP_PERIODIC,           0x3F86, 500,   0, "stop_periodic_measurement" },
+    { SCD4X_SET_TEMPERATURE_OFFSET,  0x241D, 1,     0, "set_temperature_offset" },
+    { SCD4X_SET_SENSOR_ALTITUDE,     0x2427, 1,     0, "set_sensor_altitude" },
+    { SCD4X_PERFORM_FRC,             0x362F, 400,   1, "perform_forced_recalibration" },
+    { SCD4X_SET_ASC_ENABLED,         0x2416, 1,     0, "set_automatic_self_calibration_enabled" },
+    { SCD4X_GET_DATA_READY,          0xE4B8, 1,     1, "get_data_ready_status" },
+    { SCD4X_PERSIST_SETTINGS,        0x3615, 800,   0, "persist_settings" },
+    { SCD4X_GET_SERIAL_NUMBER,       0x3682, 1,     3, "get_serial_number" },
+    { SCD4X_PERFORM_SELF_TEST,       0x3639, 10000, 1, "perform_self_test" },
+    { SCD4X_PERFORM_FACTORY_RESET,   0x3632, 1200,  0, "perform_factory_reset" },
+    { SCD4X_REINIT,                  0x3646, 30,    0, "reinit" },
+    { SCD4X_MEASURE_SINGLE_SHOT,     0x219D, 5000,  0, "measure_single_shot" },
+    { SCD4X_MEASURE_SINGLE_SHOT_RHT, 0x2196, 50,    0, "measure_single_shot_rht_only" },
+    { SCD4X_POWER_DOWN,              0x36E0, 1,     0, "power_down" },
+    { SCD4X_WAKE_UP,                 0x36F6, 30,    0, "wake_up" },
+};
+
+// Every command has a row, in enum order
+static constexpr bool _scd4xTableOrdered(int i = 0) {
+    return i == SCD4X_COMMAND_COUNT ||
+           (SCD4X_COMMANDS[i].id == i && _scd4xTableOrdered(i + 1));
+}
+static_assert(sizeof(SCD4X_COMMANDS) / sizeof(SCD4X_COMMANDS[0]) == SCD4X_COMMAND_COUNT,
+              "SCD4X_COMMANDS needs one row per Scd4xCommand");
+static_assert(_scd4xTableOrdered(), "SCD4X_COMMANDS rows must follow the Scd4xCommand order");
+
+constexpr uint16_t scd4xExecMs(Scd4xCommand cmd) {
+    return SCD4X_COMMANDS[cmd].execMs;
+}
+
+// ===========================================
+// Types
+// ===========================================
+
+struct Scd4xFuture {
+    Scd4xCommand cmd;
+    unsigned long issuedAt;
+    unsigned long readyAt;  // millis() when the result can be collected
+    uint32_t busUs;         // Time spent on the bus so far
+    uint8_t device;         // scd4xAsyncSelectDevice() index it went to
+    int16_t error;          // Set by scd4xIssue() / scd4xCollect()
+    bool pending;           // Issued, not collected yet
+};
+
+// Called once per command with its bus time and final error
+typedef void (*Scd4xObserver)(Scd4xCommand cmd, uint32_t busUs, int16_t error);
+
+// ===========================================
+// State
+// ===========================================
+
+static TwoWire* _saWire = nullptr;
+static uint8_t _saAddr = 0;
+static unsigned long _saBusyUntil[SCD4X_MAX_DEVICES];
+static uint8_t _saBusyMask = 0;
+static uint8_t _saDevice = 0;
+static Scd4xObserver _saObserver = nullptr;
+
+// ===========================================
+// Helpers
+// ===========================================
+
+// Sensirion CRC-8: polynomial 0x31, init 0xFF
+static uint8_t _saCrc(uint8_t msb, uint8_t lsb) {
+    uint8_t crc = 0xFF;
+    uint8_t data[2] = { msb, lsb };
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// ===========================================
+// Initialize - call in setup(), after Wire.begin()
+// ===========================================
+
+void scd4xAsyncBegin(TwoWire &wire, uint8_t address, Scd4xObserver observer = nullptr) {
+    _saWire = &wire;
+    _saAddr = address;
+    _saBusyMask = 0;
+    _saDevice = 0;
+    _saObserver = observer;
+}
+
+// ===========================================
+// Commands
+// ===========================================
+
+// Which sensor the next commands go to - call after switching the mux
+void scd4xAsyncSelectDevice(uint8_t device) {
+    if (device < SCD4X_MAX_DEVICES) _saDevice = device;
+}
+
+// True while a command issued here to the selected device is executing
+bool scd4xBusy() {
+    uint8_t bit = 1 << _saDevice;
+    if ((_saBusyMask & bit) && (long)(millis() - _saBusyUntil[_saDevice]) >= 0) {
+        _saBusyMask &= ~bit;
+    }
+    return _saBusyMask & bit;
+}
+
+static bool _saIssue(Scd4xCommand cmd, const uint16_t* arg, Scd4xFuture &f) {
+    f.cmd = cmd;
+    f.device = _saDevice;
+    f.pending = false;
+    if (scd4xBusy()) {
+        f.error = SCD4X_ERR_BUSY;
+        return false;
+    }
+
+    uint16_t code = SCD4X_COMMANDS[cmd].code;
+    uint32_t startUs = micros();
+    _saWire->beginTransmission(_saAddr);
+    _saWire->write(code >> 8);
+    _saWire->write(code & 0xFF);
+    if (arg) {
+        uint8_t msb = *arg >> 8, lsb = *arg & 0xFF;
+        _saWire->write(msb);
+        _saWire->write(lsb);
+        _saWire->write(_saCrc(msb, lsb));
+    }
+    uint8_t wireError = _saWire->endTransmission();
+    f.busUs = micros() - startUs;
+    if (wireError != 0) {
+        f.error = SCD4X_ERR_WRITE | wireError;
+        if (_saObserver) _saObserver(cmd, f.busUs, f.error);
+        return false;
+    }
+    f.error = SCD4X_ERR_NONE;
+
+    f.issuedAt = millis();
+    f.readyAt = f.issuedAt + scd4xExecMs(cmd);
+    f.pending = true;
+    _saBusyUntil[_saDevice] = f.readyAt;
+    _saBusyMask |= 1 << _saDevice;
+    return true;
+}
+
+// Sends the command and returns at once. False (f.error says why) if it
+// couldn't be sent.
+bool scd4xIssue(Scd4xCommand cmd, Scd4xFuture &f) {
+    return _saIssue(cmd, nullptr, f);
+}
+
+bool scd4xIssueWithArg(Scd4xCommand cmd, uint16_t arg, Scd4xFuture &f) {
+    return _saIssue(cmd, &arg, f);
+}
+
+bool scd4xReady(const Scd4xFuture &f) {
+    return f.pending && (long)(millis() - f.readyAt) >= 0;
+}
+
+// Milliseconds until the future is ready (0 = now)
+unsigned long scd4xRemainingMs(const Scd4xFuture &f) {
+    if (!f.pending) return 0;
+    long left = (long)(f.readyAt - millis());
+    return left > 0 ? left : 0;
+}
+
+// Reads the response words, if the command has any. Returns the error
+// (also left in f.error).
+int16_t scd4xCollect(Scd4xFuture &f, uint16_t* words = nullptr) {
+    if (!f.pending) return f.error;
+    if (!scd4xReady(f)) return SCD4X_ERR_NOT_READY;
+    if (f.device != _saDevice) return SCD4X_ERR_DEVICE;
+    f.pending = false;
+    f.error = SCD4X_ERR_NONE;
+
+    uint8_t n = SCD4X_COMMANDS[f.cmd].rxWords;
+    if (n > 0) {
+        uint32_t startUs = micros();
+        if (_saWire->requestFrom(_saAddr, (uint8_t)(n * 3)) != n * 3) {
+            while (_saWire->available()) _saWire->read();
+            f.error = SCD4X_ERR_READ;
+        } else {
+            for (int i = 0; i < n; i++) {
+                uint8_t msb = _saWire->read();
+                uint8_t lsb = _saWire->read();
+                uint8_t crc = _saWire->read();
+                if (crc != _saCrc(msb, lsb)) f.error = SCD4X_ERR_CRC;
+                if (words) words[i] = ((uint16_t)msb << 8) | lsb;
+            }
+        }
+        f.busUs += micros() - startUs;
+    }
+
+    if (_saObserver) _saObserver(f.cmd, f.busUs, f.error);
+    return f.error;
+}
+
+// Blocks until the future is ready - for setup() only
+int16_t scd4xAwait(Scd4xFuture &f, uint16_t* words = nullptr) {
+    while (f.pending && !scd4xReady(f)) delay(1);
+    return scd4xCollect(f, words);
+}
+
+const char* scd4xCommandName(Scd4xCommand cmd) {
+    return cmd < SCD4X_COMMAND_COUNT ? SCD4X_COMMANDS[cmd].name : "unknown";
+}
+
+#endif // SCD4X_ASYNC_H
@@ -0,0 +1,271 @@
+/*
+ * Multiple SCD41s behind a TCA9548A I2C Multiplexer
+ *
+ * Every SCD41 answers at 0x62, so more than one needs a mux. Each sensor
+ * sits on its own TCA9548A channel and gets its own SensirionI2cScd4x
+ * instance; a one-byte write to the mux picks the channel.
+ *
+ * The first entry in MUX_SENSORS is the primary. It is the sketch's own
+ * sensor object and drives the display, FRC, ventilation and the recovery
+ * ladder exactly as without a mux - its channel stays selected, and the
+ * others are only switched to for a moment while they're read.
+ *
+ * All sensors run in periodic mode at the same time, so their 5 s
+ * measurement windows overlap rather than each taking a turn. Commands
+ * with an execution time are interleaved too: muxBegin() sends every
+ * sensor its stop before waiting on any of them (one 500 ms wait, not one
+ * per sensor), with per-device busy tracking in scd4x_async.h.
+ *
+ * Each sensor uploads under its own name, "<device>-<suffix>", all of them
+ * in one batch per measurement period.
+ *
+ * Usage:
+ *   1. Set MUX_ENABLED 1 and list the channels in MUX_SENSORS
+ *   2. muxBegin(Wire, address) in setup() after scd4xAsyncBegin(), before
+ *      the primary's own stop
+ *   3. muxStartOthers(configure) once the primary is measuring
+ *   4. muxReadOthers() each measurement period, muxSetPrimary() with the
+ *      primary's result, then muxReadingsJson() for the batch upload
+ */
+
+#ifndef SCD4X_MUX_H
+#define SCD4X_MUX_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SensirionI2cScd4x.h>
+#include "scd4x_async.h"
+#include "i2c_telemetry.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// 1 = SCD41s behind a TCA9548A, 0 = one sensor straight on the bus
+#define MUX_ENABLED 0
+
+// TCA9548A address (A0-A2 low)
+#define MUX_I2C_ADDR 0x70
+
+struct MuxSensorConfig {
+    uint8_t channel;        // TCA9548A channel 0-7
+    const char* suffix;     // Upload name is "<device>-<suffix>"
+};
+
+// First entry = primary
+static const MuxSensorConfig MUX_SENSORS[] = {
+    { 0, "a" },
+    { 1, "b" },
+};
+
+#define MUX_SENSOR_COUNT (sizeof(MUX_SENSORS) / sizeof(MUX_SENSORS[0]))
+
+static_assert(MUX_SENSOR_COUNT >= 1 && MUX_SENSOR_COUNT <= SCD4X_MAX_DEVICES,
+              "MUX_SENSORS needs 1 to SCD4X_MAX_DEVICES entries");
+
+// ===========================================
+// Types
+// ===========================================
+
+struct MuxReading {
+    bool valid;             // Last read succeeded
+    uint16_t co2;
+    float temp;
+    float humidity;
+    int16_t error;          // Last error, 0 if valid
+    unsigned long at;       // millis() of the last read
+};
+
+// ===========================================
+// State
+// ===========================================
+
+static TwoWire* _muxWire = nullptr;
+
+// [0] is unused - the primary is the sketch's sensor
+static SensirionI2cScd4x _muxSensor[MUX_SENSOR_COUNT];
+static Scd4xFuture _muxStop[MUX_SENSOR_COUNT];
+static MuxReading _muxReading[MUX_SENSOR_COUNT];
+
+static uint32_t _muxReads[MUX_SENSOR_COUNT];
+static uint32_t _muxErrors[MUX_SENSOR_COUNT];
+static uint32_t _muxSelectErrors = 0;
+
+// ===========================================
+// Channel selection
+// ===========================================
+
+// Routes the bus to sensor index (not channel). False if the mux didn't
+// answer.
+bool muxSelect(uint8_t index) {
+    if (index >= MUX_SENSOR_COUNT || !_muxWire) return false;
+    _muxWire->beginTransmission(MUX_I2C_ADDR);
+    _muxWire->write(1 << MUX_SENSORS[index].channel);
+    if (_muxWire->endTransmission() != 0) {
+        _muxSelectErrors++;
+        return false;
+    }
+    scd4xAsyncSelectDevice(index);
+    return true;
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+// Sends every non-primary sensor its stop, then selects the primary so
+// the sketch can stop and configure it as usual
+void muxBegin(TwoWire &wire, uint8_t address) {
+    _muxWire = &wire;
+    for (uint8_t i = 1; i < MUX_SENSOR_COUNT; i++) {
+        _muxSensor[i].begin(wire, address);
+        _muxStop[i] = {};
+        if (!muxSelect(i) || !scd4xIssue(SCD4X_STOP_PERIODIC, _muxStop[i])) {
+            Serial.print("[Mux] Channel ");
+            Serial.print(MUX_SENSORS[i].channel);
+            Serial.println(": no answer");
+        }
+    }
+    if (!muxSelect(0)) {
+        Serial.println("[Mux] TCA9548A not found");
+    }
+    Serial.print("[Mux] ");
+    Serial.print(MUX_SENSOR_COUNT);
+    Serial.println(" sensors");
+}
+
+typedef int16_t (*MuxConfigureCallback)(SensirionI2cScd4x &sensor);
+
+// Waits out each stop sent by muxBegin() (long done by now), configures
+// and starts the sensor, then returns to the primary
+void muxStartOthers(MuxConfigureCallback configure) {
+    for (uint8_t i = 1; i < MUX_SENSOR_COUNT; i++) {
+        Serial.print("[Mux] Sensor ");
+        Serial.print(MUX_SENSORS[i].suffix);
+        Serial.print(" (channel ");
+        Serial.print(MUX_SENSORS[i].channel);
+        Serial.println(")");
+        if (!muxSelect(i)) continue;
+
+        scd4xAwait(_muxStop[i]);
+        if (configure) configure(_muxSensor[i]);
+
+        uint32_t t = micros();
+        int16_t error = _muxSensor[i].startPeriodicMeasurement();
+        i2cRecord(SCD4X_START_PERIODIC, micros() - t, error);
+        if (error != 0) {
+            Serial.print("[Mux] startPeriodicMeasurement error: ");
+            Serial.println(error);
+        }
+    }
+    muxSelect(0);
+}
+
+// ===========================================
+// Readings
+// ===========================================
+
+static void _muxStore(uint8_t i, bool ok, uint16_t co2, float temp, float humidity,
+                      int16_t error) {
+    MuxReading &r = _muxReading[i];
+    r.valid = ok;
+    r.co2 = ok ? co2 : 0;
+    r.temp = ok ? temp : 0;
+    r.humidity = ok ? humidity : 0;
+    r.error = ok ? 0 : error;
+    r.at = millis();
+    _muxReads[i]++;
+    if (!ok) _muxErrors[i]++;
+}
+
+// Reads every non-primary sensor, then selects the primary again. A
+// sensor without new data reports SCD4X_ERR_NOT_READY.
+void muxReadOthers() {
+    for (uint8_t i = 1; i < MUX_SENSOR_COUNT; i++) {
+        if (!muxSelect(i)) {
+            _muxStore(i, false, 0, 0, 0, SCD4X_ERR_WRITE | 2);
+            continue;
+        }
+
+        bool dataReady = false;
+        uint16_t co2 = 0;
+        float temp = 0, humidity = 0;
+        uint32_t t = micros();
+        int16_t error = _muxSensor[i].getDataReadyStatus(dataReady);
+        i2cRecord(SCD4X_GET_DATA_READY, micros() - t, error);
+        if (error == 0 && dataReady) {
+            t = micros();
+            error = _muxSensor[i].readMeasurement(co2, temp, humidity);
+            i2cRecord(SCD4X_READ_MEASUREMENT, micros() - t, error);
+        }
+        bool ok = error == 0 && dataReady && co2 > 0;
+        _muxStore(i, ok, co2, temp, humidity, error ? error : SCD4X_ERR_NOT_READY);
+    }
+    muxSelect(0);
+}
+
+// The primary is read by the sketch - hand its result over for the batch
+void muxSetPrimary(bool ok, uint16_t co2, float temp, float humidity, int16_t error) {
+    _muxStore(0, ok, co2, temp, humidity, error ? error : SCD4X_ERR_NOT_READY);
+}
+
+const MuxReading& muxReading(uint8_t index) {
+    return _muxReading[index < MUX_SENSOR_COUNT ? index : 0];
+}
+
+void muxSensorName(uint8_t index, const char* device, char* buf, size_t size) {
+    snprintf(buf, size, "%s-%s", device, MUX_SENSORS[index].suffix);
+}
+
+// JSON array with one entry per sensor for the batch upload, "[]" if it
+// doesn't fit
+void muxReadingsJson(const char* device, char* buf, size_t size) {
+    size_t n = snprintf(buf, size, "[");
+    for (uint8_t i = 0; i < MUX_SENSOR_COUNT && n < size; i++) {
+        const MuxReading &r = _muxReading[i];
+        char name[40];
+        muxSensorName(i, device, name, sizeof(name));
+        if (r.valid) {
+            n += snprintf(buf + n, size - n,
+                          "%s{\"device\":\"%s\",\"channel\":%d,\"co2\":%u,\"temp\":%.1f,\"humidity\":%.1f}",
+                          i ? "," : "", name, MUX_SENSORS[i].channel, r.co2, r.temp, r.humidity);
+        } else {
+            n += snprintf(buf + n, size - n, "%s{\"device\":\"%s\",\"channel\":%d,\"error\":%d}",
+                          i ? "," : "", name, MUX_SENSORS[i].channel, r.error);
+        }
+    }
+    if (n < size) n += snprintf(buf + n, size - n, "]");
+    if (n >= size) snprintf(buf, size, "[]");
+}
+
+// ===========================================
+// Stats
+// ===========================================
+
+void muxPrintStats() {
+    Serial.print("Mux: ");
+    Serial.print(MUX_SENSOR_COUNT);
+    Serial.print(" sensors, ");
+    Serial.print(_muxSelectErrors);
+    Serial.println(" select errors");
+    for (uint8_t i = 0; i < MUX_SENSOR_COUNT; i++) {
+        const MuxReading &r = _muxReading[i];
+        Serial.print("  ");
+        Serial.print(MUX_SENSORS[i].suffix);
+        Serial.print(" (ch ");
+        Serial.print(MUX_SENSORS[i].channel);
+        Serial.print("): ");
+        Serial.print(_muxReads[i]);
+        Serial.print(" reads, ");
+        Serial.print(_muxErrors[i]);
+        Serial.print(" errors");
+        if (r.valid) {
+            Serial.print(", last ");
+            Serial.print(r.co2);
+            Serial.print(" ppm");
+        }
+        Serial.println();
+    }
+}
+
+#endif // SCD4X_MUX_H
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Extract OLED framebuffer snapshots from a v3 serial log.
+
+Type `snap` in the serial monitor; the sketch renders every screen state
+and prints each framebuffer as an ASCII PBM between BEGIN/END markers.
+Save the serial output to a file and run:
+
+    python3 snapshot_capture.py serial.log -o snapshots/
+
+Each screen is written as <name>.pbm along with its render time. With
+--compare, snapshots are checked pixel-by-pixel against a directory of
+previously saved .pbm files; the exit code is 1 if any screen changed
+(or, with --strict, has no reference yet).
+
+host/ renders the same screens on a PC in the same format - see its
+Makefile.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+BEGIN_RE = re.compile(r"-----BEGIN SNAPSHOT (\S+) (\d+)us-----")
+END_RE = re.compile(r"-----END SNAPSHOT (\S+)-----")
+
+
+def parse_snapshots(lines):
+    """Yield (name, render_us, pbm_text) for each snapshot block."""
+    name = None
+    render_us = 0
+    body = []
+    for line in lines:
+        line = line.strip()
+        begin = BEGIN_RE.search(line)
+        if begin:
+            name, render_us, body = begin.group(1), int(begin.group(2)), []
+            continue
+        if name is None:
+            continue
+        if END_RE.search(line):
+            yield name, render_us, "\n".join(body) + "\n"
+            name = None
+            continue
+        body.append(line)
+
+
+def pbm_pixels(text):
+    """Return (width, height, pixel string) from an ASCII P1 PBM."""
+    tokens = [t for t in text.split() if not t.startswith("#")]
+    if not tokens or tokens[0] != "P1":
+        raise ValueError("not an ASCII PBM")
+    width, height = int(tokens[1]), int(tokens[2])
+    pixels = "".join(tokens[3:])
+    return width, height, pixels
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("log", nargs="?", help="serial log file (default: stdin)")
+    parser.add_argument("-o", "--output", default="snapshots", help="output directory")
+    parser.add_argument("--compare", metavar="DIR", help="directory of reference .pbm files")
+    parser.add_argument("--strict", action="store_true",
+                        help="with --compare, a screen without a reference counts as changed")
+    args = parser.parse_args()
+
+    source = open(args.log) if args.log else sys.stdin
+    os.makedirs(args.output, exist_ok=True)
+
+    changed = 0
+    count = 0
+    for name, render_us, text in parse_snapshots(source):
+        count += 1
+        path = os.path.join(args.output, name + ".pbm")
+        with open(path, "w") as f:
+            f.write(text)
+
+        status = ""
+        if args.compare:
+            ref_path = os.path.join(args.compare, name + ".pbm")
+            if not os.path.exists(ref_path):
+                status = "  (no reference)"
+                if args.strict:
+                    changed += 1
+            else:
+                with open(ref_path) as f:
+                    ref = pbm_pixels(f.read())
+                cur = pbm_pixels(text)
+                if ref[:2] != cur[:2]:
+                    status = "  SIZE CHANGED"
+                    changed += 1
+                else:
+                    diff = sum(1 for a, b in zip(ref[2], cur[2]) if a != b)
+                    if diff:
+                        status = "  CHANGED (%d pixels)" % diff
+                        changed += 1
+                    else:
+                        status = "  unchanged"
+
+        print("%-16s %7d us  -> %s%s" % (name, render_us, path, status))
+
+    if count == 0:
+        print("No snapshots found - did you run 'snap'?", file=sys.stderr)
+        return 1
+    return 1 if changed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
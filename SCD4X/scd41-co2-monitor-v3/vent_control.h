@@ -0,0 +1,411 @@
+/*
+ * CO2-driven Ventilation Control
+ *
+ * Closes the loop between the CO2 reading and the IR blaster: the AC/fan
+ * is turned on when CO2 rises above VENT_HIGH_PPM and off again once it
+ * falls below VENT_LOW_PPM.
+ *
+ *   - Hysteresis: the gap between the two thresholds keeps it from
+ *     toggling around a single set point
+ *   - Minimum dwell: once on it stays on for VENT_MIN_ON_MS, once off it
+ *     stays off for VENT_MIN_OFF_MS
+ *   - Retries: IR is one-way, so an unconfirmed command is re-sent every
+ *     VENT_RETRY_INTERVAL_MS, at most VENT_MAX_IR_RETRIES times. Anything
+ *     that can confirm the fan state calls ventControlConfirm().
+ *   - Early start (optional): if CO2 is above VENT_EARLY_MIN_PPM and the
+ *     slope of the last VENT_SLOPE_SAMPLES readings projects it past
+ *     VENT_HIGH_PPM within VENT_EARLY_LOOKAHEAD_MIN, start now
+ *
+ * The controller only turns off ventilation it turned on itself.
+ *
+ * It starts disabled - nothing switches the AC until `vent on` - and the
+ * enabled flag is saved to NVS, so `vent on` / `vent off` survive a reboot.
+ *
+ * Every decision is logged through the event callback and counted, along
+ * with time spent ventilating (energy) and time spent above the high
+ * threshold (air quality).
+ *
+ * Usage:
+ *   1. ventControlInit(actuate, logEvent) in setup()
+ *   2. ventControlUpdate(co2) with every new reading
+ *   3. ventControlPoll() every loop pass (retries)
+ *   4. ventControlConfirm(on) when the fan state is confirmed
+ */
+
+#ifndef VENT_CONTROL_H
+#define VENT_CONTROL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// Until `vent on` is saved, the controller leaves the AC alone
+#define VENT_ENABLED_DEFAULT false
+#define VENT_PREFS_NAMESPACE "vent"
+
+// Hysteresis thresholds
+#define VENT_HIGH_PPM 1000
+#define VENT_LOW_PPM  800
+
+// Minimum dwell times
+#define VENT_MIN_ON_MS  600000UL     // 10 minutes
+#define VENT_MIN_OFF_MS 300000UL     // 5 minutes
+
+// Unconfirmed commands are re-sent this often, at most this many times
+#define VENT_RETRY_INTERVAL_MS 60000UL
+#define VENT_MAX_IR_RETRIES    1
+
+// Trend-based early start
+#define VENT_EARLY_START          1
+#define VENT_EARLY_MIN_PPM        850
+#define VENT_EARLY_SLOPE_PPM_MIN  10.0    // Minimum rise, ppm per minute
+#define VENT_EARLY_LOOKAHEAD_MIN  10.0
+#define VENT_SLOPE_SAMPLES        5
+
+// ===========================================
+// Types
+// ===========================================
+
+enum VentEventType {
+    VENT_EVENT_INFO = 0,
+    VENT_EVENT_WARNING = 1
+};
+
+// Sends the on/off command. `retry` is true for re-sends of an unconfirmed
+// command (the actuator should send even if it thinks nothing changed).
+typedef bool (*VentActuateFn)(bool on, bool retry);
+
+typedef bool (*VentEventCallback)(int eventType, const char* message);
+
+// ===========================================
+// State
+// ===========================================
+
+static Preferences _ventPrefs;
+static VentActuateFn _ventActuate = nullptr;
+static VentEventCallback _ventLog = nullptr;
+static bool _ventEnabled = VENT_ENABLED_DEFAULT;
+
+static bool _ventOn = false;               // Ventilation the controller turned on
+static unsigned long _ventChangedMs = 0;   // Last on/off decision
+static bool _ventEverChanged = false;
+static uint16_t _ventLastCO2 = 0;
+static unsigned long _ventLastUpdateMs = 0;
+
+// Unconfirmed command
+static bool _ventAwaitingConfirm = false;
+static uint8_t _ventRetries = 0;
+static unsigned long _ventLastAttemptMs = 0;
+
+// Dwell holds are logged once per hold, not every reading
+static bool _ventHoldLogged = false;
+
+// Recent readings for the slope
+static uint16_t _ventSamplePpm[VENT_SLOPE_SAMPLES];
+static unsigned long _ventSampleMs[VENT_SLOPE_SAMPLES];
+static uint8_t _ventSampleHead = 0;
+static uint8_t _ventSampleCount = 0;
+
+// Stats
+static uint32_t _ventActivations = 0;
+static uint32_t _ventDeactivations = 0;
+static uint32_t _ventEarlyStarts = 0;
+static uint32_t _ventCommands = 0;
+static uint32_t _ventRetryCount = 0;
+static uint32_t _ventUnconfirmed = 0;
+static uint32_t _ventHoldsOn = 0;          // Wanted off, held by VENT_MIN_ON_MS
+static uint32_t _ventHoldsOff = 0;         // Wanted on, held by VENT_MIN_OFF_MS
+static unsigned long _ventOnMs = 0;        // Total time ventilating
+static unsigned long _ventAboveHighMs = 0; // Total time with CO2 >= VENT_HIGH_PPM
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static void _ventEvent(int type, const char* message) {
+    Serial.print("[Vent] ");
+    Serial.println(message);
+    if (_ventLog) _ventLog(type, message);
+}
+
+static void _ventAddSample(uint16_t co2, unsigned long now) {
+    _ventSamplePpm[_ventSampleHead] = co2;
+    _ventSampleMs[_ventSampleHead] = now;
+    _ventSampleHead = (_ventSampleHead + 1) % VENT_SLOPE_SAMPLES;
+    if (_ventSampleCount < VENT_SLOPE_SAMPLES) _ventSampleCount++;
+}
+
+// Least-squares slope of the recent readings, ppm per minute
+static bool _ventSlope(float &slope) {
+    if (_ventSampleCount < VENT_SLOPE_SAMPLES) return false;
+
+    unsigned long t0 = _ventSampleMs[_ventSampleHead];   // Oldest sample
+    float sumT = 0, sumP = 0, sumTT = 0, sumTP = 0;
+    for (int i = 0; i < _ventSampleCount; i++) {
+        float t = (_ventSampleMs[i] - t0) / 60000.0;
+        float p = _ventSamplePpm[i];
+        sumT += t;
+        sumP += p;
+        sumTT += t * t;
+        sumTP += t * p;
+    }
+    float n = _ventSampleCount;
+    float denom = n * sumTT - sumT * sumT;
+    if (denom <= 0) return false;
+    slope = (n * sumTP - sumT * sumP) / denom;
+    return true;
+}
+
+static void _ventSend(bool on, bool retry) {
+    _ventCommands++;
+    _ventLastAttemptMs = millis();
+    if (_ventActuate) _ventActuate(on, retry);
+}
+
+static void _ventSwitch(bool on, const char* reason) {
+    _ventOn = on;
+    _ventChangedMs = millis();
+    _ventEverChanged = true;
+    _ventAwaitingConfirm = true;
+    _ventRetries = 0;
+    _ventHoldLogged = false;
+
+    if (on) {
+        _ventActivations++;
+    } else {
+        _ventDeactivations++;
+    }
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Ventilation %s: %s (CO2 %u ppm)",
+             on ? "ON" : "OFF", reason, _ventLastCO2);
+    _ventEvent(VENT_EVENT_INFO, msg);
+
+    _ventSend(on, false);
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+void ventControlInit(VentActuateFn actuate, VentEventCallback logEvent = nullptr) {
+    _ventActuate = actuate;
+    _ventLog = logEvent;
+    _ventLastUpdateMs = millis();
+
+    _ventPrefs.begin(VENT_PREFS_NAMESPACE, false);
+    _ventEnabled = _ventPrefs.getBool("enabled", VENT_ENABLED_DEFAULT);
+
+    Serial.print("[Vent] Control ");
+    Serial.print(_ventEnabled ? "enabled" : "disabled");
+    Serial.print(": on >= ");
+    Serial.print(VENT_HIGH_PPM);
+    Serial.print(" ppm, off < ");
+    Serial.print(VENT_LOW_PPM);
+    Serial.println(" ppm");
+}
+
+// ===========================================
+// Update - call with every new CO2 reading
+// ===========================================
+
+void ventControlUpdate(uint16_t co2) {
+    unsigned long now = millis();
+    unsigned long elapsed = now - _ventLastUpdateMs;
+    _ventLastUpdateMs = now;
+
+    // Time accounting uses the state since the previous reading
+    if (_ventOn) _ventOnMs += elapsed;
+    if (_ventLastCO2 >= VENT_HIGH_PPM) _ventAboveHighMs += elapsed;
+
+    _ventLastCO2 = co2;
+    _ventAddSample(co2, now);
+
+    if (!_ventEnabled) return;
+
+    unsigned long sinceChange = now - _ventChangedMs;
+    char msg[96];
+
+    if (!_ventOn) {
+        bool wantOn = co2 >= VENT_HIGH_PPM;
+        bool early = false;
+        float slope = 0;
+
+#if VENT_EARLY_START
+        if (!wantOn && co2 >= VENT_EARLY_MIN_PPM && _ventSlope(slope) &&
+            slope >= VENT_EARLY_SLOPE_PPM_MIN &&
+            co2 + slope * VENT_EARLY_LOOKAHEAD_MIN >= VENT_HIGH_PPM) {
+            wantOn = true;
+            early = true;
+        }
+#endif
+
+        if (!wantOn) {
+            _ventHoldLogged = false;
+            return;
+        }
+
+        if (_ventEverChanged && sinceChange < VENT_MIN_OFF_MS) {
+            if (!_ventHoldLogged) {
+                _ventHoldsOff++;
+                _ventHoldLogged = true;
+                snprintf(msg, sizeof(msg), "CO2 %u ppm, holding off for %lus (min off time)",
+                         co2, (VENT_MIN_OFF_MS - sinceChange) / 1000);
+                _ventEvent(VENT_EVENT_INFO, msg);
+            }
+            return;
+        }
+
+        if (early) {
+            _ventEarlyStarts++;
+            snprintf(msg, sizeof(msg), "early start, rising %.0f ppm/min", slope);
+            _ventSwitch(true, msg);
+        } else {
+            _ventSwitch(true, "above high threshold");
+        }
+    } else {
+        if (co2 >= VENT_LOW_PPM) {
+            _ventHoldLogged = false;
+            return;
+        }
+
+        if (sinceChange < VENT_MIN_ON_MS) {
+            if (!_ventHoldLogged) {
+                _ventHoldsOn++;
+                _ventHoldLogged = true;
+                snprintf(msg, sizeof(msg), "CO2 %u ppm, staying on for %lus (min on time)",
+                         co2, (VENT_MIN_ON_MS - sinceChange) / 1000);
+                _ventEvent(VENT_EVENT_INFO, msg);
+            }
+            return;
+        }
+
+        _ventSwitch(false, "below low threshold");
+    }
+}
+
+// ===========================================
+// Poll - call every loop pass
+// ===========================================
+
+void ventControlPoll() {
+    if (!_ventAwaitingConfirm) return;
+    if (millis() - _ventLastAttemptMs < VENT_RETRY_INTERVAL_MS) return;
+
+    char msg[80];
+    if (_ventRetries >= VENT_MAX_IR_RETRIES) {
+        _ventAwaitingConfirm = false;
+        _ventUnconfirmed++;
+        snprintf(msg, sizeof(msg), "%s not confirmed after %u attempts",
+                 _ventOn ? "ON" : "OFF", _ventRetries + 1);
+        _ventEvent(VENT_EVENT_WARNING, msg);
+        return;
+    }
+
+    _ventRetries++;
+    _ventRetryCount++;
+    snprintf(msg, sizeof(msg), "Retrying %s (%u/%u)", _ventOn ? "ON" : "OFF",
+             _ventRetries, VENT_MAX_IR_RETRIES);
+    _ventEvent(VENT_EVENT_INFO, msg);
+    _ventSend(_ventOn, true);
+}
+
+// ===========================================
+// Confirmation - call when the fan is known to be on/off
+// ===========================================
+
+void ventControlConfirm(bool on) {
+    if (!_ventAwaitingConfirm || on != _ventOn) return;
+    _ventAwaitingConfirm = false;
+
+    Serial.print("[Vent] ");
+    Serial.print(on ? "ON" : "OFF");
+    Serial.print(" confirmed after ");
+    Serial.print(_ventRetries + 1);
+    Serial.println(" attempt(s)");
+}
+
+// ===========================================
+// Enable / disable
+// ===========================================
+
+void ventControlSetEnabled(bool enabled) {
+    if (enabled == _ventEnabled) return;
+    _ventEnabled = enabled;
+    _ventPrefs.putBool("enabled", enabled);
+    _ventAwaitingConfirm = false;
+    _ventEvent(VENT_EVENT_INFO, enabled ? "Control enabled" : "Control disabled");
+
+    // Don't leave ventilation running that nothing will turn off
+    if (!enabled && _ventOn) {
+        _ventSwitch(false, "control disabled");
+        _ventAwaitingConfirm = false;
+    }
+}
+
+bool ventControlEnabled() {
+    return _ventEnabled;
+}
+
+// ===========================================
+// Status
+// ===========================================
+
+bool ventControlIsOn() {
+    return _ventOn;
+}
+
+bool ventControlAwaitingConfirm() {
+    return _ventAwaitingConfirm;
+}
+
+uint32_t ventControlActivations() {
+    return _ventActivations;
+}
+
+void ventControlPrintStats() {
+    Serial.print("Ventilation: ");
+    Serial.print(_ventEnabled ? (_ventOn ? "ON" : "off") : "disabled");
+    if (_ventAwaitingConfirm) Serial.print(" (unconfirmed)");
+    Serial.print(", ");
+    Serial.print(_ventActivations);
+    Serial.print(" on / ");
+    Serial.print(_ventDeactivations);
+    Serial.print(" off, ");
+    Serial.print(_ventEarlyStarts);
+    Serial.println(" early starts");
+
+    Serial.print("  IR commands: ");
+    Serial.print(_ventCommands);
+    Serial.print(" (");
+    Serial.print(_ventRetryCount);
+    Serial.print(" retries, ");
+    Serial.print(_ventUnconfirmed);
+    Serial.println(" unconfirmed)");
+
+    Serial.print("  Dwell holds: ");
+    Serial.print(_ventHoldsOn);
+    Serial.print(" min-on, ");
+    Serial.print(_ventHoldsOff);
+    Serial.println(" min-off");
+
+    Serial.print("  Time ventilating: ");
+    Serial.print(_ventOnMs / 60000);
+    Serial.print(" min, CO2 >= ");
+    Serial.print(VENT_HIGH_PPM);
+    Serial.print(": ");
+    Serial.print(_ventAboveHighMs / 60000);
+    Serial.println(" min");
+
+    float slope;
+    if (_ventSlope(slope)) {
+        Serial.print("  CO2 trend: ");
+        Serial.print(slope, 1);
+        Serial.println(" ppm/min");
+    }
+}
+
+#endif // VENT_CONTROL_H
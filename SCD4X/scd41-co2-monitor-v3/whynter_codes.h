@@ -0,0 +1,162 @@
+/*
+ * IR command table generated from Whynter.ir
+ *
+ * DO NOT EDIT - regenerate with:
+ *   python3 flipper_ir_codegen.py Whynter.ir -o whynter_codes.h
+ *
+ * Use a constant directly (WHYNTER_AC_ON) or look a signal up by
+ * name with whynterFindSignal("Ac_On"). Constants the sketch doesn't
+ * reference are dropped by the compiler.
+ */
+
+#ifndef WHYNTER_CODES_H
+#define WHYNTER_CODES_H
+
+#include <Arduino.h>
+#include "whynter_protocol.h"
+
+// ===========================================
+// Signal table entry (shared by all generated tables)
+// ===========================================
+
+#ifndef IR_SIGNAL_DEFINED
+#define IR_SIGNAL_DEFINED
+
+enum IrSignalKind : uint8_t {
+    IR_SIGNAL_WHYNTER = 0,  // Protocol frames, see whynter_protocol.h
+    IR_SIGNAL_RAW = 1,      // Raw mark/space timings
+    IR_SIGNAL_PARSED = 2    // Flipper parsed signal (protocol/address/command)
+};
+
+struct IrSignal {
+    const char* name;
+    IrSignalKind kind;
+    uint32_t frequency;
+    float dutyCycle;
+    const WhynterCommand* whynter;  // IR_SIGNAL_WHYNTER
+    const uint16_t* raw;            // IR_SIGNAL_RAW
+    uint16_t rawLength;
+    const char* protocol;           // IR_SIGNAL_PARSED
+    uint32_t address;
+    uint32_t command;
+};
+
+#endif // IR_SIGNAL_DEFINED
+
+// ===========================================
+// Signals
+// ===========================================
+
+// Ac_On: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_AC_ON = {
+    {0xB2, 0x4D, 0x1F, 0xE0, 0x14, 0xEB}, 2,
+    {0xD5, 0x65, 0x20, 0x01, 0x00, 0x5B}, 1
+};
+
+// Ac_Off: frame x2
+constexpr WhynterCommand WHYNTER_AC_OFF = {
+    {0xB2, 0x4D, 0x7B, 0x84, 0xE0, 0x1F}, 2,
+    {0}, 0
+};
+
+// Swing_on: frame x2
+constexpr WhynterCommand WHYNTER_SWING_ON = {
+    {0xB9, 0x46, 0xF5, 0x0A, 0x04, 0xFB}, 2,
+    {0}, 0
+};
+
+// Swing_off: frame x2
+constexpr WhynterCommand WHYNTER_SWING_OFF = {
+    {0xB9, 0x46, 0xF5, 0x0A, 0x05, 0xFA}, 2,
+    {0}, 0
+};
+
+// Mode_Auto: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_MODE_AUTO = {
+    {0xB2, 0x4D, 0x1F, 0xE0, 0x18, 0xE7}, 2,
+    {0xD5, 0x65, 0x20, 0x01, 0x00, 0x5B}, 1
+};
+
+// Mode_Cool: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_MODE_COOL = {
+    {0xB2, 0x4D, 0xBF, 0x40, 0x10, 0xEF}, 2,
+    {0xD5, 0x66, 0x20, 0x01, 0x00, 0x5C}, 1
+};
+
+// Mode_Dry: same signal as WHYNTER_AC_ON
+
+// Mode_Heat: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_MODE_HEAT = {
+    {0xB2, 0x4D, 0xBF, 0x40, 0x1C, 0xE3}, 2,
+    {0xD5, 0x66, 0x20, 0x01, 0x00, 0x5C}, 1
+};
+
+// Mode_Fan: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_MODE_FAN = {
+    {0xB2, 0x4D, 0xBF, 0x40, 0xE4, 0x1B}, 2,
+    {0xD5, 0x66, 0x00, 0x01, 0x00, 0x3C}, 1
+};
+
+// Fan_Low: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_FAN_LOW = {
+    {0xB2, 0x4D, 0x9F, 0x60, 0xE4, 0x1B}, 2,
+    {0xD5, 0x28, 0x00, 0x01, 0x00, 0xFE}, 1
+};
+
+// Fan_Med: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_FAN_MED = {
+    {0xB2, 0x4D, 0x5F, 0xA0, 0xE4, 0x1B}, 2,
+    {0xD5, 0x3C, 0x00, 0x01, 0x00, 0x12}, 1
+};
+
+// Fan_High: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_FAN_HIGH = {
+    {0xB2, 0x4D, 0x3F, 0xC0, 0xE4, 0x1B}, 2,
+    {0xD5, 0x64, 0x00, 0x01, 0x00, 0x3A}, 1
+};
+
+// Fan_Auto: same signal as WHYNTER_MODE_FAN
+
+// Cool_High: frame x2 + trailer
+constexpr WhynterCommand WHYNTER_COOL_HIGH = {
+    {0xB2, 0x4D, 0x3F, 0xC0, 0x10, 0xEF}, 2,
+    {0xD5, 0x64, 0x20, 0x01, 0x00, 0x5A}, 1
+};
+
+// Cool_Auto: same signal as WHYNTER_MODE_COOL
+
+// ===========================================
+// Named table
+// ===========================================
+
+constexpr IrSignal WHYNTER_SIGNALS[] = {
+    {"Ac_On", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_AC_ON, nullptr, 0, nullptr, 0, 0},
+    {"Ac_Off", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_AC_OFF, nullptr, 0, nullptr, 0, 0},
+    {"Swing_on", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_SWING_ON, nullptr, 0, nullptr, 0, 0},
+    {"Swing_off", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_SWING_OFF, nullptr, 0, nullptr, 0, 0},
+    {"Mode_Auto", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_AUTO, nullptr, 0, nullptr, 0, 0},
+    {"Mode_Cool", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_COOL, nullptr, 0, nullptr, 0, 0},
+    {"Mode_Dry", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_AC_ON, nullptr, 0, nullptr, 0, 0},
+    {"Mode_Heat", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_HEAT, nullptr, 0, nullptr, 0, 0},
+    {"Mode_Fan", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_FAN, nullptr, 0, nullptr, 0, 0},
+    {"Fan_Low", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_FAN_LOW, nullptr, 0, nullptr, 0, 0},
+    {"Fan_Med", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_FAN_MED, nullptr, 0, nullptr, 0, 0},
+    {"Fan_High", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_FAN_HIGH, nullptr, 0, nullptr, 0, 0},
+    {"Fan_Auto", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_FAN, nullptr, 0, nullptr, 0, 0},
+    {"Cool_High", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_COOL_HIGH, nullptr, 0, nullptr, 0, 0},
+    {"Cool_Auto", IR_SIGNAL_WHYNTER, 38000, 0.33f, &WHYNTER_MODE_COOL, nullptr, 0, nullptr, 0, 0},
+};
+
+constexpr size_t WHYNTER_SIGNAL_COUNT = sizeof(WHYNTER_SIGNALS) / sizeof(WHYNTER_SIGNALS[0]);
+
+// Case-insensitive lookup, nullptr if the name isn't in the table
+const IrSignal* whynterFindSignal(const char* name) {
+    for (size_t i = 0; i < WHYNTER_SIGNAL_COUNT; i++) {
+        if (strcasecmp(WHYNTER_SIGNALS[i].name, name) == 0) {
+            return &WHYNTER_SIGNALS[i];
+        }
+    }
+    return nullptr;
+}
+
+#endif // WHYNTER_CODES_H
@@ -0,0 +1,199 @@
+/*
+ * Whynter AC IR Protocol Encoder
+ *
+ * The Flipper Zero captures in Whynter.ir are ~300 raw timings per command,
+ * but every frame has the same shape (Coolix-style pulse distance coding):
+ *
+ *   header mark 4400 / space 4450
+ *   48 bits, MSB first: mark 520, then space 560 (0) or 1640 (1)
+ *   stop mark 520
+ *   5240 gap before the next frame
+ *
+ * A command is the 48-bit frame sent `repeats` times, optionally followed
+ * by a different 48-bit trailer frame (AC_ON and the mode/fan commands
+ * carry one, AC_OFF and swing don't). Storing just the payload bits makes
+ * each command 14 bytes instead of ~600, and the timings are synthesized
+ * at send time.
+ *
+ * The synthesized timings stay within ~10% (55 us) of every capture in
+ * Whynter.ir, which is capture jitter - IR receivers tolerate ~25%.
+ * whynterDecodeRaw() goes the other way, for captures from a receiver.
+ */
+
+#ifndef WHYNTER_PROTOCOL_H
+#define WHYNTER_PROTOCOL_H
+
+#include <Arduino.h>
+
+// ===========================================
+// Timing (microseconds, averaged from Whynter.ir)
+// ===========================================
+
+#define WHYNTER_FREQ_KHZ     38
+#define WHYNTER_HDR_MARK     4400
+#define WHYNTER_HDR_SPACE    4450
+#define WHYNTER_BIT_MARK     520
+#define WHYNTER_ZERO_SPACE   560
+#define WHYNTER_ONE_SPACE    1640
+#define WHYNTER_FRAME_GAP    5240
+
+#define WHYNTER_FRAME_BYTES  6
+#define WHYNTER_FRAME_BITS   (WHYNTER_FRAME_BYTES * 8)
+
+// Raw timings per frame: header (2) + bits (2 each) + stop mark + gap
+#define WHYNTER_FRAME_RAW_LEN (2 + 2 * WHYNTER_FRAME_BITS + 2)
+
+// Decoding accepts timings within this percentage of nominal
+#define WHYNTER_TOLERANCE_PERCENT 25
+
+// Longest command we encode: 3 repeats + trailer
+#define WHYNTER_MAX_FRAMES   4
+#define WHYNTER_MAX_RAW_LEN  (WHYNTER_MAX_FRAMES * WHYNTER_FRAME_RAW_LEN)
+
+// ===========================================
+// Command
+// ===========================================
+
+struct WhynterCommand {
+    uint8_t frame[WHYNTER_FRAME_BYTES];    // Command frame, MSB first
+    uint8_t repeats;                       // Times the command frame is sent
+    uint8_t trailer[WHYNTER_FRAME_BYTES];  // Extension frame sent after the repeats
+    uint8_t hasTrailer;
+};
+
+// ===========================================
+// Helpers
+// ===========================================
+
+static size_t _whynterAppendFrame(const uint8_t* frame, uint16_t* out, size_t pos) {
+    out[pos++] = WHYNTER_HDR_MARK;
+    out[pos++] = WHYNTER_HDR_SPACE;
+    for (int i = 0; i < WHYNTER_FRAME_BYTES; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            out[pos++] = WHYNTER_BIT_MARK;
+            out[pos++] = (frame[i] >> bit) & 1 ? WHYNTER_ONE_SPACE : WHYNTER_ZERO_SPACE;
+        }
+    }
+    out[pos++] = WHYNTER_BIT_MARK;
+    out[pos++] = WHYNTER_FRAME_GAP;
+    return pos;
+}
+
+static bool _whynterMatch(uint16_t value, uint16_t expected) {
+    uint32_t diff = value > expected ? value - expected : expected - value;
+    return diff * 100 <= (uint32_t)expected * WHYNTER_TOLERANCE_PERCENT;
+}
+
+// Decode one frame (header, 48 bits, stop mark) starting at raw[0]
+static bool _whynterDecodeFrame(const uint16_t* raw, size_t len, uint8_t* frame) {
+    if (len != 2 + 2 * WHYNTER_FRAME_BITS + 1) return false;
+    if (!_whynterMatch(raw[0], WHYNTER_HDR_MARK) || !_whynterMatch(raw[1], WHYNTER_HDR_SPACE)) {
+        return false;
+    }
+
+    memset(frame, 0, WHYNTER_FRAME_BYTES);
+    for (int i = 0; i < WHYNTER_FRAME_BITS; i++) {
+        uint16_t mark = raw[2 + 2 * i];
+        uint16_t space = raw[3 + 2 * i];
+        if (!_whynterMatch(mark, WHYNTER_BIT_MARK)) return false;
+        if (_whynterMatch(space, WHYNTER_ONE_SPACE)) {
+            frame[i / 8] |= 0x80 >> (i % 8);
+        } else if (!_whynterMatch(space, WHYNTER_ZERO_SPACE)) {
+            return false;
+        }
+    }
+    return _whynterMatch(raw[len - 1], WHYNTER_BIT_MARK);
+}
+
+// ===========================================
+// Number of frames a command transmits
+// ===========================================
+
+int whynterFrameCount(const WhynterCommand &cmd) {
+    return cmd.repeats + (cmd.hasTrailer ? 1 : 0);
+}
+
+// ===========================================
+// Synthesize mark/space timings for IRsend::sendRaw() or RMT encoding
+// Returns the number of timings written (ends on a mark, no trailing gap),
+// 0 if the buffer is too small
+// ===========================================
+
+size_t whynterEncodeRaw(const WhynterCommand &cmd, uint16_t* out, size_t maxLen) {
+    int frames = whynterFrameCount(cmd);
+    if (frames == 0 || (size_t)frames * WHYNTER_FRAME_RAW_LEN > maxLen) return 0;
+
+    size_t pos = 0;
+    for (int i = 0; i < cmd.repeats; i++) {
+        pos = _whynterAppendFrame(cmd.frame, out, pos);
+    }
+    if (cmd.hasTrailer) {
+        pos = _whynterAppendFrame(cmd.trailer, out, pos);
+    }
+
+    // Drop the gap after the last frame
+    return pos - 1;
+}
+
+// ===========================================
+// Decode captured mark/space timings back into a command
+// Returns false if the capture isn't a Whynter command (frames must be
+// one frame repeated, optionally followed by one different trailer)
+// ===========================================
+
+bool whynterDecodeRaw(const uint16_t* raw, size_t len, WhynterCommand &cmd) {
+    // The header space is close to the gap, so split halfway between them
+    const uint16_t gapThreshold = (WHYNTER_HDR_SPACE + WHYNTER_FRAME_GAP) / 2;
+
+    uint8_t frames[WHYNTER_MAX_FRAMES][WHYNTER_FRAME_BYTES];
+    int frameCount = 0;
+    size_t start = 0;
+    for (size_t i = 3; i <= len; i += 2) {
+        bool end = (i == len) || (i < len && raw[i] > gapThreshold);
+        if (!end) continue;
+        if (frameCount >= WHYNTER_MAX_FRAMES) return false;
+        if (!_whynterDecodeFrame(raw + start, i - start, frames[frameCount])) return false;
+        frameCount++;
+        start = i + 1;
+    }
+    if (frameCount == 0 || start < len) return false;
+
+    int repeats = 1;
+    while (repeats < frameCount && memcmp(frames[repeats], frames[0], WHYNTER_FRAME_BYTES) == 0) {
+        repeats++;
+    }
+    if (frameCount - repeats > 1) return false;
+
+    memcpy(cmd.frame, frames[0], WHYNTER_FRAME_BYTES);
+    cmd.repeats = repeats;
+    cmd.hasTrailer = (frameCount > repeats) ? 1 : 0;
+    if (cmd.hasTrailer) {
+        memcpy(cmd.trailer, frames[repeats], WHYNTER_FRAME_BYTES);
+    } else {
+        memset(cmd.trailer, 0, WHYNTER_FRAME_BYTES);
+    }
+    return true;
+}
+
+// ===========================================
+// Transmission time of a command in microseconds
+// ===========================================
+
+uint32_t whynterDurationUs(const WhynterCommand &cmd) {
+    uint32_t total = 0;
+    int frames = whynterFrameCount(cmd);
+    for (int f = 0; f < frames; f++) {
+        const uint8_t* frame = (f < cmd.repeats) ? cmd.frame : cmd.trailer;
+        total += WHYNTER_HDR_MARK + WHYNTER_HDR_SPACE + WHYNTER_BIT_MARK;
+        for (int i = 0; i < WHYNTER_FRAME_BYTES; i++) {
+            for (int bit = 7; bit >= 0; bit--) {
+                total += WHYNTER_BIT_MARK;
+                total += (frame[i] >> bit) & 1 ? WHYNTER_ONE_SPACE : WHYNTER_ZERO_SPACE;
+            }
+        }
+        if (f < frames - 1) total += WHYNTER_FRAME_GAP;
+    }
+    return total;
+}
+
+#endif // WHYNTER_PROTOCOL_H
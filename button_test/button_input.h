@@ -0,0 +1,177 @@
+/*
+ * Interrupt-driven Button Input
+ *
+ * Debounces one active-low button (e.g. BOOT on GPIO0) and decodes short,
+ * double and long presses without polling or delay() in loop():
+ *
+ *   - A GPIO interrupt on every edge (re)starts a one-shot esp_timer, so
+ *     the timer only fires once the line has been quiet for
+ *     BUTTON_DEBOUNCE_MS - bounces just push it out
+ *   - The timer callback reads the settled level and steps the gesture
+ *     decoder, then re-arms itself for the decoder's next deadline (long
+ *     press threshold, double press window)
+ *   - Decoded events go into a FreeRTOS queue; loop() drains it with
+ *     buttonTakeEvent()
+ *
+ * Nothing runs while the button is idle, so it can also wake the chip from
+ * light sleep: buttonPrepareSleep() before esp_light_sleep_start(),
+ * buttonWakeup() after it returns - the press that woke the chip is then
+ * decoded like any other.
+ *
+ * The gestures themselves are decoded by button_gesture.h, which has no
+ * hardware in it and is tested on a PC
+ * (scd41-co2-monitor-v3/host/button_gesture_test.cpp).
+ *
+ * Shared by scd41-co2-monitor-v3, whynter-ir-blaster and button_test -
+ * keep the copies identical.
+ *
+ * Usage:
+ *   1. buttonInit(pin, longMs, doubleMs) in setup()
+ *   2. while (buttonTakeEvent(event)) { ... } in loop()
+ */
+
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include "button_gesture.h"
+
+// ===========================================
+// Configuration
+// ===========================================
+
+// The line must be stable this long before a level counts
+#define BUTTON_DEBOUNCE_MS 30
+
+// Defaults for buttonInit()
+#define BUTTON_LONG_MS     1000
+#define BUTTON_DOUBLE_MS   300
+
+#define BUTTON_QUEUE_LEN   8
+
+// ===========================================
+// State
+// ===========================================
+
+static uint8_t _btnPin = 0;
+static ButtonGesture _btnGesture;
+static esp_timer_handle_t _btnTimer = nullptr;
+static QueueHandle_t _btnQueue = nullptr;
+static volatile uint32_t _btnEdges = 0;
+static uint32_t _btnEvents = 0;
+static uint32_t _btnDropped = 0;
+
+// ===========================================
+// Interrupt and timer
+// ===========================================
+
+static void _btnArm(uint32_t ms) {
+    esp_timer_stop(_btnTimer);
+    esp_timer_start_once(_btnTimer, (uint64_t)ms * 1000);
+}
+
+static void IRAM_ATTR _btnIsr() {
+    _btnEdges++;
+    esp_timer_stop(_btnTimer);
+    esp_timer_start_once(_btnTimer, BUTTON_DEBOUNCE_MS * 1000);
+}
+
+// Runs in the esp_timer task once the line has settled, or at a deadline
+static void _btnTimerCallback(void*) {
+    uint32_t now = millis();
+    bool pressed = digitalRead(_btnPin) == LOW;
+
+    ButtonEvent event = buttonGestureStep(_btnGesture, pressed, now);
+    if (event != BUTTON_NONE) {
+        if (xQueueSend(_btnQueue, &event, 0) == pdTRUE) {
+            _btnEvents++;
+        } else {
+            _btnDropped++;
+        }
+    }
+
+    uint32_t deadline;
+    if (buttonGestureDeadline(_btnGesture, deadline)) {
+        int32_t wait = (int32_t)(deadline - now);
+        _btnArm(wait > 0 ? wait : 1);
+    }
+}
+
+// ===========================================
+// Initialize - call in setup()
+// ===========================================
+
+bool buttonInit(uint8_t pin, uint32_t longMs = BUTTON_LONG_MS,
+                uint32_t doubleMs = BUTTON_DOUBLE_MS) {
+    _btnPin = pin;
+    buttonGestureInit(_btnGesture, longMs, doubleMs);
+    pinMode(pin, INPUT_PULLUP);
+
+    _btnQueue = xQueueCreate(BUTTON_QUEUE_LEN, sizeof(ButtonEvent));
+    esp_timer_create_args_t args = {};
+    args.callback = _btnTimerCallback;
+    args.name = "button";
+    if (!_btnQueue || esp_timer_create(&args, &_btnTimer) != ESP_OK) {
+        Serial.println("[Button] Init failed");
+        return false;
+    }
+
+    attachInterrupt(digitalPinToInterrupt(pin), _btnIsr, CHANGE);
+
+    // Held at boot - decode it like any other press
+    if (digitalRead(pin) == LOW) _btnArm(BUTTON_DEBOUNCE_MS);
+    return true;
+}
+
+// ===========================================
+// Events - call from loop()
+// ===========================================
+
+bool buttonTakeEvent(ButtonEvent &event) {
+    if (!_btnQueue) return false;
+    return xQueueReceive(_btnQueue, &event, 0) == pdTRUE;
+}
+
+// True when no gesture is in progress - a good time to sleep
+bool buttonIdle() {
+    return _btnGesture.state == BUTTON_G_IDLE && !_btnGesture.pressed;
+}
+
+// ===========================================
+// Light sleep
+// ===========================================
+
+// Arms a press as a light-sleep wake source. The wake level replaces the
+// pin's edge interrupt until buttonWakeup().
+void buttonPrepareSleep() {
+    gpio_wakeup_enable((gpio_num_t)_btnPin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+}
+
+// Back to edge interrupts, and sample the level in case it woke us
+void buttonWakeup() {
+    gpio_wakeup_disable((gpio_num_t)_btnPin);
+    gpio_set_intr_type((gpio_num_t)_btnPin, GPIO_INTR_ANYEDGE);
+    _btnArm(BUTTON_DEBOUNCE_MS);
+}
+
+// ===========================================
+// Stats
+// ===========================================
+
+void buttonPrintStats() {
+    Serial.print("Button: ");
+    Serial.print(_btnEdges);
+    Serial.print(" edges, ");
+    Serial.print(_btnEvents);
+    Serial.print(" events, ");
+    Serial.print(_btnDropped);
+    Serial.println(" dropped");
+}
+
+#endif // BUTTON_INPUT_H
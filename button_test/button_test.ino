@@ -1,16 +1,46 @@
+/*
+ * Button test - prints short / double / long presses decoded by
+ * button_input.h, and shows the button waking the chip from light sleep
+ * after LIGHT_SLEEP_IDLE_MS without a press.
+ */
+
+#include <Arduino.h>
+#include "button_input.h"
+
 #define BUTTON_PIN 0  // GPIO0 - built-in button on most ESP32 dev boards
 
+#define LIGHT_SLEEP_IDLE_MS 10000
+
+unsigned long lastActivity = 0;
+
 void setup() {
     Serial.begin(115200);
-    pinMode(BUTTON_PIN, INPUT_PULLUP);
-    
+    buttonInit(BUTTON_PIN);
+
     Serial.println();
-    Serial.println("Button test ready - press GPIO0 button");
+    Serial.println("Button test ready - press GPIO0 button (short / double / hold)");
+    lastActivity = millis();
 }
 
 void loop() {
-    if (digitalRead(BUTTON_PIN) == LOW) {
-        Serial.println("Button pressed!");
-        delay(200);  // simple debounce - wait before checking again
+    ButtonEvent event;
+    while (buttonTakeEvent(event)) {
+        Serial.print("Button: ");
+        Serial.println(buttonEventName(event));
+        lastActivity = millis();
+    }
+
+    // Sleep only between gestures, not in a double press window
+    if (millis() - lastActivity >= LIGHT_SLEEP_IDLE_MS && buttonIdle()) {
+        Serial.println("Light sleep - press the button to wake");
+        Serial.flush();
+        buttonPrepareSleep();
+        esp_light_sleep_start();
+        buttonWakeup();
+        Serial.println("Woke up");
+        buttonPrintStats();
+        lastActivity = millis();
     }
+
+    delay(10);
 }
@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+Generate a C++ command table from a Flipper Zero .ir file.
+
+Every signal in the file becomes a constexpr constant plus an entry in a
+named table that sketches can search by name:
+
+  - raw captures that decode as the Whynter protocol become a 14-byte
+    WhynterCommand (see whynter_protocol.h)
+  - other raw captures are kept as uint16_t timing arrays
+  - parsed signals (protocol/address/command) are kept as-is
+
+Signals that decode to the same frames (e.g. Mode_Dry and Ac_On) share
+one constant. Constants have internal linkage, so anything a sketch doesn't
+reference is dropped at compile time.
+
+    python3 flipper_ir_codegen.py Whynter.ir -o whynter_codes.h
+    python3 flipper_ir_codegen.py Whynter.ir -o whynter_codes.h --check
+
+Pass -o once per sketch that uses the table. An output file is only
+rewritten when its content changes, so running this before every build
+doesn't force a recompile. With --check
+nothing is written and the exit code is 1 if the header is out of date.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Whynter protocol timings (must match whynter_protocol.h)
+HDR_MARK = 4400
+HDR_SPACE = 4450
+BIT_MARK = 520
+ZERO_SPACE = 560
+ONE_SPACE = 1640
+FRAME_GAP = 5240
+FRAME_BITS = 48
+
+# A capture decodes if every timing is within this fraction of the protocol
+TOLERANCE = 0.25
+
+
+def parse_ir_file(path):
+    """Return (signals, errors). Each signal is a dict of the file's fields."""
+    signals = []
+    errors = []
+    current = None
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            if ":" not in line:
+                errors.append("%s:%d: expected 'key: value'" % (path, lineno))
+                continue
+            key, value = [part.strip() for part in line.split(":", 1)]
+            if key == "name":
+                current = {"name": value, "line": lineno}
+                signals.append(current)
+            elif current is None:
+                continue  # Filetype / Version header
+            elif key == "data":
+                # Long raw signals are split across several data lines
+                current.setdefault("data", []).extend(int(v) for v in value.split())
+            else:
+                current[key] = value
+    return signals, errors
+
+
+def matches(value, expected):
+    return abs(value - expected) <= expected * TOLERANCE
+
+
+def split_frames(timings):
+    """Split raw timings at the inter-frame gaps."""
+    # The header space is close to the gap, so split halfway between them
+    threshold = (HDR_SPACE + FRAME_GAP) // 2
+    frames = []
+    start = 0
+    for i in range(3, len(timings), 2):
+        if timings[i] > threshold:
+            frames.append(timings[start:i])
+            start = i + 1
+    frames.append(timings[start:])
+    return frames
+
+
+def decode_whynter_frame(frame):
+    """Return the 48-bit frame as 6 bytes, or None if it isn't Whynter."""
+    if len(frame) != 2 + 2 * FRAME_BITS + 1:
+        return None
+    if not matches(frame[0], HDR_MARK) or not matches(frame[1], HDR_SPACE):
+        return None
+
+    bits = []
+    for i in range(FRAME_BITS):
+        mark, space = frame[2 + 2 * i], frame[3 + 2 * i]
+        if not matches(mark, BIT_MARK):
+            return None
+        if matches(space, ONE_SPACE):
+            bits.append(1)
+        elif matches(space, ZERO_SPACE):
+            bits.append(0)
+        else:
+            return None
+    if not matches(frame[-1], BIT_MARK):
+        return None
+
+    return bytes(
+        int("".join(str(b) for b in bits[i:i + 8]), 2) for i in range(0, FRAME_BITS, 8)
+    )
+
+
+def decode_whynter(timings):
+    """Return (frame, repeats, trailer) or None if the capture isn't Whynter."""
+    frames = [decode_whynter_frame(f) for f in split_frames(timings)]
+    if not frames or any(f is None for f in frames):
+        return None
+
+    repeats = 1
+    while repeats < len(frames) and frames[repeats] == frames[0]:
+        repeats += 1
+    rest = frames[repeats:]
+    if len(rest) > 1:
+        return None
+    return frames[0], repeats, (rest[0] if rest else None)
+
+
+def c_ident(name):
+    ident = re.sub(r"[^0-9A-Za-z]+", "_", name).strip("_").upper()
+    if not ident or ident[0].isdigit():
+        ident = "_" + ident
+    return ident
+
+
+def hex_bytes(data):
+    return ", ".join("0x%02X" % b for b in data)
+
+
+def le_hex_value(value):
+    """Flipper stores address/command as little-endian hex bytes."""
+    data = bytes(int(b, 16) for b in value.split())
+    return int.from_bytes(data[:4], "little")
+
+
+def generate(path, prefix):
+    signals, errors = parse_ir_file(path)
+    if errors:
+        raise SystemExit("\n".join(errors))
+    if not signals:
+        raise SystemExit("%s: no signals found" % path)
+
+    source = os.path.basename(path)
+    guard = "%s_CODES_H" % prefix
+    func = "%sFindSignal" % prefix.lower()
+
+    constants = []   # Lines defining the signal data
+    entries = []     # Table entries
+    seen = {}        # Signal data -> constant name, to share duplicates
+    names = set()
+
+    for sig in signals:
+        name = sig["name"]
+        ident = "%s_%s" % (prefix, c_ident(name))
+        if ident in names:
+            raise SystemExit("%s:%d: duplicate name %s" % (path, sig["line"], name))
+        names.add(ident)
+
+        sig_type = sig.get("type")
+        freq = int(sig.get("frequency", "38000"))
+        duty = float(sig.get("duty_cycle", "0.33"))
+
+        if sig_type == "raw":
+            timings = sig.get("data", [])
+            decoded = decode_whynter(timings)
+            if decoded:
+                frame, repeats, trailer = decoded
+                key = ("whynter", frame, repeats, trailer)
+                if key not in seen:
+                    seen[key] = ident
+                    constants.append("// %s: frame x%d%s" % (name, repeats, " + trailer" if trailer else ""))
+                    constants.append("constexpr WhynterCommand %s = {" % ident)
+                    constants.append("    {%s}, %d," % (hex_bytes(frame), repeats))
+                    if trailer:
+                        constants.append("    {%s}, 1" % hex_bytes(trailer))
+                    else:
+                        constants.append("    {0}, 0")
+                    constants.append("};")
+                    constants.append("")
+                else:
+                    constants.append("// %s: same signal as %s" % (name, seen[key]))
+                    constants.append("")
+                entries.append('    {"%s", IR_SIGNAL_WHYNTER, %d, %.2ff, &%s, nullptr, 0, nullptr, 0, 0},'
+                               % (name, freq, duty, seen[key]))
+            else:
+                key = ("raw", tuple(timings))
+                raw_ident = seen.get(key, ident + "_RAW")
+                if key not in seen:
+                    seen[key] = raw_ident
+                    constants.append("// %s: not Whynter protocol, kept as raw timings" % name)
+                    constants.append("constexpr uint16_t %s[] = {" % raw_ident)
+                    for i in range(0, len(timings), 12):
+                        constants.append("    %s," % ", ".join(str(t) for t in timings[i:i + 12]))
+                    constants.append("};")
+                    constants.append("")
+                entries.append('    {"%s", IR_SIGNAL_RAW, %d, %.2ff, nullptr, %s, %d, nullptr, 0, 0},'
+                               % (name, freq, duty, raw_ident, len(timings)))
+        elif sig_type == "parsed":
+            protocol = sig.get("protocol", "")
+            address = le_hex_value(sig.get("address", "00"))
+            command = le_hex_value(sig.get("command", "00"))
+            entries.append('    {"%s", IR_SIGNAL_PARSED, %d, %.2ff, nullptr, nullptr, 0, "%s", 0x%X, 0x%X},'
+                           % (name, freq, duty, protocol, address, command))
+        else:
+            raise SystemExit("%s:%d: unknown signal type '%s'" % (path, sig["line"], sig_type))
+
+    out = []
+    out.append("/*")
+    out.append(" * IR command table generated from %s" % source)
+    out.append(" *")
+    out.append(" * DO NOT EDIT - regenerate with:")
+    out.append(" *   python3 flipper_ir_codegen.py %s -o %s" % (source, prefix.lower() + "_codes.h"))
+    out.append(" *")
+    out.append(" * Use a constant directly (%s_AC_ON) or look a signal up by" % prefix)
+    out.append(" * name with %s(\"Ac_On\"). Constants the sketch doesn't" % func)
+    out.append(" * reference are dropped by the compiler.")
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef %s" % guard)
+    out.append("#define %s" % guard)
+    out.append("")
+    out.append("#include <Arduino.h>")
+    out.append('#include "whynter_protocol.h"')
+    out.append("")
+    out.append("// ===========================================")
+    out.append("// Signal table entry (shared by all generated tables)")
+    out.append("// ===========================================")
+    out.append("")
+    out.append("#ifndef IR_SIGNAL_DEFINED")
+    out.append("#define IR_SIGNAL_DEFINED")
+    out.append("")
+    out.append("enum IrSignalKind : uint8_t {")
+    out.append("    IR_SIGNAL_WHYNTER = 0,  // Protocol frames, see whynter_protocol.h")
+    out.append("    IR_SIGNAL_RAW = 1,      // Raw mark/space timings")
+    out.append("    IR_SIGNAL_PARSED = 2    // Flipper parsed signal (protocol/address/command)")
+    out.append("};")
+    out.append("")
+    out.append("struct IrSignal {")
+    out.append("    const char* name;")
+    out.append("    IrSignalKind kind;")
+    out.append("    uint32_t frequency;")
+    out.append("    float dutyCycle;")
+    out.append("    const WhynterCommand* whynter;  // IR_SIGNAL_WHYNTER")
+    out.append("    const uint16_t* raw;            // IR_SIGNAL_RAW")
+    out.append("    uint16_t rawLength;")
+    out.append("    const char* protocol;           // IR_SIGNAL_PARSED")
+    out.append("    uint32_t address;")
+    out.append("    uint32_t command;")
+    out.append("};")
+    out.append("")
+    out.append("#endif // IR_SIGNAL_DEFINED")
+    out.append("")
+    out.append("// ===========================================")
+    out.append("// Signals")
+    out.append("// ===========================================")
+    out.append("")
+    out.extend(constants)
+    out.append("// ===========================================")
+    out.append("// Named table")
+    out.append("// ===========================================")
+    out.append("")
+    out.append("constexpr IrSignal %s_SIGNALS[] = {" % prefix)
+    out.extend(entries)
+    out.append("};")
+    out.append("")
+    out.append("constexpr size_t %s_SIGNAL_COUNT = sizeof(%s_SIGNALS) / sizeof(%s_SIGNALS[0]);"
+               % (prefix, prefix, prefix))
+    out.append("")
+    out.append("// Case-insensitive lookup, nullptr if the name isn't in the table")
+    out.append("const IrSignal* %s(const char* name) {" % func)
+    out.append("    for (size_t i = 0; i < %s_SIGNAL_COUNT; i++) {" % prefix)
+    out.append("        if (strcasecmp(%s_SIGNALS[i].name, name) == 0) {" % prefix)
+    out.append("            return &%s_SIGNALS[i];" % prefix)
+    out.append("        }")
+    out.append("    }")
+    out.append("    return nullptr;")
+    out.append("}")
+    out.append("")
+    out.append("#endif // %s" % guard)
+    return "\n".join(out) + "\n", len(signals), len(seen)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("ir_file", help="Flipper Zero .ir file")
+    parser.add_argument("-o", "--output", action="append", required=True,
+                        help="header to write (repeat for each sketch)")
+    parser.add_argument("--prefix", help="C identifier prefix (default: from the file name)")
+    parser.add_argument("--check", action="store_true", help="only verify the headers are up to date")
+    args = parser.parse_args()
+
+    prefix = args.prefix or c_ident(os.path.splitext(os.path.basename(args.ir_file))[0])
+    text, signal_count, unique_count = generate(args.ir_file, prefix)
+
+    stale = 0
+    for path in args.output:
+        old = None
+        if os.path.exists(path):
+            with open(path) as f:
+                old = f.read()
+        if old == text:
+            print("%s: up to date" % path)
+            continue
+        stale += 1
+        if args.check:
+            print("%s: OUT OF DATE" % path)
+            continue
+        with open(path, "w") as f:
+            f.write(text)
+        print("%s: %d signals (%d unique)" % (path, signal_count, unique_count))
+
+    return 1 if args.check and stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
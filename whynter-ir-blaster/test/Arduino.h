@@ -0,0 +1,10 @@
+// Just enough Arduino for whynter_protocol.h and whynter_codes.h on a PC
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,122 @@
+/*
+ * Host test for whynter_protocol.h against the Flipper captures
+ *
+ * For every raw signal in Whynter.ir, looks up the generated command by
+ * name and checks that:
+ *   - whynterEncodeRaw() gives as many timings as the capture, each within
+ *     TOLERANCE_PERCENT of the synthesized (nominal) value
+ *   - whynterDecodeRaw() turns the capture back into the same command
+ *
+ * Build and run from whynter-ir-blaster/:
+ *   g++ -std=c++17 -Wall -Itest -o test/whynter_test test/whynter_protocol_test.cpp && test/whynter_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "../whynter_protocol.h"
+#include "../whynter_codes.h"
+
+// Capture jitter is up to ~55 us; receivers accept ~25%
+#define TOLERANCE_PERCENT 10
+
+struct Capture {
+    std::string name;
+    std::vector<uint16_t> data;
+};
+
+// name: / data: pairs of the raw signals in a Flipper .ir file
+static std::vector<Capture> readCaptures(const char* path) {
+    std::vector<Capture> captures;
+    FILE* f = fopen(path, "r");
+    if (!f) return captures;
+
+    char line[4096];
+    std::string name;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "name: ", 6) == 0) {
+            name = line + 6;
+            name.erase(name.find_last_not_of("\r\n") + 1);
+        } else if (strncmp(line, "data: ", 6) == 0) {
+            Capture c;
+            c.name = name;
+            char* p = line + 6;
+            char* end;
+            for (long v = strtol(p, &end, 10); end != p; v = strtol(p, &end, 10)) {
+                c.data.push_back((uint16_t)v);
+                p = end;
+            }
+            captures.push_back(c);
+        }
+    }
+    fclose(f);
+    return captures;
+}
+
+static bool sameCommand(const WhynterCommand &a, const WhynterCommand &b) {
+    return memcmp(a.frame, b.frame, WHYNTER_FRAME_BYTES) == 0 && a.repeats == b.repeats &&
+           a.hasTrailer == b.hasTrailer &&
+           (!a.hasTrailer || memcmp(a.trailer, b.trailer, WHYNTER_FRAME_BYTES) == 0);
+}
+
+static bool checkCapture(const Capture &c) {
+    const IrSignal* signal = whynterFindSignal(c.name.c_str());
+    if (!signal || signal->kind != IR_SIGNAL_WHYNTER) {
+        printf("FAIL %-10s not a Whynter command in whynter_codes.h\n", c.name.c_str());
+        return false;
+    }
+
+    uint16_t raw[WHYNTER_MAX_RAW_LEN];
+    size_t len = whynterEncodeRaw(*signal->whynter, raw, WHYNTER_MAX_RAW_LEN);
+    if (len != c.data.size()) {
+        printf("FAIL %-10s %zu timings, capture has %zu\n", c.name.c_str(), len, c.data.size());
+        return false;
+    }
+
+    uint32_t worst = 0;
+    size_t worstAt = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint32_t diff = raw[i] > c.data[i] ? raw[i] - c.data[i] : c.data[i] - raw[i];
+        if (diff * 100 > (uint32_t)raw[i] * TOLERANCE_PERCENT) {
+            printf("FAIL %-10s timing %zu: %u us, capture %u us\n",
+                   c.name.c_str(), i, raw[i], c.data[i]);
+            return false;
+        }
+        if (diff > worst) {
+            worst = diff;
+            worstAt = i;
+        }
+    }
+
+    WhynterCommand decoded;
+    if (!whynterDecodeRaw(c.data.data(), c.data.size(), decoded)) {
+        printf("FAIL %-10s capture doesn't decode\n", c.name.c_str());
+        return false;
+    }
+    if (!sameCommand(decoded, *signal->whynter)) {
+        printf("FAIL %-10s capture decodes to a different command\n", c.name.c_str());
+        return false;
+    }
+
+    printf("ok   %-10s %3zu timings, worst %2u us (timing %zu)\n",
+           c.name.c_str(), len, worst, worstAt);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "Whynter.ir";
+    std::vector<Capture> captures = readCaptures(path);
+    if (captures.empty()) {
+        printf("No raw signals in %s\n", path);
+        return 1;
+    }
+
+    int failed = 0;
+    for (const Capture &c : captures) {
+        if (!checkCapture(c)) failed++;
+    }
+    printf("%zu signals, %d failed\n", captures.size(), failed);
+    return failed ? 1 : 0;
+}
@@ -5,7 +5,8 @@
  *   GPIO4 -> 100Ω resistor -> IR LED anode (long leg)
  *   IR LED cathode (short leg) -> GND
  * 
- * Press BOOT button (GPIO0) to send AC_On signal
+ * Press BOOT button (GPIO0) to cycle spamming AC_On / AC_Off / stopped,
+ * hold it to stop
  * 
  * Dependencies: IRremoteESP8266 library
  *   Install via Arduino Library Manager or PlatformIO
@@ -14,6 +15,8 @@
 #include <Arduino.h>
 #include <IRremoteESP8266.h>
 #include <IRsend.h>
+#include "whynter_codes.h"
+#include "button_input.h"
 
 // Pin definitions
 const uint16_t kIrLedPin = 4;      // GPIO4 for IR LED
@@ -22,56 +25,18 @@ const uint8_t kBootButtonPin = 0;  // GPIO0 is the BOOT button
 // IR sender instance
 IRsend irsend(kIrLedPin);
 
-// Whynter AC_On raw timing data (from Flipper Zero capture)
-// 38kHz carrier, timings in microseconds
-const uint16_t AC_ON_RAW[] = {
-  4384, 4450, 512, 1639, 516, 591, 486, 1641, 514, 1642, 512, 563, 514, 563, 514, 1640, 
-  514, 563, 514, 562, 515, 1639, 515, 564, 513, 563, 514, 1641, 514, 1641, 514, 563, 
-  514, 1640, 515, 563, 514, 562, 515, 562, 515, 1642, 513, 1641, 514, 1639, 516, 1638, 
-  516, 1640, 515, 1638, 518, 1639, 515, 1643, 565, 509, 515, 562, 515, 562, 515, 591, 
-  486, 562, 515, 562, 515, 562, 515, 562, 515, 1641, 514, 562, 515, 1641, 514, 563, 
-  514, 562, 515, 1668, 487, 1641, 514, 1641, 514, 562, 515, 1641, 567, 510, 514, 1641, 
-  514, 1642, 513, 5239, 
-  // Second burst (repeat)
-  4385, 4451, 512, 1640, 515, 563, 514, 1642, 565, 1588, 514, 562, 515, 562, 515, 1640, 
-  515, 562, 515, 562, 515, 1640, 515, 562, 515, 562, 515, 1640, 514, 1641, 567, 509, 
-  515, 1638, 517, 562, 515, 563, 514, 562, 515, 1639, 516, 1640, 515, 1640, 515, 1639, 
-  516, 1639, 516, 1641, 514, 1640, 515, 1640, 515, 562, 515, 562, 515, 563, 514, 562, 
-  515, 562, 515, 562, 515, 563, 514, 563, 514, 1641, 514, 562, 515, 1638, 516, 562, 
-  515, 563, 514, 1640, 515, 1640, 514, 1641, 514, 591, 486, 1639, 516, 563, 567, 1588, 
-  514, 1668, 487, 5240, 
-  // Third burst
-  4384, 4447, 516, 1668, 486, 1641, 514, 562, 515, 1669, 486, 563, 514, 1641, 514, 564, 
-  513, 1639, 516, 562, 515, 1641, 514, 1668, 487, 562, 515, 563, 514, 1640, 515, 562, 
-  515, 1639, 516, 563, 514, 563, 514, 1640, 515, 562, 515, 563, 568, 508, 516, 562, 
-  515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 562, 
-  515, 1639, 516, 562, 515, 562, 515, 562, 515, 562, 515, 562, 515, 563, 514, 563, 
-  514, 563, 514, 591, 486, 1639, 516, 562, 515, 1668, 487, 1640, 515, 562, 515, 1640, 
-  515, 1641, 514
-};
-const uint16_t AC_ON_RAW_LEN = sizeof(AC_ON_RAW) / sizeof(AC_ON_RAW[0]);
+// Whynter AC commands come from whynter_codes.h, generated from Whynter.ir
+// by flipper_ir_codegen.py. whynter_protocol.h synthesizes the timings.
 
-// AC_Off raw timing data
-const uint16_t AC_OFF_RAW[] = {
-  4379, 4477, 486, 1643, 512, 564, 513, 1669, 486, 1669, 486, 564, 514, 565, 512, 1639, 
-  569, 511, 513, 563, 514, 1641, 567, 510, 515, 565, 512, 1669, 539, 1588, 514, 591, 
-  486, 1640, 515, 562, 515, 1669, 486, 1641, 514, 1642, 513, 1643, 512, 564, 513, 1642, 
-  513, 1641, 514, 1642, 512, 564, 513, 563, 514, 564, 513, 591, 486, 1669, 486, 563, 
-  514, 563, 514, 1669, 486, 1641, 514, 1642, 513, 591, 486, 564, 514, 564, 513, 591, 
-  486, 564, 513, 591, 486, 564, 513, 563, 514, 1642, 513, 1642, 513, 1641, 514, 1641, 
-  514, 1640, 515, 5241, 
-  // Second burst
-  4385, 4449, 514, 1641, 514, 563, 514, 1640, 515, 1641, 514, 563, 514, 563, 514, 1644, 
-  511, 563, 514, 563, 514, 1641, 514, 562, 515, 563, 514, 1641, 514, 1640, 515, 563, 
-  514, 1641, 514, 564, 513, 1643, 512, 1643, 512, 1642, 513, 1640, 515, 563, 514, 1642, 
-  514, 1639, 516, 1642, 513, 563, 514, 563, 514, 563, 514, 565, 512, 1642, 513, 563, 
-  567, 509, 516, 1641, 514, 1668, 486, 1642, 513, 563, 514, 563, 514, 591, 486, 565, 
-  512, 562, 516, 562, 515, 562, 515, 563, 514, 1641, 514, 1641, 514, 1640, 514, 1641, 
-  514, 1642, 513
-};
-const uint16_t AC_OFF_RAW_LEN = sizeof(AC_OFF_RAW) / sizeof(AC_OFF_RAW[0]);
+// Raw timing buffer, filled right before each send
+uint16_t rawBuffer[WHYNTER_MAX_RAW_LEN];
 
-// Button state tracking for debounce
+void sendCommand(const WhynterCommand &cmd) {
+  size_t len = whynterEncodeRaw(cmd, rawBuffer, WHYNTER_MAX_RAW_LEN);
+  irsend.sendRaw(rawBuffer, len, WHYNTER_FREQ_KHZ);
+}
+
+// Spam state, stepped by the button
 bool spamming = false;
 bool acIsOn = false;
 
@@ -87,19 +52,20 @@ void setup() {
   Serial.println("=================================");
   Serial.println("Whynter AC IR Blaster");
   Serial.println("=================================");
-  Serial.println("Press BOOT to toggle spamming ON/OFF signals");
+  Serial.println("Press BOOT to toggle spamming ON/OFF signals, hold to stop");
   Serial.println();
   
   // Initialize IR sender
   irsend.begin();
   
-  // Initialize BOOT button with internal pullup
-  pinMode(kBootButtonPin, INPUT_PULLUP);
+  // BOOT button - interrupt driven, no double press so a press acts on release
+  buttonInit(kBootButtonPin, BUTTON_LONG_MS, 0);
   
   // Quick LED test - blink the IR LED (visible through phone camera)
   Serial.println("Testing IR LED - check with phone camera...");
+  size_t testLen = whynterEncodeRaw(WHYNTER_AC_ON, rawBuffer, WHYNTER_MAX_RAW_LEN);
   for (int i = 0; i < 5; i++) {
-    irsend.sendRaw(AC_ON_RAW, 10, 38);
+    irsend.sendRaw(rawBuffer, min(testLen, (size_t)10), WHYNTER_FREQ_KHZ);
     delay(200);
   }
   Serial.println("IR LED test complete.");
@@ -107,11 +73,13 @@ void setup() {
 }
 
 void loop() {
-  // Simple button check (same pattern that works in your test)
-  if (digitalRead(kBootButtonPin) == LOW) {
-    Serial.println("Button pressed!");
-    
-    if (!spamming) {
+  // Button events are debounced and decoded in the background
+  ButtonEvent event;
+  while (buttonTakeEvent(event)) {
+    if (event == BUTTON_LONG) {
+      spamming = false;
+      Serial.println(">>> STOPPED (held)");
+    } else if (!spamming) {
       spamming = true;
       acIsOn = true;
       Serial.println(">>> SPAMMING AC ON - press again to switch to OFF");
@@ -123,17 +91,15 @@ void loop() {
       Serial.println(">>> STOPPED");
     }
     Serial.println();
-    
-    delay(300);  // Simple debounce
   }
   
   // Spam the signal if active
   if (spamming && (millis() - lastSpamTime) >= spamInterval) {
     if (acIsOn) {
-      irsend.sendRaw(AC_ON_RAW, AC_ON_RAW_LEN, 38);
+      sendCommand(WHYNTER_AC_ON);
       Serial.println("ON!");
     } else {
-      irsend.sendRaw(AC_OFF_RAW, AC_OFF_RAW_LEN, 38);
+      sendCommand(WHYNTER_AC_OFF);
       Serial.println("OFF!");
     }
     lastSpamTime = millis();